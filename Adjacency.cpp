@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////
+//* Filename: Adjacency.cpp                           //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Adjacency.h"
+#include "Hash.h"
+#include <algorithm>
+
+//An undirected edge's slot in the hash, with the first half edge found for it
+struct EdgeSlot
+{
+  unsigned long long key_;
+  int first_;
+};
+
+static unsigned long long EdgeKey(unsigned a, unsigned b)
+{
+  if(a > b)
+    std::swap(a, b);
+  return (static_cast<unsigned long long>(a) << 32) | b;
+}
+
+void BuildEdges(const int* indices, unsigned indexCount, const unsigned* weldIds, MeshEdges& edges)
+{
+  unsigned halfCount = indexCount / 3 * 3;
+  edges.twins_.assign(halfCount, -1);
+  edges.flags_.assign(halfCount, 0);
+  edges.edgeCount_ = 0;
+  edges.boundaryCount_ = 0;
+  edges.nonManifoldCount_ = 0;
+  if(!halfCount)
+    return;
+
+  //Twice as many slots as half edges keeps the probe runs short
+  unsigned slotCount = 1;
+  while(slotCount < halfCount * 2)
+    slotCount *= 2;
+  std::vector<EdgeSlot> slots(slotCount);
+  for(unsigned s = 0; s < slotCount; ++s)
+    slots[s].first_ = -1;
+
+  //Half edges of the same undirected edge are chained from its slot
+  std::vector<int> next(halfCount, -1);
+  std::vector<int> chains;
+  for(unsigned h = 0; h < halfCount; ++h)
+  {
+    unsigned a = weldIds[indices[h]];
+    unsigned b = weldIds[indices[h / 3 * 3 + (h % 3 + 1) % 3]];
+    if(a == b)
+    {
+      edges.flags_[h] = EdgeDegenerate;
+      continue;
+    }
+
+    unsigned long long key = EdgeKey(a, b);
+    unsigned s = static_cast<unsigned>(HashBytes(&key, sizeof(key))) & (slotCount - 1);
+    while(slots[s].first_ >= 0 && slots[s].key_ != key)
+      s = (s + 1) & (slotCount - 1);
+
+    if(slots[s].first_ < 0)
+    {
+      slots[s].key_ = key;
+      chains.push_back(s);
+    }
+    else
+      next[h] = slots[s].first_;
+    slots[s].first_ = h;
+  }
+
+  //Two half edges running opposite ways are a manifold edge, anything else gets flagged
+  edges.edgeCount_ = chains.size();
+  for(unsigned c = 0; c < chains.size(); ++c)
+  {
+    int first = slots[chains[c]].first_;
+    int second = next[first];
+    if(second < 0)
+    {
+      edges.flags_[first] = EdgeBoundary;
+      ++edges.boundaryCount_;
+      continue;
+    }
+
+    unsigned firstStart = weldIds[indices[first]];
+    unsigned secondStart = weldIds[indices[second]];
+    if(next[second] < 0 && firstStart != secondStart)
+    {
+      edges.twins_[first] = second;
+      edges.twins_[second] = first;
+      continue;
+    }
+
+    for(int h = first; h >= 0; h = next[h])
+      edges.flags_[h] = EdgeNonManifold;
+    ++edges.nonManifoldCount_;
+  }
+}
+
+void BuildAdjacencyIndices(const int* indices, unsigned indexCount, const MeshEdges& edges, std::vector<int>& adjacency)
+{
+  unsigned triCount = indexCount / 3;
+  adjacency.resize(triCount * 6);
+  for(unsigned t = 0; t < triCount; ++t)
+  {
+    for(unsigned e = 0; e < 3; ++e)
+    {
+      unsigned h = t * 3 + e;
+      int twin = edges.twins_[h];
+
+      //The corner of the other triangle that isn't on the edge
+      int across;
+      if(twin >= 0)
+        across = indices[twin / 3 * 3 + (twin % 3 + 2) % 3];
+      else
+        across = indices[t * 3 + (e + 2) % 3];
+
+      adjacency[t * 6 + e * 2] = indices[h];
+      adjacency[t * 6 + e * 2 + 1] = across;
+    }
+  }
+}
@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////
+//* Filename: Adjacency.h                             //
+//  Author: Colt Johnson                              //
+//  Info: Edge connectivity of triangle lists for     //
+//        silhouettes and shadow volumes.             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+
+  //What BuildEdges found out about a half edge
+  enum EdgeFlag
+  {
+    //No other triangle has the edge
+    EdgeBoundary    = 1,
+    //Three or more triangles share the edge, or two that wind it the same way
+    EdgeNonManifold = 2,
+    //Both ends weld to the same vertex
+    EdgeDegenerate  = 4
+  };
+
+  //Half edge t * 3 + e runs from corner e of triangle t to corner (e + 1) % 3
+  struct MeshEdges
+  {
+    //The half edge going the other way in the neighbouring triangle, -1 when
+    //the edge is flagged
+    std::vector<int> twins_;
+    std::vector<unsigned char> flags_;
+
+    //Undirected edges, and how many of them are flagged
+    unsigned edgeCount_;
+    unsigned boundaryCount_;
+    unsigned nonManifoldCount_;
+  };
+
+  //Pairs up the half edges of indexCount / 3 triangles by the weld ids of their
+  //ends (vertices split on a seam share an id so the seam doesn't count as a
+  //boundary). One pass through an open addressed edge hash, linear in the
+  //number of triangles.
+  void BuildEdges(const int* indices, unsigned indexCount, const unsigned* weldIds, MeshEdges& edges);
+
+  //Six indices per triangle in the order triangle list with adjacency expects:
+  //corner 0, the vertex across edge 0, corner 1, across edge 1, corner 2, across
+  //edge 2. Flagged edges use the triangle's own opposite corner instead.
+  void BuildAdjacencyIndices(const int* indices, unsigned indexCount, const MeshEdges& edges, std::vector<int>& adjacency);
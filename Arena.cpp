@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////
+//* Filename: Arena.cpp                               //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Arena.h"
+
+Arena::Arena(size_t blockSize) : cur_(NULL), end_(NULL), blockSize_(blockSize), used_(0)
+{
+}
+
+Arena::~Arena(void)
+{
+  Reset();
+}
+
+void* Arena::Allocate(size_t size, size_t align)
+{
+  size_t pad = (align - reinterpret_cast<size_t>(cur_) % align) % align;
+  if(!cur_ || pad + size > static_cast<size_t>(end_ - cur_))
+  {
+    //Anything bigger than a block gets a block of its own
+    size_t blockSize = size + align > blockSize_ ? size + align : blockSize_;
+    char *block = static_cast<char*>(::operator new(blockSize));
+    blocks_.push_back(block);
+    cur_ = block;
+    end_ = block + blockSize;
+    pad = (align - reinterpret_cast<size_t>(cur_) % align) % align;
+  }
+
+  void *data = cur_ + pad;
+  cur_ += pad + size;
+  used_ += size;
+  return data;
+}
+
+void Arena::Reset(void)
+{
+  for(unsigned i = 0; i < blocks_.size(); ++i)
+    ::operator delete(blocks_[i]);
+
+  blocks_.clear();
+  cur_ = end_ = NULL;
+  used_ = 0;
+}
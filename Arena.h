@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////
+//* Filename: Arena.h                                 //
+//  Author: Colt Johnson                              //
+//  Info: Bump allocator for the short lived arrays   //
+//        made while processing one mesh.             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+  //Hands out memory from large blocks. Nothing is freed on its own, all of it
+  //goes at once when the arena is reset or destroyed.
+  class Arena
+  {
+    public:
+      explicit Arena(size_t blockSize = 1 << 20);
+      ~Arena(void);
+
+      void* Allocate(size_t size, size_t align);
+      void Reset(void);
+
+      //Bytes handed out since the last reset
+      size_t BytesUsed(void) const { return used_; }
+
+    private:
+      Arena(const Arena&);
+      Arena& operator=(const Arena&);
+
+      std::vector<char*> blocks_;
+      char *cur_;
+      char *end_;
+      size_t blockSize_;
+      size_t used_;
+  };
+
+  //Lets std::vector live in an arena. Without an arena it falls back to the heap,
+  //and the arena goes along with the contents on assignment and swap.
+  template<typename type>
+  struct ArenaAllocator
+  {
+    typedef type value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    Arena *arena_;
+
+    ArenaAllocator(Arena *arena = NULL) : arena_(arena) {}
+    template<typename other>
+    ArenaAllocator(const ArenaAllocator<other>& rhs) : arena_(rhs.arena_) {}
+
+    type* allocate(size_t count)
+    {
+      if(arena_)
+        return static_cast<type*>(arena_->Allocate(sizeof(type) * count, std::alignment_of<type>::value));
+      return static_cast<type*>(::operator new(sizeof(type) * count));
+    }
+
+    void deallocate(type *data, size_t)
+    {
+      if(!arena_)
+        ::operator delete(data);
+    }
+  };
+
+  template<typename a, typename b>
+  bool operator==(const ArenaAllocator<a>& lhs, const ArenaAllocator<b>& rhs) { return lhs.arena_ == rhs.arena_; }
+  template<typename a, typename b>
+  bool operator!=(const ArenaAllocator<a>& lhs, const ArenaAllocator<b>& rhs) { return lhs.arena_ != rhs.arena_; }
+
+  template<typename type>
+  using ArenaVector = std::vector<type, ArenaAllocator<type> >;
@@ -0,0 +1,753 @@
+////////////////////////////////////////////////////////
+//* Filename: Batch.cpp                               //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Batch.h"
+#include "ConvertApi.h"
+#include "Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+  #define NOMINMAX
+  #define WIN32_LEAN_AND_MEAN
+  #include <Windows.h>
+#else
+  #include <dirent.h>
+  #include <spawn.h>
+  #include <sys/wait.h>
+  #include <unistd.h>
+  #include <utime.h>
+  #include <cerrno>
+  extern char **environ;
+#endif
+
+//How often idle workers look for jobs to claim or steal
+const unsigned BatchPollMs = 1000;
+
+struct BatchSettings
+{
+  std::string manifest_;
+  std::string queueDir_;
+  //Processes to start, 0 runs this process as the only worker
+  unsigned workers_;
+  //Seconds a lock can go without being renewed before its job is run again
+  unsigned leaseSeconds_;
+  //Times a job is run again after the worker running it died
+  unsigned retries_;
+  //The command line the workers get, the same one without -workers
+  std::vector<std::string> workerArgs_;
+  ConvertOptions options_;
+};
+
+struct BatchJob
+{
+  std::string input_;
+  //job_N_HASH, the hash keeps a queue from matching an edited manifest
+  std::string name_;
+};
+
+static std::string JobPath(const BatchSettings& settings, const BatchJob& job, const char *extension)
+{
+  return settings.queueDir_ + "/" + job.name_ + extension;
+}
+
+static bool FileExists(const std::string& path)
+{
+  struct stat info;
+  return !stat(path.c_str(), &info);
+}
+
+//Seconds since the file last changed, false if it isn't there
+static bool FileAge(const std::string& path, double& seconds)
+{
+  struct stat info;
+  if(stat(path.c_str(), &info))
+    return false;
+  seconds = difftime(time(NULL), info.st_mtime);
+  return true;
+}
+
+static bool ReadText(const std::string& path, std::string& text)
+{
+  FILE *fp = fopen(path.c_str(), "rb");
+  if(!fp)
+    return false;
+  text.clear();
+  char buffer[4096];
+  size_t read;
+  while((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    text.append(buffer, read);
+  fclose(fp);
+  return true;
+}
+
+//Writes text to a temp file next to path, returns its name or an empty string
+static std::string WriteTemp(const std::string& path, const std::string& text)
+{
+  std::string tempPath = TempPathFor(path);
+  FILE *fp = fopen(tempPath.c_str(), "wb");
+  if(!fp)
+    return std::string();
+  bool written = text.empty() || fwrite(text.data(), text.size(), 1, fp) == 1;
+  if(fclose(fp) || !written)
+  {
+    remove(tempPath.c_str());
+    return std::string();
+  }
+  return tempPath;
+}
+
+//Replaces path with text in one step
+static bool WriteFileAtomic(const std::string& path, const std::string& text)
+{
+  std::string tempPath = WriteTemp(path, text);
+  return !tempPath.empty() && MoveIntoPlace(tempPath, path);
+}
+
+//Moves from to path unless something is already there, from stays put if not
+static bool MoveExclusive(const std::string& from, const std::string& path)
+{
+#ifdef _WIN32
+  //Without MOVEFILE_REPLACE_EXISTING the move fails when path exists
+  return MoveFileA(from.c_str(), path.c_str()) != 0;
+#else
+  //link is atomic and exclusive, on NFS too where O_EXCL hasn't always been
+  if(link(from.c_str(), path.c_str()))
+    return false;
+  remove(from.c_str());
+  return true;
+#endif
+}
+
+//Creates path holding text unless something is already there. The text is
+//written aside and moved in, so nobody ever reads a half written lock.
+static bool PlaceExclusive(const std::string& path, const std::string& text)
+{
+  std::string tempPath = WriteTemp(path, text);
+  if(tempPath.empty())
+    return false;
+  if(MoveExclusive(tempPath, path))
+    return true;
+  remove(tempPath.c_str());
+  return false;
+}
+
+static bool MakeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+  return CreateDirectoryA(path.c_str(), NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+  return !mkdir(path.c_str(), 0777) || errno == EEXIST;
+#endif
+}
+
+//Sets the file's modified time to now, which is what renews a lease
+static bool TouchFile(const std::string& path)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            NULL, OPEN_EXISTING, 0, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    return false;
+  FILETIME now;
+  GetSystemTimeAsFileTime(&now);
+  bool touched = SetFileTime(file, NULL, NULL, &now) != 0;
+  CloseHandle(file);
+  return touched;
+#else
+  return !utime(path.c_str(), NULL);
+#endif
+}
+
+//Counts the files in dir whose names start with prefix
+static unsigned CountFiles(const std::string& dir, const std::string& prefix)
+{
+  unsigned count = 0;
+#ifdef _WIN32
+  WIN32_FIND_DATAA found;
+  HANDLE find = FindFirstFileA((dir + "/" + prefix + "*").c_str(), &found);
+  if(find == INVALID_HANDLE_VALUE)
+    return 0;
+  do
+    ++count;
+  while(FindNextFileA(find, &found));
+  FindClose(find);
+#else
+  DIR *listing = opendir(dir.c_str());
+  if(!listing)
+    return 0;
+  while(dirent *entry = readdir(listing))
+  {
+    if(!strncmp(entry->d_name, prefix.c_str(), prefix.size()))
+      ++count;
+  }
+  closedir(listing);
+#endif
+  return count;
+}
+
+//host_pid, unique among every worker sharing the queue and safe in a file name
+static std::string WorkerName(void)
+{
+  char host[256] = "local";
+  char name[300];
+#ifdef _WIN32
+  DWORD size = sizeof(host);
+  GetComputerNameA(host, &size);
+  sprintf(name, "%s_%lu", host, GetCurrentProcessId());
+#else
+  gethostname(host, sizeof(host));
+  host[sizeof(host) - 1] = 0;
+  sprintf(name, "%s_%d", host, static_cast<int>(getpid()));
+#endif
+  for(char *c = name; *c; ++c)
+  {
+    if(*c == '/' || *c == '\\' || *c == ':' || *c == ' ')
+      *c = '-';
+  }
+  return name;
+}
+
+static void AppendString(std::string& out, const std::string& text)
+{
+  out += '"';
+  for(unsigned i = 0; i < text.size(); ++i)
+  {
+    unsigned char c = text[i];
+    char escaped[8];
+    if(c == '"' || c == '\\')
+    {
+      out += '\\';
+      out += c;
+    }
+    else if(c < 0x20)
+    {
+      sprintf(escaped, "\\u%04x", c);
+      out += escaped;
+    }
+    else
+      out += c;
+  }
+  out += '"';
+}
+
+static bool LoadManifest(const std::string& path, std::vector<BatchJob>& jobs)
+{
+  std::string text;
+  if(!ReadText(path, text))
+  {
+    printf("Couldn't read the manifest %s!\n", path.c_str());
+    return false;
+  }
+
+  size_t start = 0;
+  while(start < text.size())
+  {
+    size_t end = text.find('\n', start);
+    if(end == std::string::npos)
+      end = text.size();
+    std::string line = text.substr(start, end - start);
+    start = end + 1;
+
+    size_t first = line.find_first_not_of(" \t\r");
+    if(first == std::string::npos || line[first] == '#')
+      continue;
+    line = line.substr(first, line.find_last_not_of(" \t\r") + 1 - first);
+
+    BatchJob job;
+    job.input_ = line;
+    char name[64];
+    sprintf(name, "job_%05u_%016llx", static_cast<unsigned>(jobs.size()), HashBytes(line.data(), line.size()));
+    job.name_ = name;
+    jobs.push_back(job);
+  }
+  return true;
+}
+
+//Renews a job's lease from its own thread for as long as it lives, so a
+//conversion may take any time at all while a dead worker is noticed quickly
+class LeaseKeeper
+{
+  public:
+    LeaseKeeper(const std::string& lockPath, const std::string& lockText, unsigned leaseSeconds)
+      : lockPath_(lockPath), lockText_(lockText), stop_(false)
+    {
+      unsigned intervalMs = std::max(leaseSeconds * 1000 / 4, 100u);
+      thread_ = std::thread(&LeaseKeeper::Renew, this, intervalMs);
+    }
+    ~LeaseKeeper(void)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      wake_.notify_one();
+      thread_.join();
+    }
+
+  private:
+    void Renew(unsigned intervalMs)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while(!wake_.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]{ return stop_; }))
+      {
+        //Lost it to a worker that thought this one dead, leave its lock alone.
+        //Jobs only ever write the same outputs, so finishing is still fine. A
+        //missing lock may just be another worker checking it, try again later.
+        std::string text;
+        if(ReadText(lockPath_, text) && text != lockText_)
+        {
+          printf("Lost the lease on %s, another worker is running it too\n", lockPath_.c_str());
+          return;
+        }
+        TouchFile(lockPath_);
+      }
+    }
+
+    std::string lockPath_;
+    std::string lockText_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+
+    LeaseKeeper(const LeaseKeeper&);
+    LeaseKeeper& operator=(const LeaseKeeper&);
+};
+
+static std::string LockText(const std::string& worker, unsigned attempt)
+{
+  char text[32];
+  sprintf(text, " %u\n", attempt);
+  return worker + text;
+}
+
+//Every report starts the same way, MergeReports counts on "ok" coming first
+static std::string ReportStart(const BatchJob& job, bool ok)
+{
+  std::string report = ok ? "{\"ok\": true, \"job\": " : "{\"ok\": false, \"job\": ";
+  AppendString(report, job.name_);
+  report += ", \"input\": ";
+  AppendString(report, job.input_);
+  return report;
+}
+
+//A job whose worker died on every attempt is done, as a failure
+static void GiveUp(const BatchSettings& settings, const BatchJob& job, unsigned attempts)
+{
+  printf("Giving up on %s, its worker died on all %u attempts\n", job.input_.c_str(), attempts);
+  char error[96];
+  sprintf(error, ", \"error\": \"worker died on all %u attempts\", \"attempts\": %u}\n", attempts, attempts);
+  WriteFileAtomic(JobPath(settings, job, ".done"), ReportStart(job, false) + error);
+}
+
+//Moves a job's lock to a name of the worker's own so it can be looked at
+//without anyone renewing, replacing or removing it in the meantime. Returns
+//the new name, or an empty string if there was no lock.
+static std::string MoveLockAside(const std::string& lockPath, const std::string& worker)
+{
+  //Unique across threads and processes, two workers may move the same lock
+  std::string asidePath = TempPathFor(lockPath + ".aside." + worker);
+  if(rename(lockPath.c_str(), asidePath.c_str()))
+    return std::string();
+  return asidePath;
+}
+
+//Returns a lock MoveLockAside took to its place. Should a new lock have been
+//made in between, that one wins and the owner of this one loses the job.
+static void PutLockBack(const std::string& asidePath, const std::string& lockPath)
+{
+  if(!MoveExclusive(asidePath, lockPath))
+    remove(asidePath.c_str());
+}
+
+//Returns the attempt number if the worker now holds the job's lock, 0 if
+//another worker has it or it is done
+static unsigned ClaimJob(const BatchSettings& settings, const BatchJob& job, const std::string& worker)
+{
+  std::string lockPath = JobPath(settings, job, ".lock");
+  std::string diedPrefix = job.name_ + ".died.";
+  for(unsigned tries = 0; tries < 2; ++tries)
+  {
+    if(FileExists(JobPath(settings, job, ".done")))
+      return 0;
+
+    //Every dead worker left its lock behind under a .died name
+    unsigned died = CountFiles(settings.queueDir_, diedPrefix);
+    if(died > settings.retries_)
+    {
+      GiveUp(settings, job, died);
+      return 0;
+    }
+    if(PlaceExclusive(lockPath, LockText(worker, died + 1)))
+      return died + 1;
+
+    double age;
+    std::string owner;
+    if(!FileAge(lockPath, age) || age <= settings.leaseSeconds_ || !ReadText(lockPath, owner))
+      return 0;
+
+    //The owner stopped renewing. Only one of the workers noticing gets to
+    //move the lock aside, but another may have replaced it with a live one
+    //since it was checked, so it is checked again where nobody else sees it.
+    std::string asidePath = MoveLockAside(lockPath, worker);
+    if(asidePath.empty())
+      return 0;
+    std::string text;
+    if(!FileAge(asidePath, age) || age <= settings.leaseSeconds_ || !ReadText(asidePath, text) || text != owner)
+    {
+      PutLockBack(asidePath, lockPath);
+      return 0;
+    }
+
+    //Kept under a .died name, they are what counts the attempts
+    std::string diedPath = settings.queueDir_ + "/" + diedPrefix + asidePath.substr(asidePath.find(".aside.") + 7);
+    if(rename(asidePath.c_str(), diedPath.c_str()))
+    {
+      PutLockBack(asidePath, lockPath);
+      return 0;
+    }
+    printf("%s went %.0f seconds without renewing its lease, running it again\n", job.input_.c_str(), age);
+  }
+  return 0;
+}
+
+static void RunJob(const BatchSettings& settings, const BatchJob& job, const std::string& worker, unsigned attempt)
+{
+  printf("%s: converting %s (attempt %u)\n", worker.c_str(), job.input_.c_str(), attempt);
+  std::string lockPath = JobPath(settings, job, ".lock");
+
+  ConvertResult result;
+  bool ok;
+  double ms;
+  {
+    LeaseKeeper keeper(lockPath, LockText(worker, attempt), settings.leaseSeconds_);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ok = ConvertFile(job.input_.c_str(), settings.options_, result) && SaveOutputs(result);
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  char numbers[128];
+  std::string report = ReportStart(job, ok);
+  if(!ok)
+    report += ", \"error\": \"conversion failed\"";
+  report += ", \"worker\": ";
+  AppendString(report, worker);
+  sprintf(numbers, ", \"attempt\": %u, \"ms\": %.3f, \"outputs\": [", attempt, ms);
+  report += numbers;
+  for(unsigned f = 0; f < result.files_.size(); ++f)
+  {
+    report += f ? ", {\"name\": " : "{\"name\": ";
+    AppendString(report, result.files_[f].name_);
+    sprintf(numbers, ", \"bytes\": %lu}", static_cast<unsigned long>(result.files_[f].data_.size()));
+    report += numbers;
+  }
+  report += "], \"stages\": {";
+  for(unsigned s = 0; s < result.timings_.size(); ++s)
+  {
+    if(s)
+      report += ", ";
+    AppendString(report, result.timings_[s].name_);
+    sprintf(numbers, ": %.3f", result.timings_[s].ms_);
+    report += numbers;
+  }
+  report += "}}\n";
+
+  //A failed conversion is done too, running it again would fail the same way.
+  //The lock goes last so a crash in between only costs a repeat, and only if
+  //it is still this worker's, a lost lease leaves the new owner's alone.
+  if(!WriteFileAtomic(JobPath(settings, job, ".done"), report))
+    printf("Couldn't write the report for %s!\n", job.input_.c_str());
+  std::string asidePath = MoveLockAside(lockPath, worker);
+  std::string text;
+  if(!asidePath.empty())
+  {
+    if(ReadText(asidePath, text) && text == LockText(worker, attempt))
+      remove(asidePath.c_str());
+    else
+      PutLockBack(asidePath, lockPath);
+  }
+}
+
+//Gathers every job's report into report.json. Returns false if a job isn't
+//done yet, counts the failures into failed.
+static bool MergeReports(const BatchSettings& settings, const std::vector<BatchJob>& jobs, unsigned& failed)
+{
+  std::string results;
+  failed = 0;
+  for(unsigned j = 0; j < jobs.size(); ++j)
+  {
+    std::string text;
+    if(!ReadText(JobPath(settings, jobs[j], ".done"), text))
+      return false;
+    while(!text.empty() && (text[text.size() - 1] == '\n' || text[text.size() - 1] == '\r'))
+      text.erase(text.size() - 1);
+    if(text.compare(0, 12, "{\"ok\": true,"))
+      ++failed;
+    results += j ? ",\n  " : "\n  ";
+    results += text;
+  }
+
+  std::string report = "{\"manifest\": ";
+  AppendString(report, settings.manifest_);
+  char counts[128];
+  sprintf(counts, ", \"jobs\": %u, \"succeeded\": %u, \"failed\": %u, \"results\": [",
+          static_cast<unsigned>(jobs.size()), static_cast<unsigned>(jobs.size()) - failed, failed);
+  report += counts + results + "\n]}\n";
+
+  //Every worker finishing may merge, they all write the same thing
+  std::string reportPath = settings.queueDir_ + "/report.json";
+  if(!WriteFileAtomic(reportPath, report))
+  {
+    printf("Couldn't write %s!\n", reportPath.c_str());
+    return false;
+  }
+  printf("Batch done: %u of %u converted, report in %s\n", static_cast<unsigned>(jobs.size()) - failed,
+         static_cast<unsigned>(jobs.size()), reportPath.c_str());
+  return true;
+}
+
+static int FinishBatch(const BatchSettings& settings, const std::vector<BatchJob>& jobs)
+{
+  unsigned failed;
+  if(!MergeReports(settings, jobs, failed))
+    return 1;
+  return failed ? 1 : 0;
+}
+
+static int RunWorker(const BatchSettings& settings, const std::vector<BatchJob>& jobs)
+{
+  std::string worker = WorkerName();
+
+  //Workers start at different jobs so they don't all race for the same locks
+  unsigned first = static_cast<unsigned>(HashBytes(worker.data(), worker.size()) % jobs.size());
+  for(;;)
+  {
+    unsigned pending = 0;
+    bool worked = false;
+    for(unsigned i = 0; i < jobs.size(); ++i)
+    {
+      const BatchJob& job = jobs[(first + i) % jobs.size()];
+      unsigned attempt = ClaimJob(settings, job, worker);
+      if(attempt)
+      {
+        RunJob(settings, job, worker, attempt);
+        worked = true;
+      }
+      else if(!FileExists(JobPath(settings, job, ".done")))
+        ++pending;
+    }
+
+    //The rest are held by live workers, wait for them to finish or die
+    if(!pending)
+      break;
+    if(!worked)
+      std::this_thread::sleep_for(std::chrono::milliseconds(BatchPollMs));
+  }
+  return FinishBatch(settings, jobs);
+}
+
+#ifdef _WIN32
+typedef HANDLE WorkerProcess;
+
+static bool StartWorker(const std::vector<std::string>& args, WorkerProcess& process)
+{
+  //Quoting is enough for paths, Windows doesn't allow quotes in them
+  std::string line;
+  for(unsigned i = 0; i < args.size(); ++i)
+    line += (i ? " \"" : "\"") + args[i] + "\"";
+
+  STARTUPINFOA startup;
+  ZeroMemory(&startup, sizeof(startup));
+  startup.cb = sizeof(startup);
+  PROCESS_INFORMATION info;
+  if(!CreateProcessA(NULL, &line[0], NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info))
+    return false;
+  CloseHandle(info.hThread);
+  process = info.hProcess;
+  return true;
+}
+
+//Waits for any one worker to exit and drops it, returns true if it crashed
+static bool WaitForWorker(std::vector<WorkerProcess>& processes)
+{
+  DWORD index = WaitForMultipleObjects(static_cast<DWORD>(processes.size()), &processes[0], FALSE, INFINITE) - WAIT_OBJECT_0;
+  if(index >= processes.size())
+    index = 0;
+  DWORD code = 1;
+  GetExitCodeProcess(processes[index], &code);
+  CloseHandle(processes[index]);
+  processes.erase(processes.begin() + index);
+  //Unhandled exceptions end a process with their NTSTATUS code
+  return code >= 0xC0000000;
+}
+#else
+typedef pid_t WorkerProcess;
+
+static bool StartWorker(const std::vector<std::string>& args, WorkerProcess& process)
+{
+  std::vector<char*> argv;
+  for(unsigned i = 0; i < args.size(); ++i)
+    argv.push_back(const_cast<char*>(args[i].c_str()));
+  argv.push_back(NULL);
+  return !posix_spawnp(&process, argv[0], NULL, NULL, &argv[0], environ);
+}
+
+//Waits for any one worker to exit and drops it, returns true if it crashed
+static bool WaitForWorker(std::vector<WorkerProcess>& processes)
+{
+  int status = 0;
+  pid_t pid;
+  while((pid = waitpid(-1, &status, 0)) < 0 && errno == EINTR)
+    ;
+  std::vector<WorkerProcess>::iterator found = std::find(processes.begin(), processes.end(), pid);
+  if(pid < 0 || found == processes.end())
+  {
+    processes.clear();
+    return false;
+  }
+  processes.erase(found);
+  return WIFSIGNALED(status);
+}
+#endif
+
+//Starts the workers and waits for them. A worker that crashes is replaced
+//while jobs are left, its job is picked up once the lease runs out.
+static int RunWorkers(const BatchSettings& settings, const std::vector<BatchJob>& jobs)
+{
+  std::vector<WorkerProcess> processes;
+  for(unsigned i = 0; i < settings.workers_; ++i)
+  {
+    WorkerProcess process;
+    if(!StartWorker(settings.workerArgs_, process))
+    {
+      printf("Couldn't start worker %u!\n", i);
+      break;
+    }
+    processes.push_back(process);
+  }
+  printf("Started %u workers on %u jobs\n", static_cast<unsigned>(processes.size()), static_cast<unsigned>(jobs.size()));
+
+  //Crashes beyond this mean the workers can't run at all
+  unsigned replacements = settings.workers_ * (settings.retries_ + 1);
+  while(!processes.empty())
+  {
+    if(!WaitForWorker(processes))
+      continue;
+
+    bool jobsLeft = false;
+    for(unsigned j = 0; j < jobs.size() && !jobsLeft; ++j)
+      jobsLeft = !FileExists(JobPath(settings, jobs[j], ".done"));
+    WorkerProcess process;
+    if(jobsLeft && replacements)
+    {
+      --replacements;
+      printf("A worker crashed, starting another\n");
+      if(StartWorker(settings.workerArgs_, process))
+        processes.push_back(process);
+    }
+  }
+
+  //Whatever isn't done now would need a worker to run it
+  for(unsigned j = 0; j < jobs.size(); ++j)
+  {
+    if(!FileExists(JobPath(settings, jobs[j], ".done")))
+    {
+      printf("%s never finished, run the batch again to pick it up\n", jobs[j].input_.c_str());
+      return 1;
+    }
+  }
+  return FinishBatch(settings, jobs);
+}
+
+int RunBatch(int argc, char** argv)
+{
+  if(argc < 3 || argv[2][0] == '-')
+  {
+    PrintBatchUsage();
+    return 1;
+  }
+
+  BatchSettings settings;
+  settings.manifest_ = argv[2];
+  settings.queueDir_ = settings.manifest_ + ".queue";
+  settings.workers_ = 0;
+  settings.leaseSeconds_ = 60;
+  settings.retries_ = 2;
+  settings.workerArgs_.push_back(argv[0]);
+  settings.workerArgs_.push_back(argv[1]);
+  settings.workerArgs_.push_back(argv[2]);
+
+  std::vector<char*> switches;
+  for(int i = 3; i < argc; ++i)
+  {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if(!strcmp(arg, "-workers") && hasValue)
+    {
+      settings.workers_ = std::max(0, atoi(argv[++i]));
+      continue;
+    }
+
+    settings.workerArgs_.push_back(arg);
+    if(!strcmp(arg, "-queue") && hasValue)
+      settings.queueDir_ = argv[++i];
+    else if(!strcmp(arg, "-lease") && hasValue)
+      settings.leaseSeconds_ = std::max(1, atoi(argv[++i]));
+    else if(!strcmp(arg, "-retries") && hasValue)
+      settings.retries_ = std::max(0, atoi(argv[++i]));
+    else
+    {
+      switches.push_back(argv[i]);
+      continue;
+    }
+    settings.workerArgs_.push_back(argv[i]);
+  }
+
+  if(!switches.empty() && !ParseOptions(switches.size(), &switches[0], 0, settings.options_))
+  {
+    PrintBatchUsage();
+    return 1;
+  }
+
+  std::vector<BatchJob> jobs;
+  if(!LoadManifest(settings.manifest_, jobs))
+    return 1;
+  if(jobs.empty())
+  {
+    printf("%s lists no inputs\n", settings.manifest_.c_str());
+    return 0;
+  }
+  if(!MakeDirectory(settings.queueDir_))
+  {
+    printf("Couldn't make the queue directory %s!\n", settings.queueDir_.c_str());
+    return 1;
+  }
+
+  return settings.workers_ ? RunWorkers(settings, jobs) : RunWorker(settings, jobs);
+}
+
+void PrintBatchUsage(void)
+{
+  printf("Please type FBXConverter -batch MANIFEST [batch switches] [converter switches]\n");
+  printf("  -workers N     start N worker processes here and wait for them, without it this process is one worker\n");
+  printf("  -queue DIR     the lock and report files, shared by every worker (default MANIFEST.queue)\n");
+  printf("  -lease S       seconds a worker may go silent before its job is run again (default 60)\n");
+  printf("  -retries N     times a job is run again after its worker died (default 2)\n");
+  printf("The manifest lists one input per line. Start workers on as many machines as you like\n");
+  printf("with the same manifest and queue, their clocks need to agree to well within the lease.\n");
+  printf("Exits with 1 unless every input converted, the merged report goes to DIR/report.json.\n");
+}
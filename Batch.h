@@ -0,0 +1,27 @@
+////////////////////////////////////////////////////////
+//* Filename: Batch.h                                 //
+//  Author: Colt Johnson                              //
+//  Info: Batch mode, worker processes sharing a list //
+//        of inputs through lock files on disk.       //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+
+  //Runs "FBXConverter -batch MANIFEST [batch switches] [converter switches]"
+  //and returns the exit code: 0 when every input converted, 1 otherwise.
+  //
+  //The manifest lists one input per line, blank lines and lines starting with
+  //# are skipped. Every process started on it, on this machine or any other
+  //sharing the queue directory, works through the same list:
+  //  job_N_HASH.lock  claims a job, created exclusively so one worker wins. The
+  //                   owner rewrites it while converting, a lock left alone for
+  //                   longer than the lease belongs to a dead worker. The
+  //                   first worker to rename it away runs the job again.
+  //  job_N_HASH.done  the job's report, moved into place after its outputs
+  //  report.json      every job's report, merged by whoever finishes last
+  //Done jobs are skipped, so running again resumes the batch. Delete the queue
+  //directory to start over.
+  int RunBatch(int argc, char** argv);
+  void PrintBatchUsage(void);
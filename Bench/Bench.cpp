@@ -0,0 +1,501 @@
+////////////////////////////////////////////////////////
+//* Filename: Bench.cpp                               //
+//  Author: Colt Johnson                              //
+//  Info: gmfbench, times the converter over a corpus //
+//        of inputs and checks the results against a  //
+//        stored baseline. Built from this directory  //
+//        plus every converter source but Driver.cpp. //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "../ConvertApi.h"
+#include "../Hash.h"
+#include "../Snapshot.h"
+#include "Json.h"
+#include "PeakMemory.h"
+#include "SyntheticFbx.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+  #define NOMINMAX
+  #define WIN32_LEAN_AND_MEAN
+  #include <Windows.h>
+#else
+  #include <dirent.h>
+#endif
+
+//Time and memory changes smaller than these are noise whatever the percentage
+const double BenchNoiseMs = 1.0;
+const double BenchNoiseKb = 1024.0;
+
+struct BenchOutput
+{
+  std::string name_;
+  size_t bytes_;
+  unsigned long long hash_;
+};
+
+//Everything measured for one input, over all of its runs
+struct BenchFile
+{
+  std::string file_;
+  bool ok_;
+  //Every run made byte identical outputs
+  bool deterministic_;
+
+  double medianMs_;
+  double minMs_;
+  size_t peakKb_;
+  size_t outputBytes_;
+
+  //Median of each stage, in the order the stages ran
+  std::vector<StageTime> stages_;
+  std::vector<BenchOutput> outputs_;
+};
+
+//A measurement that moved past the threshold against the baseline
+struct BenchFlag
+{
+  std::string file_;
+  std::string what_;
+  double baseline_;
+  double current_;
+};
+
+struct BenchSettings
+{
+  std::string dir_;
+  unsigned runs_;
+  double threshold_;
+  std::string baseline_;
+  std::string out_;
+  bool synthesize_;
+  //Converter switches as typed, recorded with the results
+  std::string switches_;
+  ConvertOptions options_;
+};
+
+static std::string BaseName(const std::string& path)
+{
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static double Median(std::vector<double> values)
+{
+  if(values.empty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  size_t middle = values.size() / 2;
+  return values.size() % 2 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+//.fbx files directly in dir, sorted so the report order doesn't depend on the file system
+static bool ListInputs(const std::string& dir, std::vector<std::string>& files)
+{
+  files.clear();
+#ifdef _WIN32
+  WIN32_FIND_DATAA found;
+  HANDLE find = FindFirstFileA((dir + "\\*.fbx").c_str(), &found);
+  if(find == INVALID_HANDLE_VALUE)
+    return GetLastError() == ERROR_FILE_NOT_FOUND;
+  do
+  {
+    if(!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+      files.push_back(found.cFileName);
+  } while(FindNextFileA(find, &found));
+  FindClose(find);
+#else
+  DIR *handle = opendir(dir.c_str());
+  if(!handle)
+    return false;
+  while(dirent *entry = readdir(handle))
+  {
+    std::string name = entry->d_name;
+    if(name.size() < 4)
+      continue;
+    std::string extension = name.substr(name.size() - 4);
+    for(unsigned i = 0; i < extension.size(); ++i)
+      extension[i] = static_cast<char>(tolower(extension[i]));
+    if(extension == ".fbx")
+      files.push_back(name);
+  }
+  closedir(handle);
+#endif
+  std::sort(files.begin(), files.end());
+  return true;
+}
+
+static void BenchInput(const BenchSettings& settings, const std::string& name, BenchFile& bench)
+{
+  std::string path = settings.dir_ + "/" + name;
+  bench.file_ = name;
+  bench.ok_ = true;
+  bench.deterministic_ = true;
+  bench.peakKb_ = 0;
+  bench.outputBytes_ = 0;
+
+  std::vector<double> totals;
+  std::vector<std::string> stageNames;
+  std::vector<std::vector<double> > stageTimes;
+  for(unsigned run = 0; run < settings.runs_ && bench.ok_; ++run)
+  {
+    printf("gmfbench: %s run %u of %u\n", name.c_str(), run + 1, settings.runs_);
+    ResetPeakMemory();
+
+    ConvertResult result;
+    {
+      StageTimer timer(result.timings_, "total");
+      bench.ok_ = ConvertFile(path.c_str(), settings.options_, result);
+    }
+    bench.peakKb_ = std::max(bench.peakKb_, PeakMemoryKb());
+    if(!bench.ok_)
+      break;
+
+    //The last timing is the whole run, the rest are its stages
+    totals.push_back(result.timings_.back().ms_);
+    for(unsigned t = 0; t + 1 < result.timings_.size(); ++t)
+    {
+      const StageTime& stage = result.timings_[t];
+      unsigned s = std::find(stageNames.begin(), stageNames.end(), stage.name_) - stageNames.begin();
+      if(s == stageNames.size())
+      {
+        stageNames.push_back(stage.name_);
+        stageTimes.push_back(std::vector<double>());
+      }
+      stageTimes[s].push_back(stage.ms_);
+    }
+
+    std::vector<BenchOutput> outputs;
+    for(unsigned f = 0; f < result.files_.size(); ++f)
+    {
+      const OutputFile& file = result.files_[f];
+      BenchOutput output;
+      output.name_ = BaseName(file.name_);
+      output.bytes_ = file.data_.size();
+      output.hash_ = HashVector(file.data_);
+      outputs.push_back(output);
+    }
+
+    if(!run)
+      bench.outputs_ = outputs;
+    else if(outputs.size() != bench.outputs_.size())
+      bench.deterministic_ = false;
+    else
+      for(unsigned f = 0; f < outputs.size(); ++f)
+        if(outputs[f].name_ != bench.outputs_[f].name_ || outputs[f].hash_ != bench.outputs_[f].hash_)
+          bench.deterministic_ = false;
+  }
+
+  bench.medianMs_ = Median(totals);
+  bench.minMs_ = totals.empty() ? 0.0 : *std::min_element(totals.begin(), totals.end());
+  for(unsigned s = 0; s < stageNames.size(); ++s)
+  {
+    StageTime stage;
+    stage.name_ = stageNames[s];
+    stage.ms_ = Median(stageTimes[s]);
+    bench.stages_.push_back(stage);
+  }
+  for(unsigned f = 0; f < bench.outputs_.size(); ++f)
+    bench.outputBytes_ += bench.outputs_[f].bytes_;
+}
+
+static void WriteString(FILE *fp, const std::string& text)
+{
+  fputc('"', fp);
+  for(unsigned i = 0; i < text.size(); ++i)
+  {
+    unsigned char c = text[i];
+    if(c == '"' || c == '\\')
+      fprintf(fp, "\\%c", c);
+    else if(c < 0x20)
+      fprintf(fp, "\\u%04x", c);
+    else
+      fputc(c, fp);
+  }
+  fputc('"', fp);
+}
+
+//The report doubles as the next baseline, so it holds everything Compare reads
+static bool WriteReport(const BenchSettings& settings, bool peakPerRun, const std::vector<BenchFile>& files,
+                        const std::vector<BenchFlag>& flags)
+{
+  FILE *fp = fopen(settings.out_.c_str(), "wb");
+  if(!fp)
+  {
+    printf("Couldn't open %s for writing!\n", settings.out_.c_str());
+    return false;
+  }
+
+  fputs("{\n  \"switches\": ", fp);
+  WriteString(fp, settings.switches_);
+  fprintf(fp, ",\n  \"runs\": %u,\n  \"threshold\": %.2f,\n  \"peakPerRun\": %s,\n  \"files\": [",
+          settings.runs_, settings.threshold_, peakPerRun ? "true" : "false");
+
+  for(unsigned f = 0; f < files.size(); ++f)
+  {
+    const BenchFile& bench = files[f];
+    fputs(f ? ",\n    {\"file\": " : "\n    {\"file\": ", fp);
+    WriteString(fp, bench.file_);
+    fprintf(fp, ", \"ok\": %s, \"deterministic\": %s,\n", bench.ok_ ? "true" : "false", bench.deterministic_ ? "true" : "false");
+    fprintf(fp, "     \"medianMs\": %.3f, \"minMs\": %.3f, \"peakKb\": %lu, \"outputBytes\": %lu,\n     \"stages\": {",
+            bench.medianMs_, bench.minMs_, static_cast<unsigned long>(bench.peakKb_), static_cast<unsigned long>(bench.outputBytes_));
+    for(unsigned s = 0; s < bench.stages_.size(); ++s)
+    {
+      fputs(s ? ", " : "", fp);
+      WriteString(fp, bench.stages_[s].name_);
+      fprintf(fp, ": %.3f", bench.stages_[s].ms_);
+    }
+    fputs("},\n     \"outputs\": [", fp);
+    for(unsigned o = 0; o < bench.outputs_.size(); ++o)
+    {
+      fputs(o ? ",\n       {\"name\": " : "\n       {\"name\": ", fp);
+      WriteString(fp, bench.outputs_[o].name_);
+      fprintf(fp, ", \"bytes\": %lu, \"hash\": \"%016llx\"}", static_cast<unsigned long>(bench.outputs_[o].bytes_), bench.outputs_[o].hash_);
+    }
+    fputs("]}", fp);
+  }
+
+  fputs("\n  ],\n  \"flags\": [", fp);
+  for(unsigned i = 0; i < flags.size(); ++i)
+  {
+    fputs(i ? ",\n    {\"file\": " : "\n    {\"file\": ", fp);
+    WriteString(fp, flags[i].file_);
+    fputs(", \"what\": ", fp);
+    WriteString(fp, flags[i].what_);
+    fprintf(fp, ", \"baseline\": %.3f, \"current\": %.3f}", flags[i].baseline_, flags[i].current_);
+  }
+  fputs("\n  ]\n}\n", fp);
+
+  bool written = !ferror(fp);
+  if(fclose(fp) || !written)
+  {
+    printf("Couldn't write %s!\n", settings.out_.c_str());
+    return false;
+  }
+  return true;
+}
+
+static void AddFlag(std::vector<BenchFlag>& flags, const std::string& file, const std::string& what, double baseline, double current)
+{
+  BenchFlag flag;
+  flag.file_ = file;
+  flag.what_ = what;
+  flag.baseline_ = baseline;
+  flag.current_ = current;
+  flags.push_back(flag);
+}
+
+//Flags current when it grew more than threshold percent and more than noise over baseline
+static void CheckGrowth(std::vector<BenchFlag>& flags, const std::string& file, const std::string& what,
+                        double baseline, double current, double threshold, double noise)
+{
+  if(current > baseline * (1.0 + threshold / 100.0) && current - baseline > noise)
+    AddFlag(flags, file, what, baseline, current);
+}
+
+//Slower stages, more memory, bigger or different outputs, and inputs that stopped converting
+static void Compare(const JsonValue& baseline, const BenchSettings& settings, const std::vector<BenchFile>& files,
+                    std::vector<BenchFlag>& flags)
+{
+  if(baseline.StringOf("switches") != settings.switches_)
+    printf("gmfbench: the baseline was run with switches \"%s\", the numbers may not compare\n", baseline.StringOf("switches").c_str());
+
+  const JsonValue *baseFiles = baseline.Find("files");
+  if(!baseFiles || baseFiles->type_ != JsonValue::Array)
+    return;
+
+  double threshold = settings.threshold_;
+  for(unsigned b = 0; b < baseFiles->items_.size(); ++b)
+  {
+    const JsonValue& base = baseFiles->items_[b];
+    std::string name = base.StringOf("file");
+    const BenchFile *bench = NULL;
+    for(unsigned f = 0; f < files.size() && !bench; ++f)
+      if(files[f].file_ == name)
+        bench = &files[f];
+
+    const JsonValue *baseOk = base.Find("ok");
+    if(baseOk && !baseOk->number_)
+      continue;
+    if(!bench)
+    {
+      AddFlag(flags, name, "missing input", 1.0, 0.0);
+      continue;
+    }
+    if(!bench->ok_)
+    {
+      AddFlag(flags, name, "failed", 1.0, 0.0);
+      continue;
+    }
+    if(!bench->deterministic_)
+      AddFlag(flags, name, "nondeterministic", 1.0, 0.0);
+
+    CheckGrowth(flags, name, "medianMs", base.NumberOf("medianMs", 0.0), bench->medianMs_, threshold, BenchNoiseMs);
+    CheckGrowth(flags, name, "peakKb", base.NumberOf("peakKb", 0.0), static_cast<double>(bench->peakKb_), threshold, BenchNoiseKb);
+    CheckGrowth(flags, name, "outputBytes", base.NumberOf("outputBytes", 0.0), static_cast<double>(bench->outputBytes_), threshold, 0.0);
+
+    const JsonValue *baseStages = base.Find("stages");
+    for(unsigned s = 0; baseStages && s < bench->stages_.size(); ++s)
+    {
+      const StageTime& stage = bench->stages_[s];
+      const JsonValue *baseStage = baseStages->Find(stage.name_.c_str());
+      if(baseStage && baseStage->type_ == JsonValue::Number)
+        CheckGrowth(flags, name, "stage " + stage.name_, baseStage->number_, stage.ms_, threshold, BenchNoiseMs);
+    }
+
+    //Any change to what gets written is worth a look, even a smaller file
+    const JsonValue *baseOutputs = base.Find("outputs");
+    for(unsigned o = 0; baseOutputs && o < baseOutputs->items_.size(); ++o)
+    {
+      const JsonValue& baseOutput = baseOutputs->items_[o];
+      std::string outputName = baseOutput.StringOf("name");
+      double baseBytes = baseOutput.NumberOf("bytes", 0.0);
+
+      const BenchOutput *output = NULL;
+      for(unsigned c = 0; c < bench->outputs_.size() && !output; ++c)
+        if(bench->outputs_[c].name_ == outputName)
+          output = &bench->outputs_[c];
+
+      if(!output)
+        AddFlag(flags, name, "missing output " + outputName, baseBytes, 0.0);
+      else
+      {
+        char hash[32];
+        sprintf(hash, "%016llx", output->hash_);
+        if(baseOutput.StringOf("hash") != hash)
+          AddFlag(flags, name, "changed output " + outputName, baseBytes, static_cast<double>(output->bytes_));
+      }
+    }
+  }
+}
+
+static bool LoadBaseline(const std::string& path, JsonValue& baseline)
+{
+  MappedFile file;
+  if(!file.Open(path.c_str()))
+  {
+    printf("Couldn't open the baseline %s!\n", path.c_str());
+    return false;
+  }
+  if(!ParseJson(file.Data(), file.Size(), baseline) || baseline.type_ != JsonValue::Object)
+  {
+    printf("The baseline %s isn't a gmfbench report!\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+static void PrintBenchUsage(void)
+{
+  printf("gmfbench CORPUS_DIR [bench switches] [converter switches]\n");
+  printf("  -runs N        conversions of every input, the median is reported (default 5)\n");
+  printf("  -baseline F    compare against the report of an earlier run\n");
+  printf("  -threshold P   percent a time, peak memory or output size may grow by (default 10)\n");
+  printf("  -out F         where the report goes (default gmfbench.json), use it as the next baseline\n");
+  printf("  -synth         first write the synthetic inputs into the corpus if they aren't there\n");
+  printf("Every other switch goes to the converter:\n");
+  PrintUsage();
+  printf("Exits with 1 when an input fails to convert or the baseline can't be read, 2 when anything is flagged.\n");
+}
+
+int main(int argc, char** argv)
+{
+  if(argc < 2 || argv[1][0] == '-')
+  {
+    PrintBenchUsage();
+    return 1;
+  }
+
+  BenchSettings settings;
+  settings.dir_ = argv[1];
+  settings.runs_ = 5;
+  settings.threshold_ = 10.0;
+  settings.out_ = "gmfbench.json";
+  settings.synthesize_ = false;
+
+  std::vector<char*> switches;
+  for(int i = 2; i < argc; ++i)
+  {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if(!strcmp(arg, "-runs") && hasValue)
+      settings.runs_ = std::max(1, atoi(argv[++i]));
+    else if(!strcmp(arg, "-threshold") && hasValue)
+      settings.threshold_ = atof(argv[++i]);
+    else if(!strcmp(arg, "-baseline") && hasValue)
+      settings.baseline_ = argv[++i];
+    else if(!strcmp(arg, "-out") && hasValue)
+      settings.out_ = argv[++i];
+    else if(!strcmp(arg, "-synth"))
+      settings.synthesize_ = true;
+    else
+    {
+      switches.push_back(argv[i]);
+      settings.switches_ += settings.switches_.empty() ? arg : std::string(" ") + arg;
+    }
+  }
+
+  if(!switches.empty() && !ParseOptions(switches.size(), &switches[0], 0, settings.options_))
+  {
+    PrintBenchUsage();
+    return 1;
+  }
+
+  if(settings.synthesize_ && !WriteSyntheticCorpus(settings.dir_))
+    return 1;
+
+  std::vector<std::string> inputs;
+  if(!ListInputs(settings.dir_, inputs) || inputs.empty())
+  {
+    printf("No .fbx inputs in %s!\n", settings.dir_.c_str());
+    return 1;
+  }
+
+  //Read it first so a bad path doesn't waste a whole run
+  JsonValue baseline;
+  if(!settings.baseline_.empty() && !LoadBaseline(settings.baseline_, baseline))
+    return 1;
+
+  bool peakPerRun = ResetPeakMemory();
+  std::vector<BenchFile> files(inputs.size());
+  bool failed = false;
+  for(unsigned i = 0; i < inputs.size(); ++i)
+  {
+    BenchInput(settings, inputs[i], files[i]);
+    failed = failed || !files[i].ok_;
+  }
+
+  std::vector<BenchFlag> flags;
+  if(!settings.baseline_.empty())
+    Compare(baseline, settings, files, flags);
+
+  if(!WriteReport(settings, peakPerRun, files, flags))
+    return 1;
+
+  printf("\ngmfbench: %u inputs, %u runs each%s\n", static_cast<unsigned>(files.size()), settings.runs_,
+         peakPerRun ? "" : " (peak memory is for the whole process)");
+  for(unsigned f = 0; f < files.size(); ++f)
+  {
+    const BenchFile& bench = files[f];
+    if(bench.ok_)
+      printf("  %-32s %10.1f ms %10lu KB %10lu bytes%s\n", bench.file_.c_str(), bench.medianMs_,
+             static_cast<unsigned long>(bench.peakKb_), static_cast<unsigned long>(bench.outputBytes_),
+             bench.deterministic_ ? "" : " nondeterministic");
+    else
+      printf("  %-32s failed\n", bench.file_.c_str());
+  }
+  for(unsigned i = 0; i < flags.size(); ++i)
+    printf("  FLAG %s: %s %.3f -> %.3f\n", flags[i].file_.c_str(), flags[i].what_.c_str(), flags[i].baseline_, flags[i].current_);
+  printf("Report written to %s\n", settings.out_.c_str());
+
+  if(failed)
+    return 1;
+  return flags.empty() ? 0 : 2;
+}
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////
+//* Filename: Json.cpp                                //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Json.h"
+#include <cstdlib>
+#include <cstring>
+
+//Deeper than anything gmfbench writes, keeps bad input from running the stack out
+const unsigned JsonMaxDepth = 64;
+
+struct JsonParser
+{
+  const char *cur_;
+  const char *end_;
+
+  void SkipSpace(void)
+  {
+    while(cur_ < end_ && (*cur_ == ' ' || *cur_ == '\t' || *cur_ == '\n' || *cur_ == '\r'))
+      ++cur_;
+  }
+
+  bool Match(const char *word)
+  {
+    size_t length = strlen(word);
+    if(static_cast<size_t>(end_ - cur_) < length || strncmp(cur_, word, length))
+      return false;
+    cur_ += length;
+    return true;
+  }
+
+  bool ParseString(std::string& text);
+  bool ParseNumber(double& number);
+  bool ParseValue(JsonValue& value, unsigned depth);
+};
+
+bool JsonParser::ParseString(std::string& text)
+{
+  //Opening quote already checked by the caller
+  ++cur_;
+  text.clear();
+  while(cur_ < end_ && *cur_ != '"')
+  {
+    char c = *cur_++;
+    if(c != '\\')
+    {
+      text += c;
+      continue;
+    }
+
+    if(cur_ == end_)
+      return false;
+    c = *cur_++;
+    switch(c)
+    {
+      case 'b': text += '\b'; break;
+      case 'f': text += '\f'; break;
+      case 'n': text += '\n'; break;
+      case 'r': text += '\r'; break;
+      case 't': text += '\t'; break;
+      case 'u':
+      {
+        if(end_ - cur_ < 4)
+          return false;
+        char hex[5] = {cur_[0], cur_[1], cur_[2], cur_[3], 0};
+        cur_ += 4;
+
+        //Nothing gmfbench writes goes past ASCII
+        unsigned code = static_cast<unsigned>(strtoul(hex, NULL, 16));
+        text += code < 0x80 ? static_cast<char>(code) : '?';
+        break;
+      }
+      default: text += c; break;
+    }
+  }
+
+  if(cur_ == end_)
+    return false;
+  ++cur_;
+  return true;
+}
+
+bool JsonParser::ParseNumber(double& number)
+{
+  //strtod wants a terminated string
+  char buffer[64];
+  size_t length = 0;
+  while(cur_ + length < end_ && length + 1 < sizeof(buffer) && cur_[length] && strchr("+-0123456789.eE", cur_[length]))
+  {
+    buffer[length] = cur_[length];
+    ++length;
+  }
+  buffer[length] = 0;
+
+  char *stop;
+  number = strtod(buffer, &stop);
+  if(stop == buffer)
+    return false;
+  cur_ += stop - buffer;
+  return true;
+}
+
+bool JsonParser::ParseValue(JsonValue& value, unsigned depth)
+{
+  SkipSpace();
+  if(cur_ == end_ || depth > JsonMaxDepth)
+    return false;
+
+  if(*cur_ == '{' || *cur_ == '[')
+  {
+    bool object = *cur_ == '{';
+    char close = object ? '}' : ']';
+    value.type_ = object ? JsonValue::Object : JsonValue::Array;
+    ++cur_;
+
+    SkipSpace();
+    if(cur_ < end_ && *cur_ == close)
+    {
+      ++cur_;
+      return true;
+    }
+
+    for(;;)
+    {
+      if(object)
+      {
+        SkipSpace();
+        value.keys_.push_back(std::string());
+        if(cur_ == end_ || *cur_ != '"' || !ParseString(value.keys_.back()))
+          return false;
+        SkipSpace();
+        if(cur_ == end_ || *cur_++ != ':')
+          return false;
+      }
+
+      value.items_.push_back(JsonValue());
+      if(!ParseValue(value.items_.back(), depth + 1))
+        return false;
+
+      SkipSpace();
+      if(cur_ == end_)
+        return false;
+      char c = *cur_++;
+      if(c == close)
+        return true;
+      if(c != ',')
+        return false;
+    }
+  }
+
+  if(*cur_ == '"')
+  {
+    value.type_ = JsonValue::String;
+    return ParseString(value.string_);
+  }
+
+  if(Match("true") || Match("false"))
+  {
+    value.type_ = JsonValue::Bool;
+    value.number_ = cur_[-4] == 't' ? 1.0 : 0.0;
+    return true;
+  }
+
+  if(Match("null"))
+  {
+    value.type_ = JsonValue::Null;
+    return true;
+  }
+
+  value.type_ = JsonValue::Number;
+  return ParseNumber(value.number_);
+}
+
+const JsonValue* JsonValue::Find(const char *key) const
+{
+  if(type_ != Object)
+    return NULL;
+
+  for(unsigned i = 0; i < keys_.size(); ++i)
+    if(keys_[i] == key)
+      return &items_[i];
+  return NULL;
+}
+
+double JsonValue::NumberOf(const char *key, double fallback) const
+{
+  const JsonValue *member = Find(key);
+  return member && member->type_ == Number ? member->number_ : fallback;
+}
+
+std::string JsonValue::StringOf(const char *key) const
+{
+  const JsonValue *member = Find(key);
+  return member && member->type_ == String ? member->string_ : std::string();
+}
+
+bool ParseJson(const char *text, size_t size, JsonValue& value)
+{
+  JsonParser parser = {text, text + size};
+  value = JsonValue();
+  if(!parser.ParseValue(value, 0))
+    return false;
+
+  parser.SkipSpace();
+  return parser.cur_ == parser.end_;
+}
@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////
+//* Filename: Json.h                                  //
+//  Author: Colt Johnson                              //
+//  Info: Just enough JSON reading for gmfbench to    //
+//        load its own baselines back in.             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+  struct JsonValue
+  {
+    enum Type
+    {
+      Null,
+      Bool,
+      Number,
+      String,
+      Array,
+      Object
+    };
+
+    JsonValue(void) : type_(Null), number_(0.0) {}
+
+    Type type_;
+    //Numbers, and 0 or 1 for bools
+    double number_;
+    std::string string_;
+
+    //Array elements, or object members with their names in keys_
+    std::vector<JsonValue> items_;
+    std::vector<std::string> keys_;
+
+    //Member called key, NULL when there is none or this isn't an object
+    const JsonValue* Find(const char *key) const;
+    //Member key as a number, fallback when it is missing or not a number
+    double NumberOf(const char *key, double fallback) const;
+    //Member key as a string, empty when it is missing or not a string
+    std::string StringOf(const char *key) const;
+  };
+
+  //Parses size bytes of text into value. Returns false on anything that isn't JSON.
+  bool ParseJson(const char *text, size_t size, JsonValue& value);
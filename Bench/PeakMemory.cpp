@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////
+//* Filename: PeakMemory.cpp                          //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "PeakMemory.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+  #define NOMINMAX
+  #define WIN32_LEAN_AND_MEAN
+  #include <Windows.h>
+  #include <Psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+#ifdef _WIN32
+bool ResetPeakMemory(void)
+{
+  return false;
+}
+
+size_t PeakMemoryKb(void)
+{
+  PROCESS_MEMORY_COUNTERS counters;
+  if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return counters.PeakWorkingSetSize / 1024;
+}
+#else
+bool ResetPeakMemory(void)
+{
+  //Writing 5 to clear_refs resets VmHWM (Linux 4.0 and later)
+  FILE *fp = fopen("/proc/self/clear_refs", "w");
+  if(!fp)
+    return false;
+  bool reset = fputs("5", fp) >= 0;
+  return !fclose(fp) && reset;
+}
+
+size_t PeakMemoryKb(void)
+{
+  FILE *fp = fopen("/proc/self/status", "r");
+  if(fp)
+  {
+    char line[256];
+    while(fgets(line, sizeof(line), fp))
+    {
+      unsigned long kb;
+      if(!strncmp(line, "VmHWM:", 6) && sscanf(line + 6, "%lu", &kb) == 1)
+      {
+        fclose(fp);
+        return kb;
+      }
+    }
+    fclose(fp);
+  }
+
+  //No procfs, fall back to the process wide peak
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage))
+    return 0;
+  return static_cast<size_t>(usage.ru_maxrss);
+}
+#endif
@@ -0,0 +1,19 @@
+////////////////////////////////////////////////////////
+//* Filename: PeakMemory.h                            //
+//  Author: Colt Johnson                              //
+//  Info: Peak resident memory of the process, for    //
+//        gmfbench.                                   //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <cstddef>
+
+  //Starts a new peak from the current resident size. Returns false where the
+  //OS keeps one peak for the whole process (Windows, old Linux kernels), the
+  //peak then covers everything run so far.
+  bool ResetPeakMemory(void);
+
+  //Most memory resident at once since the last reset, in kilobytes
+  size_t PeakMemoryKb(void);
@@ -0,0 +1,361 @@
+////////////////////////////////////////////////////////
+//* Filename: SyntheticFbx.cpp                        //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "SyntheticFbx.h"
+#include "../MathTypes.h"
+#include <cstdio>
+#include <vector>
+
+const float SynthPi = 3.14159265f;
+
+//Values per line of an FBX array, the rest go on lines starting with a comma
+const unsigned SynthValuesPerLine = 16;
+
+//One mesh node in the FBX's own terms, polygons wind counter clockwise seen from outside
+struct SynthModel
+{
+  std::string name_;
+  std::vector<Float3> points_;
+  //Control points of each polygon, the last one stored as ~index
+  std::vector<int> polygons_;
+  //Per polygon vertex
+  std::vector<Float3> normals_;
+  std::vector<Float2> uvs_;
+  std::vector<int> uvIndices_;
+
+  //Adds a polygon, normals and uvIndices go with its corners
+  void AddPolygon(const int *corners, int count, const Float3 *normals, const int *uvIndices)
+  {
+    for(int c = 0; c < count; ++c)
+    {
+      polygons_.push_back(c + 1 < count ? corners[c] : ~corners[c]);
+      normals_.push_back(normals[c]);
+      uvIndices_.push_back(uvIndices[c]);
+    }
+  }
+};
+
+static void WriteList(FILE *fp, int depth, const char *label, const float *values, unsigned count)
+{
+  fprintf(fp, "%.*s%s: ", depth, "\t\t\t\t", label);
+  for(unsigned i = 0; i < count; ++i)
+  {
+    if(i)
+      fputs(i % SynthValuesPerLine ? "," : "\n,", fp);
+    fprintf(fp, "%.7g", values[i]);
+  }
+  fputs("\n", fp);
+}
+
+static void WriteList(FILE *fp, int depth, const char *label, const int *values, unsigned count)
+{
+  fprintf(fp, "%.*s%s: ", depth, "\t\t\t\t", label);
+  for(unsigned i = 0; i < count; ++i)
+  {
+    if(i)
+      fputs(i % SynthValuesPerLine ? "," : "\n,", fp);
+    fprintf(fp, "%d", values[i]);
+  }
+  fputs("\n", fp);
+}
+
+static void WriteModel(FILE *fp, const SynthModel& model)
+{
+  fprintf(fp, "\tModel: \"Model::%s\", \"Mesh\" {\n", model.name_.c_str());
+  fputs("\t\tVersion: 232\n"
+        "\t\tProperties60:  {\n"
+        "\t\t\tProperty: \"Lcl Translation\", \"Lcl Translation\", \"A+\",0,0,0\n"
+        "\t\t\tProperty: \"Lcl Rotation\", \"Lcl Rotation\", \"A+\",0,0,0\n"
+        "\t\t\tProperty: \"Lcl Scaling\", \"Lcl Scaling\", \"A+\",1,1,1\n"
+        "\t\t}\n"
+        "\t\tMultiLayer: 0\n"
+        "\t\tMultiTake: 1\n"
+        "\t\tShading: Y\n"
+        "\t\tCulling: \"CullingOff\"\n", fp);
+
+  WriteList(fp, 2, "Vertices", &model.points_[0].x, model.points_.size() * 3);
+  WriteList(fp, 2, "PolygonVertexIndex", &model.polygons_[0], model.polygons_.size());
+  fputs("\t\tGeometryVersion: 124\n", fp);
+
+  fputs("\t\tLayerElementNormal: 0 {\n"
+        "\t\t\tVersion: 101\n"
+        "\t\t\tName: \"\"\n"
+        "\t\t\tMappingInformationType: \"ByPolygonVertex\"\n"
+        "\t\t\tReferenceInformationType: \"Direct\"\n", fp);
+  WriteList(fp, 3, "Normals", &model.normals_[0].x, model.normals_.size() * 3);
+  fputs("\t\t}\n", fp);
+
+  fputs("\t\tLayerElementUV: 0 {\n"
+        "\t\t\tVersion: 101\n"
+        "\t\t\tName: \"UVChannel_1\"\n"
+        "\t\t\tMappingInformationType: \"ByPolygonVertex\"\n"
+        "\t\t\tReferenceInformationType: \"IndexToDirect\"\n", fp);
+  WriteList(fp, 3, "UV", &model.uvs_[0].x, model.uvs_.size() * 2);
+  WriteList(fp, 3, "UVIndex", &model.uvIndices_[0], model.uvIndices_.size());
+  fputs("\t\t}\n", fp);
+
+  fputs("\t\tLayer: 0 {\n"
+        "\t\t\tVersion: 100\n"
+        "\t\t\tLayerElement:  {\n"
+        "\t\t\t\tType: \"LayerElementNormal\"\n"
+        "\t\t\t\tTypedIndex: 0\n"
+        "\t\t\t}\n"
+        "\t\t\tLayerElement:  {\n"
+        "\t\t\t\tType: \"LayerElementUV\"\n"
+        "\t\t\t\tTypedIndex: 0\n"
+        "\t\t\t}\n"
+        "\t\t}\n"
+        "\t}\n", fp);
+}
+
+static bool WriteFbx(const std::string& path, const std::vector<SynthModel>& models)
+{
+  FILE *fp = fopen(path.c_str(), "wb");
+  if(!fp)
+  {
+    printf("Couldn't open %s for writing!\n", path.c_str());
+    return false;
+  }
+
+  fputs("; FBX 6.1.0 project file\n"
+        "; Generated by gmfbench\n"
+        "; ----------------------------------------------------\n\n"
+        "FBXHeaderExtension:  {\n"
+        "\tFBXHeaderVersion: 1003\n"
+        "\tFBXVersion: 6100\n"
+        "}\n\n", fp);
+
+  fprintf(fp, "Definitions:  {\n"
+              "\tVersion: 100\n"
+              "\tCount: %u\n"
+              "\tObjectType: \"Model\" {\n"
+              "\t\tCount: %u\n"
+              "\t}\n"
+              "\tObjectType: \"GlobalSettings\" {\n"
+              "\t\tCount: 1\n"
+              "\t}\n"
+              "}\n\n", static_cast<unsigned>(models.size() + 1), static_cast<unsigned>(models.size()));
+
+  fputs("Objects:  {\n", fp);
+  for(unsigned m = 0; m < models.size(); ++m)
+    WriteModel(fp, models[m]);
+  fputs("\tGlobalSettings:  {\n"
+        "\t\tVersion: 1000\n"
+        "\t\tProperties60:  {\n"
+        "\t\t\tProperty: \"UpAxis\", \"int\", \"\",1\n"
+        "\t\t\tProperty: \"UpAxisSign\", \"int\", \"\",1\n"
+        "\t\t\tProperty: \"FrontAxis\", \"int\", \"\",2\n"
+        "\t\t\tProperty: \"FrontAxisSign\", \"int\", \"\",1\n"
+        "\t\t\tProperty: \"CoordAxis\", \"int\", \"\",0\n"
+        "\t\t\tProperty: \"CoordAxisSign\", \"int\", \"\",1\n"
+        "\t\t\tProperty: \"UnitScaleFactor\", \"double\", \"\",1\n"
+        "\t\t}\n"
+        "\t}\n"
+        "}\n\n", fp);
+
+  fputs("Connections:  {\n", fp);
+  for(unsigned m = 0; m < models.size(); ++m)
+    fprintf(fp, "\tConnect: \"OO\", \"Model::%s\", \"Model::Scene\"\n", models[m].name_.c_str());
+  fputs("}\n", fp);
+
+  bool written = !ferror(fp);
+  if(fclose(fp) || !written)
+  {
+    printf("Couldn't write %s!\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+//Rolling height field, its normals come from the slope of the formula
+static void MakeGrid(std::vector<SynthModel>& models, int size)
+{
+  models.push_back(SynthModel());
+  SynthModel& model = models.back();
+  model.name_ = "grid";
+
+  const float height = 4.0f, frequency = 6.0f * SynthPi / size;
+  for(int z = 0; z <= size; ++z)
+  {
+    for(int x = 0; x <= size; ++x)
+    {
+      float y = height * std::sin(x * frequency) * std::cos(z * frequency);
+      model.points_.push_back(MakeFloat3(static_cast<float>(x), y, static_cast<float>(z)));
+      model.uvs_.push_back(MakeFloat2(static_cast<float>(x) / size, static_cast<float>(z) / size));
+    }
+  }
+
+  for(int z = 0; z < size; ++z)
+  {
+    for(int x = 0; x < size; ++x)
+    {
+      int corners[4] = {z * (size + 1) + x, (z + 1) * (size + 1) + x, (z + 1) * (size + 1) + x + 1, z * (size + 1) + x + 1};
+      Float3 normals[4];
+      for(int c = 0; c < 4; ++c)
+      {
+        const Float3& p = model.points_[corners[c]];
+        float dx = height * frequency * std::cos(p.x * frequency) * std::cos(p.z * frequency);
+        float dz = -height * frequency * std::sin(p.x * frequency) * std::sin(p.z * frequency);
+        normals[c] = MakeFloat3(-dx, 1.0f, -dz);
+        Normalize(normals[c]);
+      }
+      model.AddPolygon(corners, 4, normals, corners);
+    }
+  }
+}
+
+//Sphere of quads with a fan at each pole. The uvs are split along one seam.
+static void MakeSphere(std::vector<SynthModel>& models, int segments, int rings)
+{
+  models.push_back(SynthModel());
+  SynthModel& model = models.back();
+  model.name_ = "sphere";
+
+  const float radius = 50.0f;
+  model.points_.push_back(MakeFloat3(0.0f, radius, 0.0f));
+  for(int r = 1; r < rings; ++r)
+  {
+    float theta = SynthPi * r / rings;
+    for(int s = 0; s < segments; ++s)
+    {
+      float phi = 2.0f * SynthPi * s / segments;
+      model.points_.push_back(MakeFloat3(radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta),
+                                         radius * std::sin(theta) * std::sin(phi)));
+    }
+  }
+  model.points_.push_back(MakeFloat3(0.0f, -radius, 0.0f));
+  int bottom = model.points_.size() - 1;
+
+  for(int r = 0; r <= rings; ++r)
+    for(int s = 0; s <= segments; ++s)
+      model.uvs_.push_back(MakeFloat2(static_cast<float>(s) / segments, static_cast<float>(r) / rings));
+
+  for(int r = 0; r < rings; ++r)
+  {
+    for(int s = 0; s < segments; ++s)
+    {
+      int next = (s + 1) % segments;
+      int upper = 1 + (r - 1) * segments, lower = 1 + r * segments;
+      int uvs[4] = {r * (segments + 1) + s, r * (segments + 1) + s + 1,
+                    (r + 1) * (segments + 1) + s + 1, (r + 1) * (segments + 1) + s};
+      int corners[4];
+      int uvIndices[4];
+      int count = 0;
+
+      //The poles are one point each, their quads lose a corner
+      if(r == 0)
+      {
+        corners[count] = 0;
+        uvIndices[count++] = uvs[0];
+      }
+      else
+      {
+        corners[count] = upper + s;
+        uvIndices[count++] = uvs[0];
+        corners[count] = upper + next;
+        uvIndices[count++] = uvs[1];
+      }
+      if(r == rings - 1)
+      {
+        corners[count] = bottom;
+        uvIndices[count++] = uvs[3];
+      }
+      else
+      {
+        corners[count] = lower + next;
+        uvIndices[count++] = uvs[2];
+        corners[count] = lower + s;
+        uvIndices[count++] = uvs[3];
+      }
+
+      Float3 normals[4];
+      for(int c = 0; c < count; ++c)
+      {
+        normals[c] = model.points_[corners[c]];
+        Normalize(normals[c]);
+      }
+      model.AddPolygon(corners, count, normals, uvIndices);
+    }
+  }
+}
+
+//A field of separate boxes of varying heights, one node each
+static void MakeBlocks(std::vector<SynthModel>& models, int across)
+{
+  //Corner c of a box is at (c & 1, c >> 1 & 1, c >> 2 & 1), faces wound outward
+  static const int faces[6][4] = {{0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}};
+  static const float faceNormals[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+  for(int bz = 0; bz < across; ++bz)
+  {
+    for(int bx = 0; bx < across; ++bx)
+    {
+      models.push_back(SynthModel());
+      SynthModel& model = models.back();
+      char name[32];
+      sprintf(name, "block_%d_%d", bx, bz);
+      model.name_ = name;
+
+      float height = 1.0f + (bx * 7 + bz * 13) % 10;
+      for(int c = 0; c < 8; ++c)
+        model.points_.push_back(MakeFloat3(bx * 3.0f + (c & 1) * 2.0f, (c >> 1 & 1) * height, bz * 3.0f + (c >> 2 & 1) * 2.0f));
+
+      model.uvs_.push_back(MakeFloat2(0.0f, 0.0f));
+      model.uvs_.push_back(MakeFloat2(1.0f, 0.0f));
+      model.uvs_.push_back(MakeFloat2(1.0f, 1.0f));
+      model.uvs_.push_back(MakeFloat2(0.0f, 1.0f));
+
+      static const int uvIndices[4] = {0, 1, 2, 3};
+      for(int f = 0; f < 6; ++f)
+      {
+        Float3 normal = MakeFloat3(faceNormals[f][0], faceNormals[f][1], faceNormals[f][2]);
+        Float3 normals[4] = {normal, normal, normal, normal};
+        model.AddPolygon(faces[f], 4, normals, uvIndices);
+      }
+    }
+  }
+}
+
+static bool FileExists(const std::string& path)
+{
+  FILE *fp = fopen(path.c_str(), "rb");
+  if(!fp)
+    return false;
+  fclose(fp);
+  return true;
+}
+
+bool WriteSyntheticCorpus(const std::string& dir)
+{
+  struct Synthetic
+  {
+    const char *file_;
+    int kind_;
+  };
+  static const Synthetic synthetics[] = {{"synth_grid.fbx", 0}, {"synth_sphere.fbx", 1}, {"synth_blocks.fbx", 2}};
+
+  bool written = true;
+  for(unsigned i = 0; i < sizeof(synthetics) / sizeof(synthetics[0]); ++i)
+  {
+    std::string path = dir + "/" + synthetics[i].file_;
+    if(FileExists(path))
+      continue;
+
+    std::vector<SynthModel> models;
+    if(synthetics[i].kind_ == 0)
+      MakeGrid(models, 256);
+    else if(synthetics[i].kind_ == 1)
+      MakeSphere(models, 128, 64);
+    else
+      MakeBlocks(models, 16);
+
+    printf("Writing %s\n", path.c_str());
+    written = WriteFbx(path, models) && written;
+  }
+  return written;
+}
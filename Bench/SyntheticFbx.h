@@ -0,0 +1,20 @@
+////////////////////////////////////////////////////////
+//* Filename: SyntheticFbx.h                          //
+//  Author: Colt Johnson                              //
+//  Info: Generated inputs for gmfbench, so a corpus  //
+//        works without any artist assets.            //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <string>
+
+  //Writes the synthetic scenes into dir as ASCII FBX 6.1, built from fixed
+  //formulas so every machine gets the same bytes. Files already there are
+  //left alone. All of them are static:
+  //  synth_grid.fbx    one 256 x 256 quad height field
+  //  synth_sphere.fbx  one 128 x 64 sphere with uv seams and triangle fan poles
+  //  synth_blocks.fbx  256 boxes, one node each, for the per sub mesh stages
+  //Returns false if any file couldn't be written.
+  bool WriteSyntheticCorpus(const std::string& dir);
@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////
+//* Filename: BlockCompress.cpp                       //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "BlockCompress.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+  #define BLOCK_SSE2
+  #include <emmintrin.h>
+#endif
+
+unsigned BlockBytes(BlockFormat format)
+{
+  return format == BlockBC1 ? 8 : 16;
+}
+
+unsigned CompressedSize(unsigned width, unsigned height, BlockFormat format)
+{
+  return std::max(1u, (width + 3) / 4) * std::max(1u, (height + 3) / 4) * BlockBytes(format);
+}
+
+static unsigned short Pack565(const unsigned char *color)
+{
+  unsigned r = (color[0] * 31 + 127) / 255;
+  unsigned g = (color[1] * 63 + 127) / 255;
+  unsigned b = (color[2] * 31 + 127) / 255;
+  return static_cast<unsigned short>(r << 11 | g << 5 | b);
+}
+
+//Expands the way the hardware does, the alpha byte is left zero
+static void Unpack565(unsigned short packed, unsigned char *color)
+{
+  unsigned r = packed >> 11;
+  unsigned g = (packed >> 5) & 63;
+  unsigned b = packed & 31;
+  color[0] = static_cast<unsigned char>(r << 3 | r >> 2);
+  color[1] = static_cast<unsigned char>(g << 2 | g >> 4);
+  color[2] = static_cast<unsigned char>(b << 3 | b >> 2);
+  color[3] = 0;
+}
+
+static void ColorBounds(const unsigned char rgba[64], unsigned char *minColor, unsigned char *maxColor)
+{
+#ifdef BLOCK_SSE2
+  __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba));
+  __m128i hi = lo;
+  for(unsigned row = 1; row < 4; ++row)
+  {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + row * 16));
+    lo = _mm_min_epu8(lo, pixels);
+    hi = _mm_max_epu8(hi, pixels);
+  }
+
+  //Fold the four pixels in each register down to one
+  lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 8));
+  lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+  hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 8));
+  hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+
+  int packedMin = _mm_cvtsi128_si32(lo);
+  int packedMax = _mm_cvtsi128_si32(hi);
+  memcpy(minColor, &packedMin, 4);
+  memcpy(maxColor, &packedMax, 4);
+#else
+  memcpy(minColor, rgba, 4);
+  memcpy(maxColor, rgba, 4);
+  for(unsigned i = 1; i < 16; ++i)
+    for(unsigned c = 0; c < 4; ++c)
+    {
+      minColor[c] = std::min(minColor[c], rgba[i * 4 + c]);
+      maxColor[c] = std::max(maxColor[c], rgba[i * 4 + c]);
+    }
+#endif
+}
+
+#ifdef BLOCK_SSE2
+//Squared RGB distance of four pixels to one color, alpha has to be masked off both
+static __m128i Distance4(__m128i pixels, __m128i color)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_unpacklo_epi8(color, zero));
+  __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), _mm_unpackhi_epi8(color, zero));
+
+  //(r*r + g*g, b*b) for two pixels in each
+  lo = _mm_madd_epi16(lo, lo);
+  hi = _mm_madd_epi16(hi, hi);
+
+  __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+  __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+  return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+}
+#endif
+
+//Closest of the four palette colors for every pixel, 2 bits each
+static unsigned ColorIndices(const unsigned char rgba[64], unsigned char palette[4][4])
+{
+  unsigned indices = 0;
+
+#ifdef BLOCK_SSE2
+  const __m128i mask = _mm_set1_epi32(0x00ffffff);
+  __m128i colors[4];
+  for(unsigned k = 0; k < 4; ++k)
+  {
+    int packed;
+    memcpy(&packed, palette[k], 4);
+    colors[k] = _mm_and_si128(_mm_set1_epi32(packed), mask);
+  }
+
+  for(unsigned row = 0; row < 4; ++row)
+  {
+    __m128i pixels = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + row * 16)), mask);
+    __m128i best = Distance4(pixels, colors[0]);
+    __m128i index = _mm_setzero_si128();
+
+    for(unsigned k = 1; k < 4; ++k)
+    {
+      __m128i distance = Distance4(pixels, colors[k]);
+      __m128i closer = _mm_cmplt_epi32(distance, best);
+      best = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best));
+      index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, index));
+    }
+
+    int rowIndices[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rowIndices), index);
+    for(unsigned p = 0; p < 4; ++p)
+      indices |= rowIndices[p] << ((row * 4 + p) * 2);
+  }
+#else
+  for(unsigned i = 0; i < 16; ++i)
+  {
+    unsigned bestIndex = 0;
+    int best = 0x7fffffff;
+    for(unsigned k = 0; k < 4; ++k)
+    {
+      int distance = 0;
+      for(unsigned c = 0; c < 3; ++c)
+      {
+        int d = rgba[i * 4 + c] - palette[k][c];
+        distance += d * d;
+      }
+      if(distance < best)
+      {
+        best = distance;
+        bestIndex = k;
+      }
+    }
+    indices |= bestIndex << (i * 2);
+  }
+#endif
+
+  return indices;
+}
+
+//Endpoints from the block's bounding box pulled in slightly, which lowers the
+//error for the colors inside it, then the closest palette entry per pixel
+static void CompressColorBlock(const unsigned char rgba[64], unsigned char *destination)
+{
+  unsigned char minColor[4], maxColor[4];
+  ColorBounds(rgba, minColor, maxColor);
+  for(unsigned c = 0; c < 3; ++c)
+  {
+    unsigned char inset = (maxColor[c] - minColor[c]) >> 4;
+    minColor[c] += inset;
+    maxColor[c] -= inset;
+  }
+
+  //The first endpoint has to be the larger or the block decodes as 3 colors plus transparent
+  unsigned short c0 = Pack565(maxColor);
+  unsigned short c1 = Pack565(minColor);
+  if(c0 < c1)
+    std::swap(c0, c1);
+
+  unsigned indices = 0;
+  if(c0 != c1)
+  {
+    unsigned char palette[4][4];
+    Unpack565(c0, palette[0]);
+    Unpack565(c1, palette[1]);
+    for(unsigned c = 0; c < 4; ++c)
+    {
+      palette[2][c] = static_cast<unsigned char>((2 * palette[0][c] + palette[1][c]) / 3);
+      palette[3][c] = static_cast<unsigned char>((palette[0][c] + 2 * palette[1][c]) / 3);
+    }
+    indices = ColorIndices(rgba, palette);
+  }
+
+  destination[0] = static_cast<unsigned char>(c0);
+  destination[1] = static_cast<unsigned char>(c0 >> 8);
+  destination[2] = static_cast<unsigned char>(c1);
+  destination[3] = static_cast<unsigned char>(c1 >> 8);
+  for(unsigned b = 0; b < 4; ++b)
+    destination[4 + b] = static_cast<unsigned char>(indices >> (b * 8));
+}
+
+//One channel with 8 interpolated levels between its min and max, 3 bits per pixel
+static void CompressChannelBlock(const unsigned char rgba[64], unsigned channel, unsigned char *destination)
+{
+  unsigned char values[16];
+  for(unsigned i = 0; i < 16; ++i)
+    values[i] = rgba[i * 4 + channel];
+
+  unsigned char lo = *std::min_element(values, values + 16);
+  unsigned char hi = *std::max_element(values, values + 16);
+
+  unsigned char palette[8];
+  palette[0] = hi;
+  palette[1] = lo;
+  for(unsigned i = 1; i < 7; ++i)
+    palette[i + 1] = static_cast<unsigned char>(((7 - i) * hi + i * lo + 3) / 7);
+
+  unsigned char indices[16];
+#ifdef BLOCK_SSE2
+  __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+  __m128i level = _mm_set1_epi8(static_cast<char>(palette[0]));
+  __m128i best = _mm_or_si128(_mm_subs_epu8(pixels, level), _mm_subs_epu8(level, pixels));
+  __m128i index = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi8(-1);
+
+  for(unsigned k = 1; k < 8; ++k)
+  {
+    level = _mm_set1_epi8(static_cast<char>(palette[k]));
+    __m128i distance = _mm_or_si128(_mm_subs_epu8(pixels, level), _mm_subs_epu8(level, pixels));
+
+    //Strictly closer, so ties keep the earlier level
+    __m128i closer = _mm_xor_si128(_mm_cmpeq_epi8(_mm_max_epu8(distance, best), distance), ones);
+    best = _mm_min_epu8(distance, best);
+    index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi8(static_cast<char>(k))), _mm_andnot_si128(closer, index));
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), index);
+#else
+  for(unsigned i = 0; i < 16; ++i)
+  {
+    indices[i] = 0;
+    int best = 256;
+    for(unsigned k = 0; k < 8; ++k)
+    {
+      int distance = std::abs(values[i] - palette[k]);
+      if(distance < best)
+      {
+        best = distance;
+        indices[i] = static_cast<unsigned char>(k);
+      }
+    }
+  }
+#endif
+
+  unsigned long long bits = 0;
+  for(unsigned i = 0; i < 16; ++i)
+    bits |= static_cast<unsigned long long>(indices[i]) << (i * 3);
+
+  destination[0] = hi;
+  destination[1] = lo;
+  for(unsigned b = 0; b < 6; ++b)
+    destination[2 + b] = static_cast<unsigned char>(bits >> (b * 8));
+}
+
+void CompressBlock(const unsigned char rgba[64], BlockFormat format, unsigned char *destination)
+{
+  switch(format)
+  {
+    case BlockBC1:
+      CompressColorBlock(rgba, destination);
+      break;
+    case BlockBC3:
+      CompressChannelBlock(rgba, 3, destination);
+      CompressColorBlock(rgba, destination + 8);
+      break;
+    case BlockBC5:
+      CompressChannelBlock(rgba, 0, destination);
+      CompressChannelBlock(rgba, 1, destination + 8);
+      break;
+  }
+}
+
+void CompressImage(const Image& image, BlockFormat format, unsigned char *destination, unsigned threadCount)
+{
+  unsigned blocksWide = std::max(1u, (image.width_ + 3) / 4);
+  unsigned blocksHigh = std::max(1u, (image.height_ + 3) / 4);
+  unsigned blockBytes = BlockBytes(format);
+
+  if(!threadCount)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  threadCount = std::min(threadCount, blocksHigh);
+
+  //Threads take the next row of blocks until there are none left
+  std::atomic<unsigned> nextRow(0);
+  auto work = [&]()
+  {
+    unsigned char block[64];
+    for(unsigned by = nextRow++; by < blocksHigh; by = nextRow++)
+    {
+      for(unsigned bx = 0; bx < blocksWide; ++bx)
+      {
+        //Partial blocks on the right and bottom edges repeat the last texel
+        for(unsigned y = 0; y < 4; ++y)
+          for(unsigned x = 0; x < 4; ++x)
+          {
+            unsigned sx = std::min(bx * 4 + x, image.width_ - 1);
+            unsigned sy = std::min(by * 4 + y, image.height_ - 1);
+            memcpy(&block[(y * 4 + x) * 4], image.Pixel(sx, sy), 4);
+          }
+
+        CompressBlock(block, format, destination + (by * blocksWide + bx) * blockBytes);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(unsigned t = 1; t < threadCount; ++t)
+    threads.push_back(std::thread(work));
+  work();
+  for(unsigned t = 0; t < threads.size(); ++t)
+    threads[t].join();
+}
@@ -0,0 +1,33 @@
+////////////////////////////////////////////////////////
+//* Filename: BlockCompress.h                         //
+//  Author: Colt Johnson                              //
+//  Info: BC1/BC3/BC5 encoding of RGBA images on all  //
+//        cores, using SSE2 where it is available.    //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include "Image.h"
+
+  enum BlockFormat
+  {
+    //RGB, no alpha. 8 bytes per 4x4 block.
+    BlockBC1,
+    //RGB plus interpolated alpha. 16 bytes per block.
+    BlockBC3,
+    //Red and green as two interpolated channels, for normal maps. 16 bytes per block.
+    BlockBC5
+  };
+
+  unsigned BlockBytes(BlockFormat format);
+
+  //Bytes a width x height level takes once compressed, partial blocks round up
+  unsigned CompressedSize(unsigned width, unsigned height, BlockFormat format);
+
+  //Encodes one 4x4 block of RGBA pixels (row by row) to destination
+  void CompressBlock(const unsigned char rgba[64], BlockFormat format, unsigned char *destination);
+
+  //Encodes the whole image into destination (CompressedSize bytes), rows of
+  //blocks are handed out to threadCount threads. 0 uses every core.
+  void CompressImage(const Image& image, BlockFormat format, unsigned char *destination, unsigned threadCount = 0);
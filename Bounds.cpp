@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////
+//* Filename: Bounds.cpp                              //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Bounds.h"
+#include <cfloat>
+
+Aabb EmptyAabb(void)
+{
+  Aabb box;
+  box.min_ = MakeFloat3( FLT_MAX,  FLT_MAX,  FLT_MAX);
+  box.max_ = MakeFloat3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+  return box;
+}
+
+bool IsEmpty(const Aabb& box)
+{
+  return box.min_.x > box.max_.x;
+}
+
+void Grow(Aabb& box, const Float3& point)
+{
+  for(int i = 0; i < 3; ++i)
+  {
+    if(point[i] < box.min_[i])
+      box.min_[i] = point[i];
+    if(point[i] > box.max_[i])
+      box.max_[i] = point[i];
+  }
+}
+
+void Grow(Aabb& box, const Aabb& other)
+{
+  if(IsEmpty(other))
+    return;
+
+  Grow(box, other.min_);
+  Grow(box, other.max_);
+}
+
+Float3 Center(const Aabb& box)
+{
+  return (box.min_ + box.max_) * 0.5f;
+}
+
+static unsigned short QuantizeCoord(float value, float low, float high, bool roundUp)
+{
+  float extent = high - low;
+  if(extent <= 0.0f)
+    return roundUp ? 65535 : 0;
+
+  float scaled = (value - low) / extent * 65535.0f;
+  scaled = roundUp ? std::ceil(scaled) : std::floor(scaled);
+
+  if(scaled < 0.0f)
+    return 0;
+  if(scaled > 65535.0f)
+    return 65535;
+  return static_cast<unsigned short>(scaled);
+}
+
+void QuantizeAabb(const Aabb& box, const Aabb& range, unsigned short quantized[6])
+{
+  for(int i = 0; i < 3; ++i)
+  {
+    quantized[i]     = QuantizeCoord(box.min_[i], range.min_[i], range.max_[i], false);
+    quantized[i + 3] = QuantizeCoord(box.max_[i], range.min_[i], range.max_[i], true);
+  }
+}
+
+Aabb ComputeAabb(const Float3* points, unsigned count)
+{
+  Aabb box = EmptyAabb();
+  for(unsigned i = 0; i < count; ++i)
+    Grow(box, points[i]);
+  return box;
+}
+
+BoundingSphere ComputeSphere(const Float3* points, unsigned count)
+{
+  BoundingSphere sphere;
+  sphere.center_ = MakeFloat3(0, 0, 0);
+  sphere.radius_ = 0.0f;
+
+  if(!count)
+    return sphere;
+
+  //Pick the pair of extreme points along the axis with the widest spread
+  unsigned minIndex[3] = {0, 0, 0};
+  unsigned maxIndex[3] = {0, 0, 0};
+  for(unsigned i = 1; i < count; ++i)
+  {
+    for(int a = 0; a < 3; ++a)
+    {
+      if(points[i][a] < points[minIndex[a]][a])
+        minIndex[a] = i;
+      if(points[i][a] > points[maxIndex[a]][a])
+        maxIndex[a] = i;
+    }
+  }
+
+  int axis = 0;
+  float widest = -1.0f;
+  for(int a = 0; a < 3; ++a)
+  {
+    Float3 span = points[maxIndex[a]] - points[minIndex[a]];
+    float spread = Dot(span, span);
+    if(spread > widest)
+    {
+      widest = spread;
+      axis = a;
+    }
+  }
+
+  const Float3& p0 = points[minIndex[axis]];
+  const Float3& p1 = points[maxIndex[axis]];
+  sphere.center_ = (p0 + p1) * 0.5f;
+  sphere.radius_ = Length(p1 - p0) * 0.5f;
+
+  //Grow the sphere to take in any point that is still outside of it
+  for(unsigned i = 0; i < count; ++i)
+  {
+    Float3 toPoint = points[i] - sphere.center_;
+    float dist = Length(toPoint);
+    if(dist > sphere.radius_)
+    {
+      float newRadius = (sphere.radius_ + dist) * 0.5f;
+      sphere.center_ += toPoint * ((newRadius - sphere.radius_) / dist);
+      sphere.radius_ = newRadius;
+    }
+  }
+
+  return sphere;
+}
@@ -0,0 +1,41 @@
+////////////////////////////////////////////////////////
+//* Filename: Bounds.h                                //
+//  Author: Colt Johnson                              //
+//  Info: Axis aligned boxes and bounding spheres     //
+//        computed over float vertex streams.         //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "MathTypes.h"
+
+  //An empty box has min_ > max_ so that growing it by any point is correct.
+  struct Aabb
+  {
+    Float3 min_;
+    Float3 max_;
+  };
+
+  struct BoundingSphere
+  {
+    Float3 center_;
+    float radius_;
+  };
+
+  Aabb EmptyAabb(void);
+  bool IsEmpty(const Aabb& box);
+  void Grow(Aabb& box, const Float3& point);
+  void Grow(Aabb& box, const Aabb& other);
+  Float3 Center(const Aabb& box);
+
+  //Bounds of count points starting at first
+  Aabb ComputeAabb(const Float3* points, unsigned count);
+
+  //Ritter's approximate bounding sphere of count points starting at first
+  BoundingSphere ComputeSphere(const Float3* points, unsigned count);
+
+  //Stores box as 16 bit fractions of range (min xyz then max xyz). Mins round
+  //down and maxes round up so the decoded box always contains the original.
+  void QuantizeAabb(const Aabb& box, const Aabb& range, unsigned short quantized[6]);
@@ -0,0 +1,422 @@
+////////////////////////////////////////////////////////
+//* Filename: Bvh.cpp                                 //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Bvh.h"
+#include "Bounds.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+
+//Number of buckets centroids are sorted into when looking for a split
+const unsigned BvhBinCount = 16;
+
+//Deeper nodes are always made into leaves so traversal stacks stay small
+const unsigned BvhMaxDepth = 48;
+
+//Leaves are never made bigger than this unless the triangles can't be split
+const unsigned BvhMaxLeafTris = 16;
+
+//Traversal stack size, enough for BvhMaxDepth
+const unsigned BvhStackSize = 64;
+
+static float SurfaceArea(const Aabb& box)
+{
+  if(IsEmpty(box))
+    return 0.0f;
+
+  Float3 d = box.max_ - box.min_;
+  return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static void SetNodeBounds(BvhNode& node, const Aabb& box)
+{
+  for(int i = 0; i < 3; ++i)
+  {
+    node.min_[i] = box.min_[i];
+    node.max_[i] = box.max_[i];
+  }
+}
+
+static BvhNode MakeLeaf(unsigned first, unsigned count, const std::vector<unsigned>& triIndices, const std::vector<Aabb>& triBoxes)
+{
+  Aabb box = EmptyAabb();
+  for(unsigned i = first; i < first + count; ++i)
+    Grow(box, triBoxes[triIndices[i]]);
+
+  BvhNode node;
+  SetNodeBounds(node, box);
+  node.leftFirst_ = first;
+  node.count_ = count;
+  return node;
+}
+
+struct BvhBin
+{
+  Aabb box_;
+  unsigned count_;
+};
+
+struct BvhBuildEntry
+{
+  unsigned node_;
+  unsigned depth_;
+};
+
+void BuildBvh(const Float3* positions, const int* indices, unsigned triCount, Bvh& bvh, unsigned maxLeafTris)
+{
+  bvh.nodes_.clear();
+  bvh.triIndices_.resize(triCount);
+  if(!triCount)
+    return;
+
+  //Cache the bounds and centroid of every triangle
+  std::vector<Aabb> triBoxes(triCount);
+  std::vector<Float3> centroids(triCount);
+  for(unsigned i = 0; i < triCount; ++i)
+  {
+    triBoxes[i] = EmptyAabb();
+    for(int k = 0; k < 3; ++k)
+      Grow(triBoxes[i], positions[indices[i * 3 + k]]);
+
+    centroids[i] = Center(triBoxes[i]);
+    bvh.triIndices_[i] = i;
+  }
+
+  bvh.nodes_.reserve(triCount * 2);
+  bvh.nodes_.push_back(MakeLeaf(0, triCount, bvh.triIndices_, triBoxes));
+
+  std::vector<BvhBuildEntry> stack;
+  BvhBuildEntry root = {0, 0};
+  stack.push_back(root);
+
+  while(!stack.empty())
+  {
+    BvhBuildEntry entry = stack.back();
+    stack.pop_back();
+
+    unsigned first = bvh.nodes_[entry.node_].leftFirst_;
+    unsigned count = bvh.nodes_[entry.node_].count_;
+    if(count <= maxLeafTris || entry.depth_ >= BvhMaxDepth)
+      continue;
+
+    Aabb nodeBox;
+    for(int i = 0; i < 3; ++i)
+    {
+      nodeBox.min_[i] = bvh.nodes_[entry.node_].min_[i];
+      nodeBox.max_[i] = bvh.nodes_[entry.node_].max_[i];
+    }
+
+    //Splits are made on the centroids so both sides always get triangles
+    Aabb centroidBox = EmptyAabb();
+    for(unsigned i = first; i < first + count; ++i)
+      Grow(centroidBox, centroids[bvh.triIndices_[i]]);
+
+    int bestAxis = -1;
+    unsigned bestSplit = 0;
+    float bestCost = FLT_MAX;
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+      float low = centroidBox.min_[axis];
+      float extent = centroidBox.max_[axis] - low;
+      if(extent <= 0.0f)
+        continue;
+
+      BvhBin bins[BvhBinCount];
+      for(unsigned b = 0; b < BvhBinCount; ++b)
+      {
+        bins[b].box_ = EmptyAabb();
+        bins[b].count_ = 0;
+      }
+
+      float scale = BvhBinCount / extent;
+      for(unsigned i = first; i < first + count; ++i)
+      {
+        unsigned tri = bvh.triIndices_[i];
+        unsigned b = std::min(BvhBinCount - 1, static_cast<unsigned>((centroids[tri][axis] - low) * scale));
+        Grow(bins[b].box_, triBoxes[tri]);
+        ++bins[b].count_;
+      }
+
+      //Sweep from the right to get the area and count on the right of every split
+      float rightArea[BvhBinCount];
+      unsigned rightCount[BvhBinCount];
+      Aabb rightBox = EmptyAabb();
+      unsigned rightSum = 0;
+      for(unsigned b = BvhBinCount - 1; b > 0; --b)
+      {
+        Grow(rightBox, bins[b].box_);
+        rightSum += bins[b].count_;
+        rightArea[b] = SurfaceArea(rightBox);
+        rightCount[b] = rightSum;
+      }
+
+      //Then from the left, splitting in front of bin b
+      Aabb leftBox = EmptyAabb();
+      unsigned leftSum = 0;
+      for(unsigned b = 1; b < BvhBinCount; ++b)
+      {
+        Grow(leftBox, bins[b - 1].box_);
+        leftSum += bins[b - 1].count_;
+        if(!leftSum || !rightCount[b])
+          continue;
+
+        float cost = SurfaceArea(leftBox) * leftSum + rightArea[b] * rightCount[b];
+        if(cost < bestCost)
+        {
+          bestCost = cost;
+          bestAxis = axis;
+          bestSplit = b;
+        }
+      }
+    }
+
+    //All centroids in the same spot, nothing to split on
+    if(bestAxis < 0)
+      continue;
+
+    //Compare against intersecting every triangle in this node, with a traversal step costing one triangle test
+    float parentArea = SurfaceArea(nodeBox);
+    float splitCost = 1.0f + (parentArea > 0.0f ? bestCost / parentArea : 0.0f);
+    if(splitCost >= count && count <= BvhMaxLeafTris)
+      continue;
+
+    float low = centroidBox.min_[bestAxis];
+    float scale = BvhBinCount / (centroidBox.max_[bestAxis] - low);
+    unsigned *begin = &bvh.triIndices_[first];
+    unsigned *mid = std::partition(begin, begin + count, [&](unsigned tri)
+    {
+      unsigned b = std::min(BvhBinCount - 1, static_cast<unsigned>((centroids[tri][bestAxis] - low) * scale));
+      return b < bestSplit;
+    });
+
+    unsigned leftCount = static_cast<unsigned>(mid - begin);
+    if(!leftCount || leftCount == count)
+      continue;
+
+    //Children are stored next to each other
+    unsigned leftIndex = bvh.nodes_.size();
+    bvh.nodes_.push_back(MakeLeaf(first, leftCount, bvh.triIndices_, triBoxes));
+    bvh.nodes_.push_back(MakeLeaf(first + leftCount, count - leftCount, bvh.triIndices_, triBoxes));
+
+    bvh.nodes_[entry.node_].leftFirst_ = leftIndex;
+    bvh.nodes_[entry.node_].count_ = 0;
+
+    BvhBuildEntry left = {leftIndex, entry.depth_ + 1};
+    BvhBuildEntry right = {leftIndex + 1, entry.depth_ + 1};
+    stack.push_back(right);
+    stack.push_back(left);
+  }
+}
+
+//Slab test, giving the distance the ray enters the box at
+static bool IntersectNode(const BvhNode& node, const Float3& origin, const Float3& invDir, float tMax, float& tEnter)
+{
+  float t0 = 0.0f;
+  float t1 = tMax;
+  for(int a = 0; a < 3; ++a)
+  {
+    float tNear = (node.min_[a] - origin[a]) * invDir[a];
+    float tFar  = (node.max_[a] - origin[a]) * invDir[a];
+    if(tNear > tFar)
+      std::swap(tNear, tFar);
+
+    t0 = std::max(t0, tNear);
+    t1 = std::min(t1, tFar);
+  }
+
+  tEnter = t0;
+  return t0 <= t1;
+}
+
+//Moller-Trumbore, two sided
+static bool IntersectTriangle(const Float3& origin, const Float3& dir, const Float3& p0, const Float3& p1, const Float3& p2, float& t)
+{
+  Float3 edge1 = p1 - p0;
+  Float3 edge2 = p2 - p0;
+  Float3 pvec = Cross(dir, edge2);
+  float det = Dot(edge1, pvec);
+  if(std::fabs(det) < 1e-12f)
+    return false;
+
+  float invDet = 1.0f / det;
+  Float3 tvec = origin - p0;
+  float u = Dot(tvec, pvec) * invDet;
+  if(u < 0.0f || u > 1.0f)
+    return false;
+
+  Float3 qvec = Cross(tvec, edge1);
+  float v = Dot(dir, qvec) * invDet;
+  if(v < 0.0f || u + v > 1.0f)
+    return false;
+
+  t = Dot(edge2, qvec) * invDet;
+  return t > 0.0f;
+}
+
+bool IntersectBvh(const Bvh& bvh, const Float3* positions, const int* indices,
+                  const Float3& origin, const Float3& dir, float tMax, BvhHit& hit)
+{
+  if(bvh.nodes_.empty())
+    return false;
+
+  Float3 invDir;
+  for(int a = 0; a < 3; ++a)
+    invDir[a] = dir[a] != 0.0f ? 1.0f / dir[a] : (dir[a] < 0.0f ? -FLT_MAX : FLT_MAX);
+
+  hit.t_ = tMax;
+  bool found = false;
+
+  unsigned stack[BvhStackSize];
+  unsigned stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while(stackSize)
+  {
+    const BvhNode& node = bvh.nodes_[stack[--stackSize]];
+    float tEnter;
+    if(!IntersectNode(node, origin, invDir, hit.t_, tEnter))
+      continue;
+
+    if(node.count_)
+    {
+      for(unsigned i = node.leftFirst_; i < node.leftFirst_ + node.count_; ++i)
+      {
+        unsigned tri = bvh.triIndices_[i];
+        float t;
+        if(IntersectTriangle(origin, dir, positions[indices[tri * 3]], positions[indices[tri * 3 + 1]], positions[indices[tri * 3 + 2]], t) && t < hit.t_)
+        {
+          hit.t_ = t;
+          hit.tri_ = tri;
+          found = true;
+        }
+      }
+      continue;
+    }
+
+    //Visit the nearer child first so the far one can be culled by the closer hit
+    unsigned near = node.leftFirst_;
+    unsigned far = node.leftFirst_ + 1;
+    float tNear, tFar;
+    bool hitNear = IntersectNode(bvh.nodes_[near], origin, invDir, hit.t_, tNear);
+    bool hitFar  = IntersectNode(bvh.nodes_[far],  origin, invDir, hit.t_, tFar);
+    if(hitNear && hitFar && tFar < tNear)
+      std::swap(near, far);
+    else if(!hitNear)
+    {
+      near = far;
+      hitNear = hitFar;
+      hitFar = false;
+    }
+
+    if(hitFar)
+      stack[stackSize++] = far;
+    if(hitNear)
+      stack[stackSize++] = near;
+  }
+
+  return found;
+}
+
+bool OccludedBvh(const Bvh& bvh, const Float3* positions, const int* indices,
+                 const Float3& origin, const Float3& dir, float tMax)
+{
+  if(bvh.nodes_.empty())
+    return false;
+
+  Float3 invDir;
+  for(int a = 0; a < 3; ++a)
+    invDir[a] = dir[a] != 0.0f ? 1.0f / dir[a] : (dir[a] < 0.0f ? -FLT_MAX : FLT_MAX);
+
+  unsigned stack[BvhStackSize];
+  unsigned stackSize = 0;
+  stack[stackSize++] = 0;
+
+  //Order doesn't matter when any hit will do, so children are pushed as they are
+  while(stackSize)
+  {
+    const BvhNode& node = bvh.nodes_[stack[--stackSize]];
+    float tEnter;
+    if(!IntersectNode(node, origin, invDir, tMax, tEnter))
+      continue;
+
+    if(!node.count_)
+    {
+      stack[stackSize++] = node.leftFirst_ + 1;
+      stack[stackSize++] = node.leftFirst_;
+      continue;
+    }
+
+    for(unsigned i = node.leftFirst_; i < node.leftFirst_ + node.count_; ++i)
+    {
+      unsigned tri = bvh.triIndices_[i];
+      float t;
+      if(IntersectTriangle(origin, dir, positions[indices[tri * 3]], positions[indices[tri * 3 + 1]], positions[indices[tri * 3 + 2]], t) && t < tMax)
+        return true;
+    }
+  }
+
+  return false;
+}
+
+//Small deterministic generator so benchmark runs are comparable
+static float BenchRandom(unsigned& state)
+{
+  state = state * 1664525u + 1013904223u;
+  return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+void BenchmarkBvh(const Bvh& bvh, const Float3* positions, const int* indices, unsigned rayCount)
+{
+  if(bvh.nodes_.empty() || !rayCount)
+    return;
+
+  const BvhNode& root = bvh.nodes_[0];
+  Aabb box;
+  for(int i = 0; i < 3; ++i)
+  {
+    box.min_[i] = root.min_[i];
+    box.max_[i] = root.max_[i];
+  }
+  Float3 center = Center(box);
+  float radius = Length(box.max_ - box.min_);
+
+  //Rays start on a sphere around the mesh and aim at a point inside its bounds
+  std::vector<Float3> origins(rayCount);
+  std::vector<Float3> dirs(rayCount);
+  unsigned state = 12345;
+  for(unsigned i = 0; i < rayCount; ++i)
+  {
+    Float3 onSphere = MakeFloat3(BenchRandom(state) * 2 - 1, BenchRandom(state) * 2 - 1, BenchRandom(state) * 2 - 1);
+    Normalize(onSphere);
+    origins[i] = center + onSphere * radius;
+
+    Float3 target;
+    for(int a = 0; a < 3; ++a)
+      target[a] = box.min_[a] + (box.max_[a] - box.min_[a]) * BenchRandom(state);
+
+    dirs[i] = target - origins[i];
+    Normalize(dirs[i]);
+  }
+
+  unsigned hits = 0;
+  std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+  for(unsigned i = 0; i < rayCount; ++i)
+  {
+    BvhHit hit;
+    if(IntersectBvh(bvh, positions, indices, origins[i], dirs[i], FLT_MAX, hit))
+      ++hits;
+  }
+  std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+  double ms = std::chrono::duration<double, std::milli>(end - start).count();
+  printf("BVH benchmark: %u nodes, %u rays, %u hits, %.3f ms (%.2f Mrays/s)\n",
+         static_cast<unsigned>(bvh.nodes_.size()), rayCount, hits, ms,
+         ms > 0.0 ? rayCount / (ms * 1000.0) : 0.0);
+}
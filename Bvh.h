@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////
+//* Filename: Bvh.h                                   //
+//  Author: Colt Johnson                              //
+//  Info: Flat SAH bounding volume hierarchy over a   //
+//        triangle list for CPU ray queries.          //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "MathTypes.h"
+
+  //32 byte node. Interior nodes have a zero count and leftFirst_ is the index of
+  //their first child (the second child directly follows it). Leaves store the
+  //first entry in Bvh::triIndices_ in leftFirst_ and how many follow in count_.
+  struct BvhNode
+  {
+    float min_[3];
+    unsigned leftFirst_;
+    float max_[3];
+    unsigned count_;
+  };
+
+  struct Bvh
+  {
+    //nodes_[0] is the root
+    std::vector<BvhNode> nodes_;
+
+    //Triangle numbers (index buffer offset / 3) in leaf order
+    std::vector<unsigned> triIndices_;
+  };
+
+  struct BvhHit
+  {
+    float t_;
+    unsigned tri_;
+  };
+
+  //Builds with binned surface area heuristic splits, stopping at maxLeafTris
+  void BuildBvh(const Float3* positions, const int* indices, unsigned triCount, Bvh& bvh, unsigned maxLeafTris = 4);
+
+  //Closest hit along origin + t * dir for t in (0, tMax). Returns false on a miss.
+  bool IntersectBvh(const Bvh& bvh, const Float3* positions, const int* indices,
+                    const Float3& origin, const Float3& dir, float tMax, BvhHit& hit);
+
+  //Any hit along origin + t * dir for t in (0, tMax). Stops at the first triangle
+  //found, which makes it the cheaper query for shadow and occlusion rays.
+  bool OccludedBvh(const Bvh& bvh, const Float3* positions, const int* indices,
+                   const Float3& origin, const Float3& dir, float tMax);
+
+  //Casts rayCount random rays through the mesh bounds and prints the throughput
+  void BenchmarkBvh(const Bvh& bvh, const Float3* positions, const int* indices, unsigned rayCount);
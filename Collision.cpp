@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////
+//* Filename: Collision.cpp                           //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Collision.h"
+#include "Voxels.h"
+#include "Bounds.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+//Pieces whose hull wastes less than this fraction of the solid's volume are left whole
+const float CollisionConcavity = 0.01f;
+
+//Cut positions tried along each axis of a piece
+const int CollisionCutsPerAxis = 7;
+
+//Runs task for 0 to count - 1 on up to threadCount threads
+static void ParallelFor(unsigned count, unsigned threadCount, const std::function<void(unsigned)>& task)
+{
+  threadCount = std::max(1u, std::min(threadCount, count));
+
+  std::atomic<unsigned> next(0);
+  auto work = [&]()
+  {
+    for(unsigned i = next++; i < count; i = next++)
+      task(i);
+  };
+
+  std::vector<std::thread> threads;
+  for(unsigned t = 1; t < threadCount; ++t)
+    threads.push_back(std::thread(work));
+  work();
+  for(unsigned t = 0; t < threads.size(); ++t)
+    threads[t].join();
+}
+
+//Solid cells the decomposition has grouped together
+struct CollisionPiece
+{
+  std::vector<unsigned> cells_;
+  int lo_[3];
+  int hi_[3];
+
+  //Hull volume not covered by the cells
+  float waste_;
+  //No cut made it any better
+  bool whole_;
+};
+
+//A piece, or one side of a cut through it: side_ 0 has the cells below cut_
+//on axis_, side_ 1 the rest. An axis_ of -1 is the whole piece.
+struct PieceSide
+{
+  int axis_;
+  int cut_;
+  int side_;
+};
+
+static bool OnSide(const int coords[3], const PieceSide& side)
+{
+  return side.axis_ < 0 || (coords[side.axis_] < side.cut_) == (side.side_ == 0);
+}
+
+static void SetRange(const VoxelGrid& grid, CollisionPiece& piece)
+{
+  for(int a = 0; a < 3; ++a)
+  {
+    piece.lo_[a] = grid.dims_[a];
+    piece.hi_[a] = -1;
+  }
+
+  for(unsigned i = 0; i < piece.cells_.size(); ++i)
+  {
+    int coords[3];
+    grid.Coords(piece.cells_[i], coords);
+    for(int a = 0; a < 3; ++a)
+    {
+      piece.lo_[a] = std::min(piece.lo_[a], coords[a]);
+      piece.hi_[a] = std::max(piece.hi_[a], coords[a]);
+    }
+  }
+}
+
+//How much of the solid a cell holds. Surface cells are taken as half full and
+//nothing outside the mesh's bounds counts.
+static float CellVolume(const VoxelGrid& grid, const int coords[3], const Aabb& bounds)
+{
+  Float3 lo = grid.Corner(coords[0], coords[1], coords[2]);
+  float volume = grid.cells_[grid.Index(coords[0], coords[1], coords[2])] == VoxelSurface ? 0.5f : 1.0f;
+  for(int a = 0; a < 3; ++a)
+    volume *= std::max(0.0f, std::min(lo[a] + grid.cellSize_, bounds.max_[a]) - std::max(lo[a], bounds.min_[a]));
+  return volume;
+}
+
+//Corners of the cells on the side that face something off it, the only ones
+//that can be on its hull. They are kept inside the mesh's bounds. Returns the
+//volume of the side's cells.
+static float SidePoints(const VoxelGrid& grid, const std::vector<int>& owner, int piece,
+                           const std::vector<unsigned>& cells, const PieceSide& side,
+                           const Aabb& bounds, std::vector<Float3>& points)
+{
+  const int cornerDims[3] = {grid.dims_[0] + 1, grid.dims_[1] + 1, grid.dims_[2] + 1};
+
+  float volume = 0.0f;
+  std::vector<unsigned> corners;
+  for(unsigned i = 0; i < cells.size(); ++i)
+  {
+    int coords[3];
+    grid.Coords(cells[i], coords);
+    if(!OnSide(coords, side))
+      continue;
+    volume += CellVolume(grid, coords, bounds);
+
+    bool boundary = false;
+    for(int s = 0; s < 6 && !boundary; ++s)
+    {
+      int n[3] = {coords[0] + VoxelSteps[s][0], coords[1] + VoxelSteps[s][1], coords[2] + VoxelSteps[s][2]};
+      boundary = !grid.Contains(n) || owner[grid.Index(n[0], n[1], n[2])] != piece || !OnSide(n, side);
+    }
+    if(!boundary)
+      continue;
+
+    for(int c = 0; c < 8; ++c)
+    {
+      int x = coords[0] + (c & 1), y = coords[1] + ((c >> 1) & 1), z = coords[2] + (c >> 2);
+      corners.push_back((z * cornerDims[1] + y) * cornerDims[0] + x);
+    }
+  }
+
+  std::sort(corners.begin(), corners.end());
+  corners.erase(std::unique(corners.begin(), corners.end()), corners.end());
+
+  points.clear();
+  for(unsigned i = 0; i < corners.size(); ++i)
+  {
+    int x = corners[i] % cornerDims[0];
+    int y = (corners[i] / cornerDims[0]) % cornerDims[1];
+    int z = corners[i] / (cornerDims[0] * cornerDims[1]);
+    Float3 p = grid.Corner(x, y, z);
+    for(int a = 0; a < 3; ++a)
+      p[a] = std::min(std::max(p[a], bounds.min_[a]), bounds.max_[a]);
+    points.push_back(p);
+  }
+  return volume;
+}
+
+static float SideWaste(const VoxelGrid& grid, const std::vector<int>& owner, int piece,
+                       const std::vector<unsigned>& cells, const PieceSide& side, const Aabb& bounds)
+{
+  std::vector<Float3> points;
+  float volume = SidePoints(grid, owner, piece, cells, side, bounds, points);
+
+  ConvexHull hull;
+  if(points.empty() || !BuildConvexHull(&points[0], points.size(), 0, hull))
+    return 0.0f;
+
+  return std::max(0.0f, hull.volume_ - volume);
+}
+
+void DecomposeConvex(const Float3* positions, const int* indices, unsigned indexCount,
+                     const CollisionSettings& settings, std::vector<ConvexHull>& parts,
+                     unsigned threadCount)
+{
+  parts.clear();
+  if(settings.maxHulls_ < 2)
+    return;
+
+  if(!threadCount)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+  VoxelGrid grid;
+  VoxelizeSolid(positions, indices, indexCount, settings.resolution_, grid);
+  if(grid.cells_.empty())
+    return;
+
+  Aabb bounds = EmptyAabb();
+  for(unsigned i = 0; i < indexCount; ++i)
+    Grow(bounds, positions[indices[i]]);
+
+  //Open meshes have no inside, their pieces are cut from the surface shell
+  std::vector<int> owner(grid.cells_.size(), -1);
+  std::vector<CollisionPiece> pieces(1);
+  float solidVolume = 0.0f;
+  for(unsigned i = 0; i < grid.cells_.size(); ++i)
+  {
+    if(grid.cells_[i] == VoxelSurface || grid.cells_[i] == VoxelInside)
+    {
+      int coords[3];
+      grid.Coords(i, coords);
+      solidVolume += CellVolume(grid, coords, bounds);
+      pieces[0].cells_.push_back(i);
+      owner[i] = 0;
+    }
+  }
+
+  const PieceSide whole = {-1, 0, 0};
+  float wasteLimit = CollisionConcavity * solidVolume;
+  SetRange(grid, pieces[0]);
+  pieces[0].waste_ = SideWaste(grid, owner, 0, pieces[0].cells_, whole, bounds);
+  pieces[0].whole_ = false;
+
+  while(pieces.size() < settings.maxHulls_)
+  {
+    int worst = -1;
+    for(unsigned p = 0; p < pieces.size(); ++p)
+      if(!pieces[p].whole_ && pieces[p].waste_ > wasteLimit && (worst < 0 || pieces[p].waste_ > pieces[worst].waste_))
+        worst = p;
+    if(worst < 0)
+      break;
+
+    //Evenly spaced cuts through the piece's cells on every axis
+    CollisionPiece& piece = pieces[worst];
+    std::vector<PieceSide> cuts;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+      int span = piece.hi_[axis] - piece.lo_[axis] + 1;
+      int steps = std::min(CollisionCutsPerAxis, span - 1);
+      for(int k = 1; k <= steps; ++k)
+      {
+        PieceSide cut = {axis, piece.lo_[axis] + span * k / (steps + 1), 0};
+        if(cuts.empty() || cuts.back().axis_ != axis || cuts.back().cut_ != cut.cut_)
+          cuts.push_back(cut);
+      }
+    }
+
+    //Both sides of every cut are hulled at the same time
+    std::vector<float> waste(cuts.size() * 2);
+    ParallelFor(waste.size(), threadCount, [&](unsigned i)
+    {
+      PieceSide side = cuts[i / 2];
+      side.side_ = i & 1;
+      waste[i] = SideWaste(grid, owner, worst, piece.cells_, side, bounds);
+    });
+
+    int best = -1;
+    for(unsigned c = 0; c < cuts.size(); ++c)
+      if(best < 0 || waste[c * 2] + waste[c * 2 + 1] < waste[best * 2] + waste[best * 2 + 1])
+        best = c;
+
+    if(best < 0 || waste[best * 2] + waste[best * 2 + 1] >= piece.waste_)
+    {
+      piece.whole_ = true;
+      continue;
+    }
+
+    CollisionPiece upper;
+    std::vector<unsigned> lower;
+    int newPiece = pieces.size();
+    for(unsigned i = 0; i < piece.cells_.size(); ++i)
+    {
+      int coords[3];
+      grid.Coords(piece.cells_[i], coords);
+      if(OnSide(coords, cuts[best]))
+        lower.push_back(piece.cells_[i]);
+      else
+      {
+        upper.cells_.push_back(piece.cells_[i]);
+        owner[piece.cells_[i]] = newPiece;
+      }
+    }
+
+    piece.cells_.swap(lower);
+    piece.waste_ = waste[best * 2];
+    SetRange(grid, piece);
+
+    upper.waste_ = waste[best * 2 + 1];
+    upper.whole_ = false;
+    SetRange(grid, upper);
+    pieces.push_back(upper);
+  }
+
+  //Final hulls of every piece, with the vertex limit this time
+  parts.resize(pieces.size());
+  ParallelFor(pieces.size(), threadCount, [&](unsigned p)
+  {
+    std::vector<Float3> points;
+    SidePoints(grid, owner, p, pieces[p].cells_, whole, bounds, points);
+    if(!points.empty())
+      BuildConvexHull(&points[0], points.size(), settings.maxHullVerts_, parts[p]);
+  });
+
+  unsigned kept = 0;
+  for(unsigned p = 0; p < parts.size(); ++p)
+    if(!parts[p].indices_.empty())
+      std::swap(parts[kept++], parts[p]);
+  parts.resize(kept);
+}
+
+void CookCollision(const Float3* positions, const int* indices, const std::vector<CollisionRange>& ranges,
+                   const CollisionSettings& settings, std::vector<CollisionShape>& shapes,
+                   unsigned threadCount)
+{
+  shapes.assign(ranges.size(), CollisionShape());
+  if(ranges.empty())
+    return;
+
+  if(!threadCount)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  unsigned workers = std::min<unsigned>(threadCount, ranges.size());
+  unsigned helpers = std::max(1u, threadCount / workers);
+
+  ParallelFor(ranges.size(), workers, [&](unsigned r)
+  {
+    const int *first = indices + ranges[r].indexStart_;
+    unsigned count = ranges[r].indexCount_;
+    CollisionShape& shape = shapes[r];
+
+    //Each vertex the triangles use once
+    std::vector<int> used(first, first + count);
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+
+    std::vector<Float3> points(used.size());
+    for(unsigned i = 0; i < used.size(); ++i)
+      points[i] = positions[used[i]];
+
+    if(!points.empty())
+      BuildConvexHull(&points[0], points.size(), settings.maxHullVerts_, shape.hull_);
+
+    DecomposeConvex(positions, first, count, settings, shape.parts_, helpers);
+  });
+}
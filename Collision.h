@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////
+//* Filename: Collision.h                             //
+//  Author: Colt Johnson                              //
+//  Info: Cooks convex collision shapes, a hull per   //
+//        mesh plus an optional decomposition.        //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "ConvexHull.h"
+
+  struct CollisionSettings
+  {
+    //Pieces the decomposition may cut a mesh into, 1 or less skips it
+    unsigned maxHulls_;
+    //Most vertices a hull may keep, 0 is no limit
+    unsigned maxHullVerts_;
+    //Cells along the longest side of a mesh when voxelizing it
+    unsigned resolution_;
+  };
+
+  //The triangles of one mesh, indices_[indexStart_] onwards
+  struct CollisionRange
+  {
+    unsigned indexStart_;
+    unsigned indexCount_;
+  };
+
+  struct CollisionShape
+  {
+    //Hull of every vertex the triangles use, empty when they are flat
+    ConvexHull hull_;
+    //Convex pieces that together roughly make up the solid, only with maxHulls_ > 1
+    std::vector<ConvexHull> parts_;
+  };
+
+  //Voxelizes the solid and keeps cutting the piece whose hull wastes the most
+  //volume with the axis aligned plane that leaves the least waste, until there
+  //are maxHulls_ pieces or all of them are close to convex. The pieces' hulls
+  //are taken over their cells' corners, so they can stand out of the mesh by
+  //up to a cell.
+  void DecomposeConvex(const Float3* positions, const int* indices, unsigned indexCount,
+                       const CollisionSettings& settings, std::vector<ConvexHull>& parts,
+                       unsigned threadCount = 0);
+
+  //Cooks a shape per range. Meshes are spread over threadCount threads (0 uses
+  //every core) and the threads left over help with each decomposition's cuts
+  //and hulls. The result is the same however many threads run.
+  void CookCollision(const Float3* positions, const int* indices, const std::vector<CollisionRange>& ranges,
+                     const CollisionSettings& settings, std::vector<CollisionShape>& shapes,
+                     unsigned threadCount = 0);
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////
+//* Filename: ConvertApi.cpp                          //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Precompiled.h"
+#include "ConvertApi.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <atomic>
+#ifndef _WIN32
+  #include <unistd.h>
+#endif
+
+//Tells apart temp files from conversions running at the same time
+static std::atomic<unsigned> TempCounter(0);
+
+//Unique path in the system temp directory ending in extension
+static std::string MakeTempPath(const std::string& extension)
+{
+  char name[128];
+#ifdef _WIN32
+  char dir[MAX_PATH];
+  if(!GetTempPathA(MAX_PATH, dir))
+    strcpy(dir, ".\\");
+  sprintf(name, "gmf_%lu_%u", GetCurrentProcessId(), TempCounter++);
+#else
+  const char *tmp = getenv("TMPDIR");
+  std::string dir = std::string(tmp ? tmp : "/tmp") + "/";
+  sprintf(name, "gmf_%d_%u", static_cast<int>(getpid()), TempCounter++);
+#endif
+  return std::string(dir) + name + extension;
+}
+
+//Runs the stages on a scene that will be read from path
+static bool Convert(const char *path, const char *outputName, const ConvertOptions& options, ConvertResult& result)
+{
+  Scene scene(path, options);
+  scene.SetOutputName(outputName);
+
+  bool loaded;
+  {
+    StageTimer timer(result.timings_, "load");
+    loaded = scene.LoadScene();
+  }
+  if(!loaded)
+  {
+    printf("Failed to load scene!\n");
+    return false;
+  }
+
+  bool extracted = scene.ExtractScene();
+  scene.TakeTimings(result.timings_);
+  if(!extracted)
+  {
+    printf("Failed to extract scene!\n");
+    return false;
+  }
+
+  {
+    StageTimer timer(result.timings_, "save");
+    scene.SaveScene();
+  }
+  scene.TakeOutputs(result.files_);
+  return true;
+}
+
+bool ConvertFile(const char *path, const ConvertOptions& options, ConvertResult& result)
+{
+  return Convert(path, path, options, result);
+}
+
+bool ConvertMemory(const void *data, size_t size, const char *name, const ConvertOptions& options, ConvertResult& result)
+{
+  //The 2012 importer only reads files, hand it a private copy
+  std::string nameStr(name);
+  size_t extension = nameStr.find_last_of(".");
+  std::string tempPath = MakeTempPath(extension == std::string::npos ? ".fbx" : nameStr.substr(extension));
+
+  FILE *fp = fopen(tempPath.c_str(), "wb");
+  if(!fp)
+  {
+    printf("Couldn't open %s for writing!\n", tempPath.c_str());
+    return false;
+  }
+  bool written = fwrite(data, size, 1, fp) == 1;
+  if(fclose(fp) || !written)
+  {
+    printf("Couldn't write %s!\n", tempPath.c_str());
+    remove(tempPath.c_str());
+    return false;
+  }
+
+  bool converted = Convert(tempPath.c_str(), name, options, result);
+  remove(tempPath.c_str());
+  return converted;
+}
+
+bool SaveOutputs(const ConvertResult& result)
+{
+  //Shared files go first so the outputs referring to them know if they made it
+  bool saved = true;
+  std::vector<std::string> unsaved;
+  for(unsigned i = 0; i < result.files_.size(); ++i)
+  {
+    const OutputFile& file = result.files_[i];
+    if(file.shared_ && !SaveOutputFile(file))
+      unsaved.push_back(file.name_);
+  }
+
+  for(unsigned i = 0; i < result.files_.size(); ++i)
+  {
+    const OutputFile& file = result.files_[i];
+    if(file.shared_)
+      continue;
+
+    if(!file.dependency_.empty() && std::find(unsaved.begin(), unsaved.end(), file.dependency_) != unsaved.end())
+    {
+      printf("Writing %s without %s\n", file.name_.c_str(), file.dependency_.c_str());
+      saved = SaveOutputFile(WithoutDependency(file)) && saved;
+    }
+    else
+      saved = SaveOutputFile(file) && saved;
+  }
+
+  //A shared file nothing could fall back from is simply missing
+  for(unsigned i = 0; i < unsaved.size(); ++i)
+  {
+    bool covered = false;
+    for(unsigned f = 0; f < result.files_.size() && !covered; ++f)
+      covered = result.files_[f].dependency_ == unsaved[i];
+    saved = saved && covered;
+  }
+  return saved;
+}
@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////
+//* Filename: ConvertApi.h                            //
+//  Author: Colt Johnson                              //
+//  Info: Entry points for running the converter in   //
+//        process, outputs stay in memory.            //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include "Options.h"
+#include "OutputBuffer.h"
+#include "StageTimer.h"
+
+  struct ConvertResult
+  {
+    //Every file the conversion made (.gmf, clips, skeleton, grid and cells) in the
+    //order they were made. The buffers belong to the result, swap them out to keep them.
+    std::vector<OutputFile> files_;
+
+    //Wall clock time of every stage that ran, load and save included
+    std::vector<StageTime> timings_;
+  };
+
+  //Converts an FBX file on disk. Outputs are named the way the command line tool names them.
+  bool ConvertFile(const char *path, const ConvertOptions& options, ConvertResult& result);
+
+  //Converts an FBX file held in memory. name stands in for the file name, its
+  //extension tells the importer the format and the outputs are named after it.
+  bool ConvertMemory(const void *data, size_t size, const char *name, const ConvertOptions& options, ConvertResult& result);
+
+  //Saves every output under its name, returns false if any of them failed.
+  //Shared outputs already on disk are kept, an output whose shared dependency
+  //can't be saved is written without it (a .gmf then embeds its skeleton).
+  bool SaveOutputs(const ConvertResult& result);
+
+  //Both Convert functions can run on several threads at once. The FBX SDK
+  //parts take turns, everything after the import runs in parallel.
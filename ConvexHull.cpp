@@ -0,0 +1,310 @@
+////////////////////////////////////////////////////////
+//* Filename: ConvexHull.cpp                          //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "ConvexHull.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+
+//Points closer than this fraction of the point set's size to a face count as on it
+const double HullPlaneTolerance = 1e-6;
+
+//The hull is built in doubles so nearly coplanar faces don't fold over
+struct HullVec
+{
+  double x, y, z;
+};
+
+static HullVec MakeHullVec(const Float3& p)
+{
+  HullVec v = {p.x, p.y, p.z};
+  return v;
+}
+
+static HullVec Sub(const HullVec& a, const HullVec& b)
+{
+  HullVec v = {a.x - b.x, a.y - b.y, a.z - b.z};
+  return v;
+}
+
+static double Dot(const HullVec& a, const HullVec& b)
+{
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static HullVec Cross(const HullVec& a, const HullVec& b)
+{
+  HullVec v = {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+  return v;
+}
+
+struct HullFace
+{
+  int v_[3];
+  HullVec normal_;
+  double offset_;
+  bool live_;
+
+  //Points in front of this face and no other face picked before it
+  std::vector<unsigned> outside_;
+  unsigned furthest_;
+  double furthestDistance_;
+};
+
+static double Distance(const HullFace& face, const HullVec& p)
+{
+  return Dot(face.normal_, p) - face.offset_;
+}
+
+static HullFace MakeFace(const std::vector<HullVec>& points, int a, int b, int c)
+{
+  HullFace face;
+  face.v_[0] = a;
+  face.v_[1] = b;
+  face.v_[2] = c;
+  face.normal_ = Cross(Sub(points[b], points[a]), Sub(points[c], points[a]));
+  double length = std::sqrt(Dot(face.normal_, face.normal_));
+  if(length > 0.0)
+  {
+    face.normal_.x /= length;
+    face.normal_.y /= length;
+    face.normal_.z /= length;
+  }
+  face.offset_ = Dot(face.normal_, points[a]);
+  face.live_ = true;
+  face.furthest_ = 0;
+  face.furthestDistance_ = 0.0;
+  return face;
+}
+
+//Gives the point to the face it is furthest in front of, if any
+static void AssignPoint(std::vector<HullFace>& faces, unsigned firstFace, const std::vector<HullVec>& points,
+                        unsigned point, double tolerance)
+{
+  unsigned best = 0;
+  double bestDistance = tolerance;
+  for(unsigned f = firstFace; f < faces.size(); ++f)
+  {
+    if(!faces[f].live_)
+      continue;
+
+    double d = Distance(faces[f], points[point]);
+    if(d > bestDistance)
+    {
+      bestDistance = d;
+      best = f + 1;
+    }
+  }
+
+  if(!best)
+    return;
+
+  HullFace& face = faces[best - 1];
+  face.outside_.push_back(point);
+  if(bestDistance > face.furthestDistance_)
+  {
+    face.furthestDistance_ = bestDistance;
+    face.furthest_ = point;
+  }
+}
+
+//Four points spanning a tetrahedron as big as can be found quickly, false when flat
+static bool InitialSimplex(const std::vector<HullVec>& points, double tolerance, int simplex[4])
+{
+  //The extreme points on each axis
+  unsigned extremes[6] = {0, 0, 0, 0, 0, 0};
+  for(unsigned i = 1; i < points.size(); ++i)
+  {
+    const double *p = &points[i].x;
+    for(int a = 0; a < 3; ++a)
+    {
+      if(p[a] < (&points[extremes[a * 2]].x)[a])
+        extremes[a * 2] = i;
+      if(p[a] > (&points[extremes[a * 2 + 1]].x)[a])
+        extremes[a * 2 + 1] = i;
+    }
+  }
+
+  //The two extremes furthest apart
+  double best = 0.0;
+  for(int i = 0; i < 6; ++i)
+  {
+    for(int j = i + 1; j < 6; ++j)
+    {
+      HullVec d = Sub(points[extremes[i]], points[extremes[j]]);
+      if(Dot(d, d) > best)
+      {
+        best = Dot(d, d);
+        simplex[0] = extremes[i];
+        simplex[1] = extremes[j];
+      }
+    }
+  }
+  if(best <= tolerance * tolerance)
+    return false;
+
+  //Furthest from that line
+  HullVec line = Sub(points[simplex[1]], points[simplex[0]]);
+  best = 0.0;
+  for(unsigned i = 0; i < points.size(); ++i)
+  {
+    HullVec c = Cross(line, Sub(points[i], points[simplex[0]]));
+    if(Dot(c, c) > best)
+    {
+      best = Dot(c, c);
+      simplex[2] = i;
+    }
+  }
+  if(best <= tolerance * tolerance * Dot(line, line))
+    return false;
+
+  //Furthest from that plane
+  HullFace base = MakeFace(points, simplex[0], simplex[1], simplex[2]);
+  best = 0.0;
+  for(unsigned i = 0; i < points.size(); ++i)
+  {
+    double d = std::fabs(Distance(base, points[i]));
+    if(d > best)
+    {
+      best = d;
+      simplex[3] = i;
+    }
+  }
+  return best > tolerance;
+}
+
+bool BuildConvexHull(const Float3* points, unsigned count, unsigned maxVerts, ConvexHull& hull)
+{
+  hull.positions_.clear();
+  hull.indices_.clear();
+  hull.volume_ = 0.0f;
+  hull.centroid_ = MakeFloat3(0.0f, 0.0f, 0.0f);
+  if(count < 4)
+    return false;
+
+  std::vector<HullVec> pts(count);
+  double size = 0.0;
+  for(unsigned i = 0; i < count; ++i)
+  {
+    pts[i] = MakeHullVec(points[i]);
+    size = std::max(size, std::max(std::fabs(pts[i].x), std::max(std::fabs(pts[i].y), std::fabs(pts[i].z))));
+  }
+  double tolerance = std::max(size, 1.0) * HullPlaneTolerance;
+
+  int simplex[4] = {0, 0, 0, 0};
+  if(!InitialSimplex(pts, tolerance, simplex))
+    return false;
+
+  //Wind the first face so the fourth point is behind it, the rest follow from its edges
+  std::vector<HullFace> faces;
+  int a = simplex[0], b = simplex[1], c = simplex[2], d = simplex[3];
+  if(Distance(MakeFace(pts, a, b, c), pts[d]) > 0.0)
+    std::swap(b, c);
+  faces.push_back(MakeFace(pts, a, b, c));
+  faces.push_back(MakeFace(pts, a, d, b));
+  faces.push_back(MakeFace(pts, b, d, c));
+  faces.push_back(MakeFace(pts, c, d, a));
+
+  for(int i = 0; i < static_cast<int>(count); ++i)
+    if(i != a && i != b && i != c && i != d)
+      AssignPoint(faces, 0, pts, i, tolerance);
+
+  unsigned vertCount = 4;
+  std::set< std::pair<int, int> > edges;
+  std::vector<unsigned> orphans;
+  while(!maxVerts || vertCount < maxVerts)
+  {
+    //The point furthest out of the whole hull goes in next
+    unsigned from = 0;
+    double furthest = 0.0;
+    for(unsigned f = 0; f < faces.size(); ++f)
+    {
+      if(faces[f].live_ && !faces[f].outside_.empty() && faces[f].furthestDistance_ > furthest)
+      {
+        furthest = faces[f].furthestDistance_;
+        from = f + 1;
+      }
+    }
+    if(!from)
+      break;
+
+    unsigned eye = faces[from - 1].furthest_;
+
+    //Every face the eye can see goes, their points need new homes
+    edges.clear();
+    orphans.clear();
+    for(unsigned f = 0; f < faces.size(); ++f)
+    {
+      HullFace& face = faces[f];
+      if(!face.live_ || Distance(face, pts[eye]) <= tolerance)
+        continue;
+
+      face.live_ = false;
+      for(int e = 0; e < 3; ++e)
+        edges.insert(std::make_pair(face.v_[e], face.v_[(e + 1) % 3]));
+      orphans.insert(orphans.end(), face.outside_.begin(), face.outside_.end());
+      std::vector<unsigned>().swap(face.outside_);
+    }
+
+    //Edges of the seen region with no seen face on the other side make the
+    //horizon, each one gets a face up to the eye
+    unsigned firstNew = faces.size();
+    for(std::set< std::pair<int, int> >::iterator it = edges.begin(); it != edges.end(); ++it)
+      if(!edges.count(std::make_pair(it->second, it->first)))
+        faces.push_back(MakeFace(pts, it->first, it->second, eye));
+
+    for(unsigned i = 0; i < orphans.size(); ++i)
+      if(orphans[i] != eye)
+        AssignPoint(faces, firstNew, pts, orphans[i], tolerance);
+
+    ++vertCount;
+  }
+
+  //Keep only the points the faces use
+  std::vector<int> remap(count, -1);
+  for(unsigned f = 0; f < faces.size(); ++f)
+  {
+    if(!faces[f].live_)
+      continue;
+
+    for(int e = 0; e < 3; ++e)
+    {
+      int v = faces[f].v_[e];
+      if(remap[v] < 0)
+      {
+        remap[v] = hull.positions_.size();
+        hull.positions_.push_back(points[v]);
+      }
+      hull.indices_.push_back(remap[v]);
+    }
+  }
+
+  //Sum of the tetrahedra from the first vertex to every face
+  const HullVec origin = MakeHullVec(hull.positions_[0]);
+  double volume = 0.0;
+  HullVec centroid = {0.0, 0.0, 0.0};
+  for(unsigned i = 0; i < hull.indices_.size(); i += 3)
+  {
+    HullVec p0 = Sub(MakeHullVec(hull.positions_[hull.indices_[i]]), origin);
+    HullVec p1 = Sub(MakeHullVec(hull.positions_[hull.indices_[i + 1]]), origin);
+    HullVec p2 = Sub(MakeHullVec(hull.positions_[hull.indices_[i + 2]]), origin);
+    double v = Dot(p0, Cross(p1, p2)) / 6.0;
+    volume += v;
+    centroid.x += v * (p0.x + p1.x + p2.x) / 4.0;
+    centroid.y += v * (p0.y + p1.y + p2.y) / 4.0;
+    centroid.z += v * (p0.z + p1.z + p2.z) / 4.0;
+  }
+
+  hull.volume_ = static_cast<float>(volume);
+  if(volume > 0.0)
+    hull.centroid_ = MakeFloat3(static_cast<float>(origin.x + centroid.x / volume),
+                                static_cast<float>(origin.y + centroid.y / volume),
+                                static_cast<float>(origin.z + centroid.z / volume));
+  return true;
+}
@@ -0,0 +1,27 @@
+////////////////////////////////////////////////////////
+//* Filename: ConvexHull.h                            //
+//  Author: Colt Johnson                              //
+//  Info: Quickhull convex hulls of point sets.       //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "MathTypes.h"
+
+  //Triangles are wound like the meshes, Cross(b - a, c - a) points out.
+  //Volume and centroid are those of the solid hull, for mass properties.
+  struct ConvexHull
+  {
+    std::vector<Float3> positions_;
+    std::vector<int> indices_;
+    float volume_;
+    Float3 centroid_;
+  };
+
+  //Quickhull of count points. The point furthest out of the current hull is
+  //always added next, so when maxVerts (0 is no limit) stops it early the hull
+  //still has the most important points and sits just inside the full one.
+  //Returns false, with an empty hull, when the points are flat.
+  bool BuildConvexHull(const Float3* points, unsigned count, unsigned maxVerts, ConvexHull& hull);
@@ -5,6 +5,114 @@
 //  All content  2012 DigiPen (USA) Corporation, all rights reserved.
 ///////////////////////////////////////////////////////////////////
 #include "DataStructures.h"
+#include <algorithm>
+
+template<typename type, typename alloc>
+static void ReleaseVector(std::vector<type, alloc>& container)
+{
+  std::vector<type, alloc>().swap(container);
+}
+
+template<typename type>
+static void BindArena(ArenaVector<type>& container, Arena *arena)
+{
+  ArenaVector<type>(ArenaAllocator<type>(arena)).swap(container);
+}
+
+void VertexStreams::resize(unsigned size)
+{
+  pos_.resize(size);
+  nrm_.resize(size);
+  uv_.resize(size);
+  tan_.resize(size);
+  bitan_.resize(size);
+}
+
+void VertexStreams::reserve(unsigned size)
+{
+  pos_.reserve(size);
+  nrm_.reserve(size);
+  uv_.reserve(size);
+  tan_.reserve(size);
+  bitan_.reserve(size);
+}
+
+void VertexStreams::swap(VertexStreams& other)
+{
+  pos_.swap(other.pos_);
+  nrm_.swap(other.nrm_);
+  uv_.swap(other.uv_);
+  tan_.swap(other.tan_);
+  bitan_.swap(other.bitan_);
+}
+
+void VertexStreams::Append(const VertexStreams& other)
+{
+  pos_.insert(pos_.end(), other.pos_.begin(), other.pos_.end());
+  nrm_.insert(nrm_.end(), other.nrm_.begin(), other.nrm_.end());
+  uv_.insert(uv_.end(), other.uv_.begin(), other.uv_.end());
+  tan_.insert(tan_.end(), other.tan_.begin(), other.tan_.end());
+  bitan_.insert(bitan_.end(), other.bitan_.begin(), other.bitan_.end());
+}
+
+void VertexStreams::AppendVertex(const VertexStreams& other, unsigned index)
+{
+  pos_.push_back(other.pos_[index]);
+  nrm_.push_back(other.nrm_[index]);
+  uv_.push_back(other.uv_[index]);
+  tan_.push_back(other.tan_[index]);
+  bitan_.push_back(other.bitan_[index]);
+}
+
+void FbxMesh::UseArena(Arena *arena)
+{
+  arena_ = arena;
+
+  BindArena(posInd, arena);
+  BindArena(uvInd, arena);
+  BindArena(nInd, arena);
+  BindArena(tInd, arena);
+  BindArena(bInd, arena);
+
+  BindArena(positions, arena);
+  BindArena(norms, arena);
+  BindArena(tans, arena);
+  BindArena(bitans, arena);
+  BindArena(uvs, arena);
+  BindArena(polySizeArray, arena);
+  BindArena(polyMaterials, arena);
+  BindArena(firstMapped, arena);
+  BindArena(nextMapped, arena);
+}
+
+void FbxMesh::ReleaseIntermediates(void)
+{
+  ReleaseVector(posInd);
+  ReleaseVector(uvInd);
+  ReleaseVector(nInd);
+  ReleaseVector(tInd);
+  ReleaseVector(bInd);
+
+  ReleaseVector(positions);
+  ReleaseVector(norms);
+  ReleaseVector(tans);
+  ReleaseVector(bitans);
+  ReleaseVector(uvs);
+  ReleaseVector(polySizeArray);
+  ReleaseVector(polyMaterials);
+  ReleaseVector(firstMapped);
+  ReleaseVector(nextMapped);
+  arena_ = NULL;
+}
+
+//Control points a mesh refers to, at least as many as it has weights for
+static unsigned ControlPointCount(const FbxMesh& mesh)
+{
+  unsigned points = mesh.skin.PointCount();
+  for(unsigned int i = 0; i < mesh.source.size(); ++i)
+    points = std::max(points, static_cast<unsigned>(mesh.source[i].posIndex + 1));
+  return points;
+}
 
 void FbxMesh::CombineInto(FbxMesh& otherMesh)
 {
@@ -16,9 +124,7 @@ void FbxMesh::CombineInto(FbxMesh& otherMesh)
   printf("%d\n", otherSize);
 
   //Append the other meshes vertices
-  verts_.resize(baseSize + otherSize);
-  for(unsigned int i = 0; i < otherSize; ++i)
-    verts_[baseSize + i] = otherMesh.verts_[i];
+  verts_.Append(otherMesh.verts_);
 
   //Copy over the indices increasing them by the size of the original vertex buffer
   int baseIndicesSize = indices_.size();
@@ -28,12 +134,26 @@ void FbxMesh::CombineInto(FbxMesh& otherMesh)
   for(unsigned int i = 0; i < otherIndicesSize; ++i)
     indices_[baseIndicesSize + i] = baseSize + otherMesh.indices_[i];
 
-  //Append the other meshes skin weights
-  int oPointSize = skin.PointWeights.size();
-  skin.PointWeights.resize(skin.PointWeights.size() + otherMesh.skin.PointWeights.size());
-    
-  for(unsigned int i = 0; i < otherMesh.skin.PointWeights.size(); ++i)
-    skin.PointWeights[oPointSize + i] = otherMesh.skin.PointWeights[i];
+  //Material indices are already the scene's, only the ranges move
+  for(unsigned int i = 0; i < otherMesh.materialRanges_.size(); ++i)
+  {
+    MaterialRange range = otherMesh.materialRanges_[i];
+    range.indexStart_ += baseIndicesSize;
+    materialRanges_.push_back(range);
+  }
+
+  //The other mesh's control points go after this one's, so position indices stay
+  //unique across the combined mesh whether or not there are weights
+  unsigned int oPointSize = ControlPointCount(*this);
+
+  //Append the other meshes skin weights, points either mesh has none for get zeros
+  if(!skin.PointWeights.empty() || !otherMesh.skin.PointWeights.empty())
+  {
+    unsigned int otherPoints = ControlPointCount(otherMesh);
+    skin.PointWeights.resize(oPointSize * MaxSkinWeights, JointWeight());
+    skin.PointWeights.insert(skin.PointWeights.end(), otherMesh.skin.PointWeights.begin(), otherMesh.skin.PointWeights.end());
+    skin.PointWeights.resize((oPointSize + otherPoints) * MaxSkinWeights, JointWeight());
+  }
 
   //Copy over the indices incrementing the position index so the the weights
   //are still correct (Note the other values in th source buffer are not adjusted)
@@ -44,4 +164,36 @@ void FbxMesh::CombineInto(FbxMesh& otherMesh)
     source[baseSize + i] = otherMesh.source[i];
     source[baseSize + i].posIndex += oPointSize;
   }
+
+  //Targets of the same channel in both meshes move disjoint vertices, merge them
+  for(unsigned int i = 0; i < otherMesh.morphs_.size(); ++i)
+  {
+    const MorphTarget& other = otherMesh.morphs_[i];
+    MorphTarget *target = NULL;
+    for(unsigned int m = 0; m < morphs_.size() && !target; ++m)
+      if(morphs_[m].name_ == other.name_ && morphs_[m].fullWeight_ == other.fullWeight_)
+        target = &morphs_[m];
+
+    if(!target)
+    {
+      morphs_.push_back(MorphTarget());
+      target = &morphs_.back();
+      target->name_ = other.name_;
+      target->fullWeight_ = other.fullWeight_;
+    }
+
+    for(unsigned int v = 0; v < other.verts_.size(); ++v)
+      target->verts_.push_back(other.verts_[v] + baseSize);
+    target->posDeltas_.insert(target->posDeltas_.end(), other.posDeltas_.begin(), other.posDeltas_.end());
+    target->nrmDeltas_.insert(target->nrmDeltas_.end(), other.nrmDeltas_.begin(), other.nrmDeltas_.end());
+  }
+
+  //Keep track of where the other mesh's ranges ended up
+  for(unsigned int i = 0; i < otherMesh.subMeshes_.size(); ++i)
+  {
+    SubMesh sub = otherMesh.subMeshes_[i];
+    sub.vertStart_ += baseSize;
+    sub.indexStart_ += baseIndicesSize;
+    subMeshes_.push_back(sub);
+  }
 }
\ No newline at end of file
@@ -10,6 +10,15 @@
 #include <fbxsdk.h>
 #include <string>
 #include <vector>
+#include "MathTypes.h"
+#include "Bounds.h"
+#include "Bvh.h"
+#include "Meshlets.h"
+#include "Arena.h"
+#include "Occluder.h"
+#include "Collision.h"
+#include "Adjacency.h"
+#include "GmfFormat.h"
 
   struct FbxBone
   {
@@ -27,6 +36,9 @@
     int pIndex_;
 
     std::string name_;
+
+    //Bind pose bone space bounds of the vertices this bone influences
+    Aabb bounds_;
   };
 
   struct FbxKeyFrame
@@ -39,11 +51,35 @@
     KFbxQuaternion localRot_;
   };
 
+  //Weight keys of one blend shape channel over a take
+  struct MorphCurve
+  {
+    std::string name_;
+    std::vector<float> times_;
+    std::vector<float> weights_;
+  };
+
   struct FbxAnimation
   {
+    FbxAnimation(void) : length_(0), bounds_(EmptyAabb()), boundsRate_(0) {}
+
     std::string name_;
     float length_;
+    KTime start_;
     std::vector<std::vector<FbxKeyFrame>> frames_;
+
+    //Bounds of the skinned mesh over the whole clip and sampled at boundsRate_,
+    //each sample quantized against bounds_ (see QuantizeAabb)
+    Aabb bounds_;
+    float boundsRate_;
+    std::vector<unsigned short> boundsTrack_;
+
+    //Global bone transforms in DX space sampled at boundsRate_, one per bone
+    //for every sample. Only kept until the animated bounds are made.
+    std::vector<KFbxXMatrix> boneSamples_;
+
+    //Blend shape channel weights (percent) keyed over the take
+    std::vector<MorphCurve> morphCurves_;
   };
 
   enum ModelType
@@ -52,18 +88,24 @@
     Skinned
   };
 
-  struct FbxVert
+  //Float32 vertex data stored as one stream per attribute. The streams are
+  //only interleaved into the output layout when the scene is written.
+  struct VertexStreams
   {
-    FbxVert(void) : boneIndex_(0){}
+    std::vector<Float3> pos_;
+    std::vector<Float3> nrm_;
+    std::vector<Float2> uv_;
+    std::vector<Float3> tan_;
+    std::vector<Float3> bitan_;
 
-    KFbxVector4 pos_;
-    KFbxVector4 nrm_;
-    KFbxVector2 uv_;
-    KFbxVector4 tan_;
-    KFbxVector4 bitan_;
-    int boneIndices_ [4];
-    float boneWeights_ [4];
-    unsigned short boneIndex_;
+    unsigned size(void) const { return pos_.size(); }
+    bool empty(void) const { return pos_.empty(); }
+
+    void resize(unsigned size);
+    void reserve(unsigned size);
+    void swap(VertexStreams& other);
+    void Append(const VertexStreams& other);
+    void AppendVertex(const VertexStreams& other, unsigned index);
   };
 
   struct IndexedVert
@@ -103,46 +145,162 @@
     float weight;
     unsigned int index;
   };
-  typedef std::vector< JointWeight > WeightVector;
+
+  //Every control point gets this many weights, unused ones are zero
+  const unsigned MaxSkinWeights = 4;
 
   struct SkinData
   {
-    //Index in PointWeight vector correspond to mesh control points which
-    //are mapped by the Position Indices
-    std::vector< WeightVector > PointWeights;
+    //MaxSkinWeights entries per mesh control point, control points are
+    //mapped by the Position Indices
+    std::vector< JointWeight > PointWeights;
+
+    JointWeight* Weights(unsigned point) { return &PointWeights[point * MaxSkinWeights]; }
+    unsigned PointCount(void) const { return PointWeights.size() / MaxSkinWeights; }
+  };
+
+  //How a mesh's triangles are shaded, gathered once per KFbxSurfaceMaterial
+  struct Material
+  {
+    KFbxSurfaceMaterial *source_;
+    std::string name_;
+    Float3 diffuse_;
+    Float3 specular_;
+    Float3 emissive_;
+    float opacity_;
+    float shininess_;
+
+    //Texture file per GmfTextureSlot, empty for none. Renamed to the
+    //compressed file when textures are converted.
+    std::string textures_[GmfTextureSlots];
+  };
+
+  //A run of triangles in indices_ drawn with one material
+  struct MaterialRange
+  {
+    unsigned material_;
+    unsigned indexStart_;
+    unsigned indexCount_;
+  };
+
+  //A range of the combined vertex and index buffers that came from one source mesh
+  struct SubMesh
+  {
+    std::string name_;
+    unsigned vertStart_;
+    unsigned vertCount_;
+    unsigned indexStart_;
+    unsigned indexCount_;
+
+    Aabb bounds_;
+    BoundingSphere sphere_;
+  };
+
+  //A reduced skeleton where minor leaf bones were collapsed into their parents
+  struct SkeletonLod
+  {
+    float ratio_;
+
+    //Full skeleton bones this level keeps, parents before children
+    std::vector<unsigned> bones_;
+
+    //Slot in bones_ each full skeleton bone's weights move to
+    std::vector<unsigned> remap_;
+  };
+
+  //A simplified index buffer over the full resolution vertices
+  struct LodLevel
+  {
+    float ratio_;
+    float error_;
+    std::vector<int> indices_;
+
+    //Where each sub mesh's triangles are in indices_
+    std::vector<unsigned> subMeshStarts_;
+    std::vector<unsigned> subMeshCounts_;
+
+    //The mesh's material ranges, in the same order, moved onto indices_
+    std::vector<MaterialRange> materialRanges_;
+  };
+
+  //One placement of a mesh when instancing. mesh_ indexes Scene::meshes_ until
+  //they are combined, then the sub mesh holding that geometry.
+  struct MeshInstance
+  {
+    unsigned mesh_;
+    KFbxNode *node_;
+    std::string name_;
+
+    //Local to world, converted to DirectX space
+    KFbxMatrix transform_;
+  };
+
+  //Sparse offsets of one blend shape target from the base mesh. Only the
+  //welded vertices that move are kept, quantized when written.
+  struct MorphTarget
+  {
+    //Channel the target belongs to and the channel weight it is fully reached at
+    std::string name_;
+    float fullWeight_;
+
+    std::vector<unsigned> verts_;
+    std::vector<Float3> posDeltas_;
+    std::vector<Float3> nrmDeltas_;
+  };
+
+  //One cell of a partitioned static scene with its own compact buffers.
+  //Covers [x_, x_ + 1) * cell size on x and likewise on y and z.
+  struct GridCell
+  {
+    int x_, y_, z_;
+    VertexStreams verts_;
+    std::vector<int> indices_;
+    std::vector<SubMesh> subMeshes_;
+    std::vector<MaterialRange> materialRanges_;
+    Aabb bounds_;
+    BoundingSphere sphere_;
   };
 
   struct FbxMesh
   {
-    FbxMesh(KFbxMesh *mesh) : mesh_(mesh) {}
+    FbxMesh(KFbxMesh *mesh, KFbxNode *node) : mesh_(mesh), node_(node), arena_(NULL) {}
 
     KFbxMesh *mesh_;
-    std::vector<FbxVert> verts_;
+    //The node this copy of the mesh hangs off. KFbxMesh::GetNode only knows the first one.
+    KFbxNode *node_;
+    VertexStreams verts_;
     std::vector<int> indices_;
     KFbxMatrix nrmMatrix_;
     KFbxMatrix transformMtx_;
     std::string name_;
 
+    //Where the input arrays below are allocated, NULL for the heap
+    Arena *arena_;
+
     //For triangulation on each mesh (input)
-    std::vector<int> posInd;
-    std::vector<int> uvInd;
-    std::vector<int> nInd;
-    std::vector<int> tInd;
-    std::vector<int> bInd;
+    ArenaVector<int> posInd;
+    ArenaVector<int> uvInd;
+    ArenaVector<int> nInd;
+    ArenaVector<int> tInd;
+    ArenaVector<int> bInd;
 
 
-    std::vector<KFbxVector4> positions;
-    std::vector<KFbxVector4> norms;
-    std::vector<KFbxVector4> tans;
-    std::vector<KFbxVector4> bitans;
-    std::vector<KFbxVector2> uvs;	
-    std::vector<int> polySizeArray;
+    ArenaVector<Float3> positions;
+    ArenaVector<Float3> norms;
+    ArenaVector<Float3> tans;
+    ArenaVector<Float3> bitans;
+    ArenaVector<Float2> uvs;	
+    ArenaVector<int> polySizeArray;
+    //Scene material of every polygon
+    ArenaVector<int> polyMaterials;
 
-    std::vector<std::vector<int>> mappedVerts;
+    //Vertices made from each control point, as chains through nextMapped
+    ArenaVector<int> firstMapped;
+    ArenaVector<int> nextMapped;
     std::vector<IndexedVert> source;
 
     //Resulting Data
-    std::vector<FbxVert> ProcessedVertices;
+    VertexStreams ProcessedVertices;
     std::vector<int> ProcessedIndices;
 
     std::vector<Tri> triangles;
@@ -154,5 +312,55 @@
     //Skinning stuff
     SkinData skin;
 
+    //Source mesh ranges and bounds, filled in by Scene::ComputeBounds
+    std::vector<SubMesh> subMeshes_;
+    Aabb bounds_;
+    BoundingSphere sphere_;
+
+    //Ray query hierarchy over indices_, only built when asked for
+    Bvh bvh_;
+
+    //Baked ambient occlusion per vertex of verts_, only made when asked for
+    std::vector<unsigned char> occlusion_;
+    float occlusionDistance_;
+
+    //Software culling occluder of each sub mesh, empty when it has no inside
+    std::vector<OccluderMesh> occluders_;
+
+    //Physics hulls of each sub mesh, only cooked when asked for
+    std::vector<CollisionShape> collision_;
+
+    //Twin and flags of every half edge of indices_, and optionally the
+    //triangle list with adjacency indices, only built when asked for
+    MeshEdges edges_;
+    std::vector<int> adjacency_;
+
+    //Depth pass stream, only made when asked for: the vertex standing in for
+    //each control point and indices into those, in vertex cache order
+    std::vector<unsigned> depthVerts_;
+    std::vector<int> depthIndices_;
+
+    //Simplified levels of detail, coarser ones last
+    std::vector<LodLevel> lods_;
+
+    //Triangles of each material, in order through indices_
+    std::vector<MaterialRange> materialRanges_;
+
+    //Blend shape targets mapped onto verts_
+    std::vector<MorphTarget> morphs_;
+
+    //Culling clusters and the first cluster of each sub mesh
+    MeshletData meshlets_;
+    std::vector<unsigned> subMeshMeshlets_;
+
+    //materialRanges_ counted in clusters: first cluster and cluster count
+    std::vector<MaterialRange> materialMeshlets_;
+
     void CombineInto(FbxMesh& mesh);
+
+    //Moves the (empty) input arrays into the arena
+    void UseArena(Arena *arena);
+
+    //Frees the per polygon-vertex input arrays once the welded vertices exist
+    void ReleaseIntermediates(void);
   };
\ No newline at end of file
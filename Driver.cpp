@@ -6,49 +6,37 @@
 ///////////////////////////////////////////////////////////////////
 #include "Precompiled.h"
 #include "Functions.h"
-#include "Scene.h"
+#include "ConvertApi.h"
+#include "Batch.h"
 
 
 int main(int argc, char** argv)
 {
-  KFbxSdkManager* pSdkManager = NULL;
-  KFbxScene* pFbxScene = NULL;
-
   
 	//Check for command line arguments
 	if(argc <= 1)
 	{
-    printf("Please type FBXConverter filename\n");
+    PrintUsage();
     return 0;
   }
 
-  std::string filename(argv[1]);
-  
-  printf("Loading %s\n", filename.c_str());
-
-  Scene scene(filename.c_str());
-
-  bool sceneLoaded = scene.LoadScene();
-
-  if (sceneLoaded)
-  {
-    bool extracted = scene.ExtractScene();
+  if(std::string(argv[1]) == "-batch")
+    return RunBatch(argc, argv);
 
-    if(extracted)
-  	{
-      scene.SaveScene();
-		}
-    else 
-    {
-      printf("Failed to extract scene!\n");
-    }
-  }
-  else 
+  ConvertOptions options;
+  if(!ParseOptions(argc, argv, 2, options))
   {
-    printf("Failed to load scene!\n");
+    PrintUsage();
+    return 0;
   }
 
-  DestroySdkManager(pSdkManager);
+  std::string filename(argv[1]);
+  
+  printf("Loading %s\n", filename.c_str());
+
+  ConvertResult result;
+  if(ConvertFile(filename.c_str(), options, result))
+    SaveOutputs(result);
 
   return 0;
-}
\ No newline at end of file
+}
@@ -28,4 +28,45 @@ void DestroySdkManager(KFbxSdkManager* pSdkManager)
     pSdkManager->Destroy();
 
   pSdkManager = NULL;
-}
\ No newline at end of file
+}
+
+Float3 ToFloat3(const KFbxVector4& v)
+{
+  return MakeFloat3(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]));
+}
+
+Float2 ToFloat2(const KFbxVector2& v)
+{
+  return MakeFloat2(static_cast<float>(v[0]), static_cast<float>(v[1]));
+}
+
+void ConvertDirections(ArenaVector<Float3>& container, KFbxLayerElementArrayTemplate<KFbxVector4>* FbxContainter, const KFbxXMatrix& transform)
+{
+  //KFbxXMatrix does not expose MultNormalize
+  const KFbxMatrix& mtx = *(const KFbxMatrix*)&transform;
+
+  int numberofObjects = FbxContainter->GetCount();
+  void * pData = FbxContainter->GetLocked();
+  const KFbxVector4* directions = static_cast<const KFbxVector4*>(pData);
+
+  container.resize( numberofObjects );
+  for(int i = 0; i < numberofObjects; ++i)
+  {
+    KFbxVector4 dir = mtx.MultNormalize( directions[i] );
+    dir.Normalize();
+    container[i] = ToFloat3(dir);
+  }
+  FbxContainter->Release( &pData );
+}
+
+void ConvertUvs(ArenaVector<Float2>& container, KFbxLayerElementArrayTemplate<KFbxVector2>* FbxContainter)
+{
+  int numberofObjects = FbxContainter->GetCount();
+  void * pData = FbxContainter->GetLocked();
+  const KFbxVector2* uvs = static_cast<const KFbxVector2*>(pData);
+
+  container.resize( numberofObjects );
+  for(int i = 0; i < numberofObjects; ++i)
+    container[i] = ToFloat2(uvs[i]);
+  FbxContainter->Release( &pData );
+}
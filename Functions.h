@@ -7,15 +7,16 @@
 //////////////////////////////////////////////////////*/
 
 #pragma once
-
+#include "MathTypes.h"
+#include "Arena.h"
 
 
 void InitializeSdkManager(KFbxSdkManager* pSdkManager, KFbxScene* pScene);
 
 void DestroySdkManager(KFbxSdkManager* pSdkManager);
 
-template<typename type>
-void ConvertToStl(std::vector<type>& container, KFbxLayerElementArrayTemplate<type>* FbxContainter)
+template<typename type, typename alloc>
+void ConvertToStl(std::vector<type, alloc>& container, KFbxLayerElementArrayTemplate<type>* FbxContainter)
 {
   int numberofObjects = FbxContainter->GetCount();
   void * pData = FbxContainter->GetLocked();
@@ -23,11 +24,19 @@ void ConvertToStl(std::vector<type>& container, KFbxLayerElementArrayTemplate<ty
   memcpy(&container[0] , pData , sizeof(type)*numberofObjects);
   FbxContainter->Release( &pData );
 }
-template<typename type>
-void FillStl(std::vector<type>& container, std::size_t size)
+template<typename type, typename alloc>
+void FillStl(std::vector<type, alloc>& container, std::size_t size)
 {
   container.resize(size);
   for(std::size_t i=0;i<size;++i)
     container[i] = i;
 }
 
+Float3 ToFloat3(const KFbxVector4& v);
+Float2 ToFloat2(const KFbxVector2& v);
+
+//Copies a layer element array of directions into float3s, transforming each
+//one by the given matrix and renormalizing it on the way.
+void ConvertDirections(ArenaVector<Float3>& container, KFbxLayerElementArrayTemplate<KFbxVector4>* FbxContainter, const KFbxXMatrix& transform);
+
+void ConvertUvs(ArenaVector<Float2>& container, KFbxLayerElementArrayTemplate<KFbxVector2>* FbxContainter);
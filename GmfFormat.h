@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////
+//* Filename: GmfFormat.h                             //
+//  Author: Colt Johnson                              //
+//  Info: Layout of the .gmf output file. Kept free   //
+//        of the FBX SDK so tools can read it.        //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+
+//A .gmf file starts with the payload written by Scene::SaveScene:
+//  unsigned type (0 static, 1 skinned), unsigned vertex count, unsigned index count
+//  vertices (GmfVertexFloats floats, skinned adds 4 unsigned char indices and 4 float weights)
+//  int indices
+//  skinned only: bones then animations
+//
+//Every key time (bone key frames and morph curve keys) is in seconds from
+//the start of its animation, so the first key of a clip is at 0.
+//
+//Tagged sections follow until the end of the file. Each one is
+//  unsigned tag
+//  unsigned size (bytes of payload that follow)
+//so a reader can skip any tag it does not know.
+#define GMF_TAG(a, b, c, d) ((unsigned)(a) | ((unsigned)(b) << 8) | ((unsigned)(c) << 16) | ((unsigned)(d) << 24))
+
+//Position, normal, uv, tangent, bitangent
+const unsigned GmfVertexFloats = 14;
+
+//Textures a material can reference, in the order they are written
+enum GmfTextureSlot
+{
+  GmfTextureDiffuse,
+  GmfTextureNormal,
+  GmfTextureSpecular,
+  GmfTextureEmissive,
+  GmfTextureSlots
+};
+
+enum GmfSection
+{
+  //Aabb and sphere of the whole mesh, unsigned sub mesh count, then for every sub mesh:
+  //unsigned index start, index count, vertex start, vertex count,
+  //unsigned name length, name, Aabb, sphere
+  GmfSectionBounds     = GMF_TAG('B','N','D','S'),
+
+  //unsigned bone count, then an Aabb per bone in its bind pose space.
+  //Bones that influence no vertices have an empty box (min > max).
+  GmfSectionBoneBounds = GMF_TAG('B','B','O','X'),
+
+  //unsigned animation count, then for every animation:
+  //float sample rate, unsigned sample count, Aabb of the whole clip,
+  //6 unsigned shorts per sample (min xyz, max xyz as fractions of the clip box)
+  GmfSectionAnimBounds = GMF_TAG('A','B','N','D'),
+
+  //unsigned node count, unsigned triangle count, 32 byte BvhNodes (root first),
+  //then an unsigned triangle number (index offset / 3) per leaf slot
+  GmfSectionBvh        = GMF_TAG('B','V','H','N'),
+
+  //unsigned level count, then for every level:
+  //float triangle ratio, float error (world units, the most the full mesh's surface
+  //moved off itself to get there), unsigned index count,
+  //unsigned sub mesh count, (unsigned index start, index count) per sub mesh,
+  //unsigned range count, (unsigned material, index start, index count) per range,
+  //int indices. The ranges are the MATL ones in the same order, moved onto the
+  //level's indices. Levels index the full resolution vertex buffer.
+  GmfSectionLods       = GMF_TAG('L','O','D','S'),
+
+  //unsigned meshlet count, unsigned vertex count, unsigned triangle count,
+  //unsigned sub mesh count, (unsigned first meshlet, meshlet count) per sub mesh,
+  //unsigned range count, (unsigned material, first meshlet, meshlet count) per
+  //MATL range (no meshlet holds two materials),
+  //Meshlets (see Meshlets.h), unsigned vertex indices, 3 unsigned chars per triangle
+  GmfSectionMeshlets   = GMF_TAG('M','S','H','L'),
+
+  //unsigned instance count, then for every instance: unsigned sub mesh,
+  //16 floats local to world matrix (same layout as the bone matrices),
+  //unsigned name length, name. Only written for instanced static scenes,
+  //in which case the vertices are in each mesh's local space.
+  GmfSectionInstances  = GMF_TAG('I','N','S','T'),
+
+  //unsigned target count, then for every blend shape target:
+  //unsigned channel name length, name, float full weight (percent),
+  //unsigned moved vertex count, float position scale, float normal scale,
+  //unsigned vertex indices, 3 shorts position delta and 3 shorts normal
+  //delta per vertex (delta = short * scale)
+  GmfSectionMorphs     = GMF_TAG('M','R','P','H'),
+
+  //unsigned animation count, then for every one: unsigned name length, name,
+  //float length, unsigned curve count, then per curve: unsigned channel name length, name,
+  //unsigned key count, (float time, float weight percent) per key
+  GmfSectionMorphCurves = GMF_TAG('M','C','R','V'),
+
+  //unsigned long long skeleton id, unsigned bone count, unsigned file name
+  //length, file name (in the shared skeleton directory). Written instead of the bones
+  //when the skeleton is shared, the payload's bone count is then 0.
+  GmfSectionSkeleton   = GMF_TAG('S','K','E','L'),
+
+  //unsigned level count, unsigned vertex count, then for every reduced skeleton:
+  //float bone ratio, unsigned bone count, unsigned full skeleton bone per slot
+  //(parents first), 4 unsigned char slots per vertex replacing the payload's
+  //bone indices (the weights stay the same)
+  GmfSectionSkeletonLods = GMF_TAG('S','K','L','D'),
+
+  //unsigned material count, then for every material: unsigned name length, name,
+  //float diffuse rgb, specular rgb, emissive rgb, opacity, shininess, then per
+  //GmfTextureSlot an unsigned file name length and file name (0 for none).
+  //Then unsigned range count, (unsigned material, index start, index count) per
+  //range of the full resolution indices. Each sub mesh's triangles are grouped
+  //by material. Converted textures (-textures) are .dds files next to the .gmf
+  //and named relative to it, otherwise the names are the FBX's texture paths.
+  GmfSectionMaterials  = GMF_TAG('M','A','T','L'),
+
+  //unsigned vertex count, float longest ray, then an unsigned char per vertex:
+  //the fraction of its hemisphere that is open, 0 fully occluded to 255 open
+  GmfSectionOcclusion  = GMF_TAG('A','O','C','C'),
+
+  //unsigned occluder count (one per sub mesh), then for every occluder:
+  //unsigned vertex count, unsigned index count, float xyz positions, int
+  //indices. Occluders are boxes that stay inside the sub mesh, in the same
+  //space as its vertices. Sub meshes with no closed inside have none (0, 0).
+  GmfSectionOccluders  = GMF_TAG('O','C','C','L'),
+
+  //unsigned shape count (one per sub mesh), then for every shape its convex
+  //hull followed by unsigned piece count and the convex decomposition's hulls.
+  //Each hull is unsigned vertex count, unsigned index count, float volume,
+  //float xyz centroid, float xyz positions, int indices (outward triangles).
+  //Flat sub meshes have an empty hull. In the same space as the vertices.
+  GmfSectionCollision  = GMF_TAG('C','O','L','L'),
+
+  //unsigned vertex count, unsigned index count, then per vertex float xyz
+  //(skinned adds 4 unsigned char bone indices and 4 float weights as in the
+  //payload), an unsigned payload vertex per vertex (the one it was welded
+  //from), int indices. Vertices are welded by position, so the stream is only
+  //good for passes that need nothing else. Every sub mesh and material range
+  //of the payload's indices covers the same triangles in these indices.
+  GmfSectionDepth      = GMF_TAG('D','P','T','H'),
+
+  //unsigned edge count, boundary edge count, non manifold edge count, unsigned
+  //half edge count (3 per triangle of the payload's indices, edge e of triangle
+  //t runs from corner e to corner (e + 1) % 3 and is number t * 3 + e), an int
+  //twin half edge per half edge (-1 when flagged), then an unsigned char of
+  //EdgeFlag bits (see Adjacency.h) per half edge. Edges are matched by
+  //position, so uv and normal seams aren't boundaries.
+  GmfSectionEdges      = GMF_TAG('E','D','G','E'),
+
+  //unsigned index count, int indices: 6 per triangle of the payload's indices
+  //for triangle list with adjacency drawing. Same ranges as the payload, doubled.
+  GmfSectionAdjacency  = GMF_TAG('A','D','J','I')
+};
+
+//A shared skeleton file (.gsk) holds
+//  unsigned long long skeleton id
+//  unsigned bone count, then the bones exactly as in the .gmf payload
+//The id is a hash of the bone names, parents and bind pose so every asset
+//bound to the same skeleton refers to the same file.
+//
+//Clips exported on their own (-clips, -animonly) go to <name>_<clip>.gma,
+//<name>_<clip>_2.gma and so on when clip names clash once made file safe:
+//  unsigned long long skeleton id (as above, whether or not it is shared)
+//  unsigned bone count
+//  the animation exactly as in the .gmf payload
+//followed by tagged sections like a .gmf. ABND (when the mesh was exported
+//too) and MCRV hold just this clip. The .gmf is then written with no
+//animations and empty ABND and MCRV sections.
+
+//Partitioned static scenes also get a .grid index next to the .gmf:
+//  float cell size, unsigned cell count, then for every cell:
+//  int x, y, z (the cell covers [x, x + 1) * cell size on each axis),
+//  Aabb and sphere of the cell's triangles (they can poke out of the cell),
+//  unsigned vertex count, unsigned index count,
+//  unsigned file name length, file name relative to the .grid
+//Each cell file is a static .gmf with a bounds section listing its sub meshes
+//and, when the scene has materials, a MATL section with the cell's own ranges.
@@ -0,0 +1,431 @@
+////////////////////////////////////////////////////////
+//* Filename: GmfStat.cpp                             //
+//  Author: Colt Johnson                              //
+//  Info: Reads converted .gmf and .gma files and     //
+//        prints their sizes and GPU efficiency as    //
+//        JSON. Needs no FBX SDK, build it from this  //
+//        directory plus ../Snapshot.cpp and          //
+//        ../VertexCache.cpp.                         //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "../GmfFormat.h"
+#include "../MathTypes.h"
+#include "../Snapshot.h"
+#include "../VertexCache.h"
+#include "Overdraw.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//FIFO cache sizes the ACMR and ATVR are reported for
+const unsigned StatCacheSizes[] = {8, 16, 24, 32};
+const unsigned StatCacheSizeCount = sizeof(StatCacheSizes) / sizeof(StatCacheSizes[0]);
+
+//Bytes of a bone in the payload before its name: position, rotation, inverse bind matrix, index, parent
+const unsigned GmfBoneBytes = (3 + 4 + 16) * sizeof(float) + sizeof(unsigned) + sizeof(int);
+//Bytes of a key frame: time, translation, rotation
+const unsigned GmfKeyBytes = (1 + 3 + 4) * sizeof(float);
+
+struct ClipStats
+{
+  std::string name_;
+  float length_;
+  unsigned tracks_;
+  unsigned keys_;
+};
+
+struct FileStats
+{
+  std::string path_;
+  std::string error_;
+  size_t bytes_;
+
+  //.gma files only hold one clip and sections
+  bool clipFile_;
+  unsigned type_;
+  unsigned boneCount_;
+  size_t payloadBytes_;
+
+  //(tag, bytes including the tag and size) in file order
+  std::vector<std::pair<unsigned, size_t> > sections_;
+
+  std::vector<Float3> positions_;
+  std::vector<int> indices_;
+  //Vertices with 0 to 4 non zero bone weights
+  unsigned influences_[5];
+  std::vector<ClipStats> clips_;
+
+  //Vertex count of the depth stream, which is welded back to the control points
+  unsigned depthVerts_;
+};
+
+//Reads one animation as WriteAnimation lays it out
+static void ReadClip(SnapshotReader& reader, ClipStats& clip)
+{
+  reader.ReadString(clip.name_);
+  reader.Read(clip.length_);
+  reader.Read(clip.tracks_);
+  clip.keys_ = 0;
+  for(unsigned t = 0; t < clip.tracks_ && reader.ok_; ++t)
+  {
+    unsigned keyCount = 0;
+    reader.Read(keyCount);
+    reader.Skip(static_cast<size_t>(keyCount) * GmfKeyBytes);
+    clip.keys_ += keyCount;
+  }
+}
+
+static bool ReadPayload(SnapshotReader& reader, FileStats& stats)
+{
+  unsigned vertCount = 0, indexCount = 0;
+  reader.Read(stats.type_);
+  reader.Read(vertCount);
+  reader.Read(indexCount);
+  if(!reader.ok_ || stats.type_ > 1)
+  {
+    stats.error_ = "not a .gmf file";
+    return false;
+  }
+
+  bool skinned = stats.type_ == 1;
+  size_t vertBytes = GmfVertexFloats * sizeof(float) + (skinned ? 4 + 4 * sizeof(float) : 0);
+  if(!reader.Has(vertBytes * vertCount + sizeof(int) * static_cast<size_t>(indexCount)))
+  {
+    stats.error_ = "vertex or index data runs past the end of the file";
+    return false;
+  }
+
+  stats.positions_.resize(vertCount);
+  for(unsigned v = 0; v < vertCount; ++v)
+  {
+    float vertex[GmfVertexFloats];
+    reader.Read(vertex);
+    stats.positions_[v] = MakeFloat3(vertex[0], vertex[1], vertex[2]);
+    if(!skinned)
+      continue;
+
+    unsigned char bones[4];
+    float weights[4];
+    reader.Read(bones);
+    reader.Read(weights);
+    unsigned used = 0;
+    for(int w = 0; w < 4; ++w)
+      if(weights[w] > 0.0f)
+        ++used;
+    ++stats.influences_[used];
+  }
+
+  stats.indices_.resize(indexCount);
+  for(unsigned i = 0; i < indexCount; ++i)
+  {
+    reader.Read(stats.indices_[i]);
+    if(stats.indices_[i] < 0 || static_cast<unsigned>(stats.indices_[i]) >= vertCount)
+    {
+      stats.error_ = "index out of range";
+      return false;
+    }
+  }
+
+  if(skinned)
+  {
+    reader.Read(stats.boneCount_);
+    for(unsigned b = 0; b < stats.boneCount_ && reader.ok_; ++b)
+    {
+      reader.Skip(GmfBoneBytes);
+      unsigned nameLength = 0;
+      reader.Read(nameLength);
+      reader.Skip(nameLength);
+    }
+
+    unsigned animCount = 0;
+    reader.Read(animCount);
+    for(unsigned a = 0; a < animCount && reader.ok_; ++a)
+    {
+      stats.clips_.push_back(ClipStats());
+      ReadClip(reader, stats.clips_.back());
+    }
+  }
+
+  if(!reader.ok_)
+  {
+    stats.error_ = "payload runs past the end of the file";
+    return false;
+  }
+  return true;
+}
+
+static bool ReadSections(SnapshotReader& reader, FileStats& stats)
+{
+  while(reader.ok_ && reader.cur_ < reader.end_)
+  {
+    unsigned tag = 0, size = 0;
+    reader.Read(tag);
+    reader.Read(size);
+    if(!reader.ok_ || !reader.Has(size))
+    {
+      stats.error_ = "section runs past the end of the file";
+      return false;
+    }
+
+    //The few sections that say something about the payload
+    SnapshotReader section = {reader.start_, reader.cur_, reader.cur_ + size, true};
+    if(tag == GmfSectionDepth)
+      section.Read(stats.depthVerts_);
+    else if(tag == GmfSectionSkeleton)
+    {
+      unsigned long long id;
+      section.Read(id);
+      section.Read(stats.boneCount_);
+    }
+
+    stats.sections_.push_back(std::make_pair(tag, size + 2 * sizeof(unsigned)));
+    reader.cur_ += size;
+  }
+  return true;
+}
+
+static bool ReadFile(const char *path, FileStats& stats)
+{
+  stats.path_ = path;
+  stats.bytes_ = 0;
+  stats.type_ = 0;
+  stats.boneCount_ = 0;
+  stats.payloadBytes_ = 0;
+  stats.depthVerts_ = 0;
+  memset(stats.influences_, 0, sizeof(stats.influences_));
+
+  size_t length = strlen(path);
+  stats.clipFile_ = length > 4 && !strcmp(path + length - 4, ".gma");
+
+  MappedFile file;
+  if(!file.Open(path))
+  {
+    stats.error_ = "can't open the file";
+    return false;
+  }
+  stats.bytes_ = file.Size();
+
+  SnapshotReader reader = {file.Data(), file.Data(), file.Data() + file.Size(), true};
+  if(stats.clipFile_)
+  {
+    unsigned long long id;
+    reader.Read(id);
+    reader.Read(stats.boneCount_);
+    stats.clips_.push_back(ClipStats());
+    ReadClip(reader, stats.clips_.back());
+    if(!reader.ok_)
+    {
+      stats.error_ = "clip runs past the end of the file";
+      return false;
+    }
+  }
+  else if(!ReadPayload(reader, stats))
+    return false;
+
+  stats.payloadBytes_ = reader.cur_ - reader.start_;
+  return ReadSections(reader, stats);
+}
+
+//Vertices the converter split off the same control point share its position,
+//so without a depth stream distinct positions stand in for the control points
+static unsigned CountControlPoints(const FileStats& stats)
+{
+  if(stats.depthVerts_)
+    return stats.depthVerts_;
+
+  std::vector<Float3> sorted(stats.positions_);
+  struct Less
+  {
+    bool operator()(const Float3& a, const Float3& b) const
+    {
+      if(a.x != b.x)
+        return a.x < b.x;
+      if(a.y != b.y)
+        return a.y < b.y;
+      return a.z < b.z;
+    }
+  };
+  std::sort(sorted.begin(), sorted.end(), Less());
+
+  unsigned count = 0;
+  for(unsigned i = 0; i < sorted.size(); ++i)
+    if(!i || Less()(sorted[i - 1], sorted[i]))
+      ++count;
+  return count;
+}
+
+static void PrintString(const std::string& text)
+{
+  putchar('"');
+  for(unsigned i = 0; i < text.size(); ++i)
+  {
+    unsigned char c = text[i];
+    if(c == '"' || c == '\\')
+      printf("\\%c", c);
+    else if(c < 0x20)
+      printf("\\u%04x", c);
+    else
+      putchar(c);
+  }
+  putchar('"');
+}
+
+//Four printable characters as the converter tags them, anything else in hex
+static void PrintTag(unsigned tag)
+{
+  char name[5] = {0};
+  for(int i = 0; i < 4; ++i)
+  {
+    name[i] = static_cast<char>((tag >> (i * 8)) & 0xff);
+    if(name[i] < 0x20 || name[i] > 0x7e || name[i] == '"' || name[i] == '\\')
+    {
+      printf("\"0x%08x\"", tag);
+      return;
+    }
+  }
+  printf("\"%s\"", name);
+}
+
+static void PrintStats(const FileStats& stats, unsigned viewCount, unsigned resolution)
+{
+  printf("    {\n      \"file\": ");
+  PrintString(stats.path_);
+  printf(",\n      \"bytes\": %lu", static_cast<unsigned long>(stats.bytes_));
+  if(!stats.error_.empty())
+  {
+    printf(",\n      \"error\": ");
+    PrintString(stats.error_);
+    printf("\n    }");
+    return;
+  }
+
+  printf(",\n      \"kind\": \"%s\"", stats.clipFile_ ? "clip" : stats.type_ ? "skinned" : "static");
+
+  //Tags can repeat in principle, their sizes are added up
+  printf(",\n      \"sections\": {\n        \"payload\": %lu", static_cast<unsigned long>(stats.payloadBytes_));
+  std::vector<bool> printed(stats.sections_.size(), false);
+  for(unsigned s = 0; s < stats.sections_.size(); ++s)
+  {
+    if(printed[s])
+      continue;
+    size_t bytes = 0;
+    for(unsigned o = s; o < stats.sections_.size(); ++o)
+    {
+      if(stats.sections_[o].first == stats.sections_[s].first)
+      {
+        bytes += stats.sections_[o].second;
+        printed[o] = true;
+      }
+    }
+    printf(",\n        ");
+    PrintTag(stats.sections_[s].first);
+    printf(": %lu", static_cast<unsigned long>(bytes));
+  }
+  printf("\n      }");
+
+  if(!stats.clipFile_)
+  {
+    unsigned vertCount = stats.positions_.size();
+    unsigned indexCount = stats.indices_.size();
+    unsigned controlPoints = CountControlPoints(stats);
+    printf(",\n      \"vertices\": %u,\n      \"indices\": %u,\n      \"triangles\": %u", vertCount, indexCount, indexCount / 3);
+    printf(",\n      \"controlPoints\": %u,\n      \"controlPointSource\": \"%s\"", controlPoints, stats.depthVerts_ ? "depth" : "positions");
+    printf(",\n      \"splitRatio\": %.4f", controlPoints ? static_cast<float>(vertCount) / controlPoints : 0.0f);
+
+    printf(",\n      \"vertexCache\": [");
+    for(unsigned c = 0; c < StatCacheSizeCount; ++c)
+    {
+      float acmr = indexCount ? AverageCacheMissRatio(&stats.indices_[0], indexCount, vertCount, StatCacheSizes[c]) : 0.0f;
+      float atvr = vertCount ? acmr * (indexCount / 3) / vertCount : 0.0f;
+      printf("%s\n        {\"cacheSize\": %u, \"acmr\": %.4f, \"atvr\": %.4f}", c ? "," : "", StatCacheSizes[c], acmr, atvr);
+    }
+    printf("\n      ]");
+
+    OverdrawStats overdraw;
+    EstimateOverdraw(vertCount ? &stats.positions_[0] : NULL, vertCount, indexCount ? &stats.indices_[0] : NULL,
+                     indexCount, viewCount, resolution, overdraw);
+    printf(",\n      \"overdraw\": {\"views\": %u, \"resolution\": %u, \"shaded\": %.4f, \"rasterized\": %.4f}",
+           overdraw.views_, resolution, overdraw.shaded_, overdraw.rasterized_);
+
+    if(stats.type_ == 1)
+    {
+      printf(",\n      \"bones\": %u,\n      \"boneInfluences\": [", stats.boneCount_);
+      for(int w = 0; w < 5; ++w)
+        printf("%s%u", w ? ", " : "", stats.influences_[w]);
+      printf("]");
+    }
+  }
+  else
+    printf(",\n      \"bones\": %u", stats.boneCount_);
+
+  if(!stats.clips_.empty())
+  {
+    printf(",\n      \"clips\": [");
+    for(unsigned c = 0; c < stats.clips_.size(); ++c)
+    {
+      const ClipStats& clip = stats.clips_[c];
+      float perTrack = clip.tracks_ ? static_cast<float>(clip.keys_) / clip.tracks_ : 0.0f;
+      printf("%s\n        {\"name\": ", c ? "," : "");
+      PrintString(clip.name_);
+      printf(", \"length\": %.4f, \"tracks\": %u, \"keys\": %u, \"keysPerTrackPerSecond\": %.4f}",
+             clip.length_, clip.tracks_, clip.keys_, clip.length_ > 0.0f ? perTrack / clip.length_ : 0.0f);
+    }
+    printf("\n      ]");
+  }
+  printf("\n    }");
+}
+
+static void PrintUsage(void)
+{
+  printf("gmfstat [options] file.gmf|file.gma ...\n");
+  printf("  -views N       directions the overdraw is estimated from (default 16)\n");
+  printf("  -res N         pixels across the mesh for the overdraw estimate (default 256)\n");
+  printf("Prints JSON to stdout, exits with 1 when any file couldn't be read.\n");
+}
+
+int main(int argc, char** argv)
+{
+  unsigned viewCount = 16, resolution = 256;
+  std::vector<const char*> paths;
+  for(int i = 1; i < argc; ++i)
+  {
+    if(!strcmp(argv[i], "-views") && i + 1 < argc)
+      viewCount = static_cast<unsigned>(atoi(argv[++i]));
+    else if(!strcmp(argv[i], "-res") && i + 1 < argc)
+      resolution = static_cast<unsigned>(atoi(argv[++i]));
+    else if(argv[i][0] == '-')
+    {
+      PrintUsage();
+      return 1;
+    }
+    else
+      paths.push_back(argv[i]);
+  }
+
+  if(paths.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  int result = 0;
+  printf("{\n  \"files\": [\n");
+  for(unsigned f = 0; f < paths.size(); ++f)
+  {
+    FileStats stats;
+    if(!ReadFile(paths[f], stats))
+    {
+      fprintf(stderr, "%s: %s\n", paths[f], stats.error_.c_str());
+      result = 1;
+    }
+    PrintStats(stats, viewCount, resolution);
+    printf(f + 1 < paths.size() ? ",\n" : "\n");
+  }
+  printf("  ]\n}\n");
+  return result;
+}
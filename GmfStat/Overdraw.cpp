@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////
+//* Filename: Overdraw.cpp                            //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Overdraw.h"
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+//A vertex on screen, x and y in pixels and z the distance along the view
+struct ScreenVert
+{
+  float x, y, z;
+};
+
+//Fill convention for pixel centres exactly on an edge, so shared edges are only drawn once
+static bool TopLeft(const ScreenVert& a, const ScreenVert& b)
+{
+  float dx = b.x - a.x, dy = b.y - a.y;
+  return dy > 0.0f || (dy == 0.0f && dx < 0.0f);
+}
+
+static float EdgeFunction(const ScreenVert& a, const ScreenVert& b, float x, float y)
+{
+  return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+//Rasterizes one triangle already wound so its area is positive
+static void DrawTriangle(const ScreenVert& a, const ScreenVert& b, const ScreenVert& c, float area,
+                         int resolution, std::vector<float>& depth, unsigned& rasterized, unsigned& shaded)
+{
+  int minX = std::max(0, static_cast<int>(std::floor(std::min(a.x, std::min(b.x, c.x)))));
+  int maxX = std::min(resolution - 1, static_cast<int>(std::ceil(std::max(a.x, std::max(b.x, c.x)))));
+  int minY = std::max(0, static_cast<int>(std::floor(std::min(a.y, std::min(b.y, c.y)))));
+  int maxY = std::min(resolution - 1, static_cast<int>(std::ceil(std::max(a.y, std::max(b.y, c.y)))));
+
+  bool topLeft[3] = {TopLeft(b, c), TopLeft(c, a), TopLeft(a, b)};
+  for(int y = minY; y <= maxY; ++y)
+  {
+    for(int x = minX; x <= maxX; ++x)
+    {
+      float px = x + 0.5f, py = y + 0.5f;
+      float w[3] = {EdgeFunction(b, c, px, py), EdgeFunction(c, a, px, py), EdgeFunction(a, b, px, py)};
+      bool inside = true;
+      for(int e = 0; e < 3 && inside; ++e)
+        inside = w[e] > 0.0f || (w[e] == 0.0f && topLeft[e]);
+      if(!inside)
+        continue;
+
+      ++rasterized;
+      float z = (w[0] * a.z + w[1] * b.z + w[2] * c.z) / area;
+      float& stored = depth[y * resolution + x];
+      if(z < stored)
+      {
+        stored = z;
+        ++shaded;
+      }
+    }
+  }
+}
+
+void EstimateOverdraw(const Float3* positions, unsigned vertCount, const int* indices, unsigned indexCount,
+                      unsigned viewCount, unsigned resolution, OverdrawStats& stats)
+{
+  stats.shaded_ = 0.0f;
+  stats.rasterized_ = 0.0f;
+  stats.views_ = 0;
+  if(!vertCount || indexCount < 3 || !resolution)
+    return;
+
+  //Centre of the box and the furthest vertex from it, close enough to a bounding sphere here
+  Float3 lo = positions[0], hi = positions[0];
+  for(unsigned v = 1; v < vertCount; ++v)
+  {
+    for(int i = 0; i < 3; ++i)
+    {
+      lo[i] = std::min(lo[i], positions[v][i]);
+      hi[i] = std::max(hi[i], positions[v][i]);
+    }
+  }
+  Float3 centre = (lo + hi) * 0.5f;
+  float radius = 0.0f;
+  for(unsigned v = 0; v < vertCount; ++v)
+    radius = std::max(radius, Length(positions[v] - centre));
+  if(radius <= 0.0f)
+    return;
+
+  int size = static_cast<int>(resolution);
+  float scale = resolution / (2.0f * radius);
+  std::vector<ScreenVert> screen(vertCount);
+  std::vector<float> depth(resolution * resolution);
+
+  for(unsigned view = 0; view < viewCount; ++view)
+  {
+    //Fibonacci spiral, about evenly spaced directions for any count
+    float z = 1.0f - (2.0f * view + 1.0f) / viewCount;
+    float ring = std::sqrt(std::max(0.0f, 1.0f - z * z));
+    float angle = view * 2.39996323f;
+    Float3 dir = MakeFloat3(ring * std::cos(angle), ring * std::sin(angle), z);
+
+    //u x v = dir, so a face turned towards the viewer has negative area on screen
+    Float3 up = std::fabs(dir.y) < 0.99f ? MakeFloat3(0.0f, 1.0f, 0.0f) : MakeFloat3(1.0f, 0.0f, 0.0f);
+    Float3 u = Cross(up, dir);
+    Normalize(u);
+    Float3 v = Cross(dir, u);
+
+    for(unsigned i = 0; i < vertCount; ++i)
+    {
+      Float3 p = positions[i] - centre;
+      screen[i].x = (Dot(p, u) + radius) * scale;
+      screen[i].y = (Dot(p, v) + radius) * scale;
+      screen[i].z = Dot(p, dir);
+    }
+
+    std::fill(depth.begin(), depth.end(), FLT_MAX);
+    unsigned rasterized = 0, shaded = 0;
+    for(unsigned t = 0; t + 2 < indexCount; t += 3)
+    {
+      const ScreenVert& a = screen[indices[t]];
+      const ScreenVert& b = screen[indices[t + 1]];
+      const ScreenVert& c = screen[indices[t + 2]];
+      float area = EdgeFunction(a, b, c.x, c.y);
+      if(area < 0.0f)
+        DrawTriangle(a, c, b, -area, size, depth, rasterized, shaded);
+    }
+
+    unsigned covered = 0;
+    for(unsigned p = 0; p < depth.size(); ++p)
+      if(depth[p] != FLT_MAX)
+        ++covered;
+    if(!covered)
+      continue;
+
+    stats.shaded_ += static_cast<float>(shaded) / covered;
+    stats.rasterized_ += static_cast<float>(rasterized) / covered;
+    ++stats.views_;
+  }
+
+  if(stats.views_)
+  {
+    stats.shaded_ /= stats.views_;
+    stats.rasterized_ /= stats.views_;
+  }
+}
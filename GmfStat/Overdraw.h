@@ -0,0 +1,28 @@
+////////////////////////////////////////////////////////
+//* Filename: Overdraw.h                              //
+//  Author: Colt Johnson                              //
+//  Info: Estimates how many times each pixel of a    //
+//        mesh gets drawn, for gmfstat.               //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include "../MathTypes.h"
+
+  //Fragments per covered pixel, averaged over the views that saw the mesh
+  struct OverdrawStats
+  {
+    //Front facing fragments that passed the depth test, drawn in index order
+    //(what early z leaves to shade, the part index order changes)
+    float shaded_;
+    //Every front facing fragment, as with no depth test at all
+    float rasterized_;
+    unsigned views_;
+  };
+
+  //Rasterizes the front faces of the indexCount / 3 triangles orthographically
+  //from viewCount directions spread over the sphere, resolution pixels across
+  //the mesh's bounding sphere. Outward faces wind counter clockwise like the converter's.
+  void EstimateOverdraw(const Float3* positions, unsigned vertCount, const int* indices, unsigned indexCount,
+                        unsigned viewCount, unsigned resolution, OverdrawStats& stats);
@@ -0,0 +1,35 @@
+////////////////////////////////////////////////////////
+//* Filename: Hash.h                                  //
+//  Author: Colt Johnson                              //
+//  Info: 64 bit FNV-1a hashing of raw bytes, used to //
+//        spot identical data.                        //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+const unsigned long long HashSeed = 14695981039346656037ULL;
+
+  //Pass the previous result as seed to hash several blocks as one
+  inline unsigned long long HashBytes(const void* data, std::size_t size, unsigned long long seed = HashSeed)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    unsigned long long hash = seed;
+    for(std::size_t i = 0; i < size; ++i)
+    {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  template<typename type>
+  unsigned long long HashVector(const std::vector<type>& container, unsigned long long seed = HashSeed)
+  {
+    if(container.empty())
+      return seed;
+    return HashBytes(&container[0], sizeof(type) * container.size(), seed);
+  }
@@ -0,0 +1,275 @@
+////////////////////////////////////////////////////////
+//* Filename: Image.cpp                               //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Image.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static bool ReadWholeFile(const char *path, std::vector<unsigned char>& data)
+{
+  FILE *fp = fopen(path, "rb");
+  if(!fp)
+    return false;
+
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+
+  data.resize(size > 0 ? size : 0);
+  bool read = !data.empty() && fread(&data[0], data.size(), 1, fp) == 1;
+  fclose(fp);
+  return read;
+}
+
+static unsigned Read16(const unsigned char *data)
+{
+  return data[0] | (data[1] << 8);
+}
+
+static unsigned Read32(const unsigned char *data)
+{
+  return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<unsigned>(data[3]) << 24);
+}
+
+//Grey, BGR or BGRA to RGBA
+static void ReadTgaPixel(const unsigned char *src, unsigned bytes, unsigned char *dst)
+{
+  if(bytes == 1)
+  {
+    dst[0] = dst[1] = dst[2] = src[0];
+    dst[3] = 255;
+    return;
+  }
+
+  dst[0] = src[2];
+  dst[1] = src[1];
+  dst[2] = src[0];
+  dst[3] = bytes == 4 ? src[3] : 255;
+}
+
+static bool LoadTga(const std::vector<unsigned char>& file, Image& image)
+{
+  if(file.size() < 18)
+    return false;
+
+  const unsigned char *header = &file[0];
+  unsigned imageType = header[2];
+  unsigned width = Read16(header + 12);
+  unsigned height = Read16(header + 14);
+  unsigned bytes = header[16] / 8;
+  bool topDown = (header[17] & 0x20) != 0;
+
+  //Color mapped images aren't something textures get saved as
+  bool grey = imageType == 3 || imageType == 11;
+  bool rle = imageType == 10 || imageType == 11;
+  if(header[1] || (imageType != 2 && imageType != 3 && !rle))
+  {
+    printf("Unsupported TGA type %d.\n", imageType);
+    return false;
+  }
+  if(grey ? bytes != 1 : bytes != 3 && bytes != 4)
+  {
+    printf("Unsupported TGA depth %d.\n", header[16]);
+    return false;
+  }
+
+  size_t pos = 18 + header[0];
+  if(!width || !height || pos > file.size())
+    return false;
+
+  //Don't allocate for pixels the file can't hold, an RLE packet of one
+  //pixel's bytes and a count byte covers at most 128 of them
+  size_t pixelCount = static_cast<size_t>(width) * height;
+  size_t remaining = file.size() - pos;
+  if(rle ? pixelCount > remaining / (bytes + 1) * 128 + 128 : pixelCount > remaining / bytes)
+  {
+    printf("TGA of %d x %d is larger than its file.\n", width, height);
+    return false;
+  }
+  std::vector<unsigned char> pixels(pixelCount * 4);
+
+  for(size_t i = 0; i < pixelCount; )
+  {
+    //RLE packets repeat one pixel or hold a run of raw ones, raw images are one long run
+    size_t count = pixelCount - i;
+    bool repeat = false;
+    if(rle)
+    {
+      if(pos >= file.size())
+        return false;
+      repeat = (file[pos] & 0x80) != 0;
+      count = std::min<size_t>(count, (file[pos] & 0x7fu) + 1);
+      ++pos;
+    }
+
+    for(size_t p = 0; p < count; ++p, ++i)
+    {
+      if(pos + bytes > file.size())
+        return false;
+      ReadTgaPixel(&file[pos], bytes, &pixels[i * 4]);
+      if(!repeat || p + 1 == count)
+        pos += bytes;
+    }
+  }
+
+  image.width_ = width;
+  image.height_ = height;
+  image.rgba_.resize(pixelCount * 4);
+  for(unsigned y = 0; y < height; ++y)
+  {
+    unsigned row = topDown ? y : height - 1 - y;
+    memcpy(&image.rgba_[row * width * 4], &pixels[y * width * 4], width * 4);
+  }
+
+  return true;
+}
+
+static bool LoadBmp(const std::vector<unsigned char>& file, Image& image)
+{
+  if(file.size() < 54)
+    return false;
+
+  const unsigned char *header = &file[0];
+  unsigned dataOffset = Read32(header + 10);
+  int width = static_cast<int>(Read32(header + 18));
+  int height = static_cast<int>(Read32(header + 22));
+  unsigned bits = Read16(header + 28);
+  unsigned compression = Read32(header + 30);
+
+  //Uncompressed BGR(A), 32 bit bitfields are assumed to be the usual BGRA masks
+  if(!(compression == 0 && (bits == 24 || bits == 32)) && !(compression == 3 && bits == 32))
+  {
+    printf("Unsupported BMP, %d bits with compression %d.\n", bits, compression);
+    return false;
+  }
+
+  bool topDown = height < 0;
+  height = std::abs(height);
+  if(width <= 0 || !height)
+    return false;
+
+  unsigned bytes = bits / 8;
+  size_t stride = ((width * bits + 31) / 32) * 4;
+  if(dataOffset + stride * height > file.size())
+    return false;
+
+  image.width_ = width;
+  image.height_ = height;
+  image.rgba_.resize(width * height * 4);
+
+  bool anyAlpha = false;
+  for(int y = 0; y < height; ++y)
+  {
+    const unsigned char *src = &file[dataOffset + stride * y];
+    unsigned char *dst = &image.rgba_[(topDown ? y : height - 1 - y) * width * 4];
+    for(int x = 0; x < width; ++x, src += bytes, dst += 4)
+    {
+      dst[0] = src[2];
+      dst[1] = src[1];
+      dst[2] = src[0];
+      dst[3] = bytes == 4 ? src[3] : 255;
+      anyAlpha = anyAlpha || dst[3];
+    }
+  }
+
+  //Most 32 bit BMPs leave the fourth byte as padding
+  if(bytes == 4 && !anyAlpha)
+    for(size_t i = 3; i < image.rgba_.size(); i += 4)
+      image.rgba_[i] = 255;
+
+  return true;
+}
+
+bool ReadImage(const char *path, Image& image)
+{
+  std::vector<unsigned char> file;
+  if(!ReadWholeFile(path, file))
+  {
+    printf("Couldn't read texture %s\n", path);
+    return false;
+  }
+
+  std::string extension = path;
+  extension = extension.substr(extension.find_last_of(".") + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(), tolower);
+
+  bool loaded = false;
+  if(file.size() >= 2 && file[0] == 'B' && file[1] == 'M')
+    loaded = LoadBmp(file, image);
+  else if(extension == "tga")
+    loaded = LoadTga(file, image);
+  else
+    printf("Only TGA and BMP textures can be converted.\n");
+
+  if(!loaded)
+    printf("Couldn't decode texture %s\n", path);
+  return loaded;
+}
+
+bool HasAlpha(const Image& image)
+{
+  for(size_t i = 3; i < image.rgba_.size(); i += 4)
+    if(image.rgba_[i] != 255)
+      return true;
+  return false;
+}
+
+void Downsample(const Image& source, Image& destination, bool normalMap)
+{
+  unsigned width = std::max(1u, source.width_ / 2);
+  unsigned height = std::max(1u, source.height_ / 2);
+  destination.width_ = width;
+  destination.height_ = height;
+  destination.rgba_.resize(width * height * 4);
+
+  for(unsigned y = 0; y < height; ++y)
+  {
+    //The last texel of an odd sized level takes the extra row or column
+    unsigned y0 = y * source.height_ / height;
+    unsigned y1 = std::max(y0 + 1, (y + 1) * source.height_ / height);
+
+    for(unsigned x = 0; x < width; ++x)
+    {
+      unsigned x0 = x * source.width_ / width;
+      unsigned x1 = std::max(x0 + 1, (x + 1) * source.width_ / width);
+
+      float sum[4] = {0, 0, 0, 0};
+      for(unsigned sy = y0; sy < y1; ++sy)
+        for(unsigned sx = x0; sx < x1; ++sx)
+        {
+          const unsigned char *p = source.Pixel(sx, sy);
+          for(unsigned c = 0; c < 4; ++c)
+            sum[c] += p[c];
+        }
+
+      float count = static_cast<float>((x1 - x0) * (y1 - y0));
+      for(unsigned c = 0; c < 4; ++c)
+        sum[c] /= count;
+
+      if(normalMap)
+      {
+        float n[3];
+        for(unsigned c = 0; c < 3; ++c)
+          n[c] = sum[c] / 127.5f - 1.0f;
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if(length > 0.0f)
+          for(unsigned c = 0; c < 3; ++c)
+            sum[c] = (n[c] / length + 1.0f) * 127.5f;
+      }
+
+      unsigned char *dst = &destination.rgba_[(y * width + x) * 4];
+      for(unsigned c = 0; c < 4; ++c)
+        dst[c] = static_cast<unsigned char>(std::min(255.0f, sum[c] + 0.5f));
+    }
+  }
+}
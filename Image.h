@@ -0,0 +1,32 @@
+////////////////////////////////////////////////////////
+//* Filename: Image.h                                 //
+//  Author: Colt Johnson                              //
+//  Info: Decoding of the source texture formats and  //
+//        mip level generation.                       //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+
+  //8 bit RGBA pixels, rows top to bottom
+  struct Image
+  {
+    unsigned width_;
+    unsigned height_;
+    std::vector<unsigned char> rgba_;
+
+    const unsigned char* Pixel(unsigned x, unsigned y) const { return &rgba_[(y * width_ + x) * 4]; }
+  };
+
+  //Reads a .tga (true color or grey, raw or RLE) or .bmp (24 or 32 bit).
+  //Returns false and prints why for anything else.
+  bool ReadImage(const char *path, Image& image);
+
+  //True if any pixel isn't fully opaque
+  bool HasAlpha(const Image& image);
+
+  //Box filters the next mip level down, odd edges are folded into the last
+  //texel. Normal maps are renormalized instead of just averaged.
+  void Downsample(const Image& source, Image& destination, bool normalMap);
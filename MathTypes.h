@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////
+//* Filename: MathTypes.h                             //
+//  Author: Colt Johnson                              //
+//  Info: Compact float vector types used by the      //
+//        mesh processing pipeline (no FBX SDK).      //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <cmath>
+
+  struct Float2
+  {
+    float x, y;
+  };
+
+  struct Float3
+  {
+    float x, y, z;
+
+    float& operator[](int i) { return (&x)[i]; }
+    float operator[](int i) const { return (&x)[i]; }
+  };
+
+  inline Float2 MakeFloat2(float x, float y)
+  {
+    Float2 v = {x, y};
+    return v;
+  }
+
+  inline Float3 MakeFloat3(float x, float y, float z)
+  {
+    Float3 v = {x, y, z};
+    return v;
+  }
+
+  inline Float2 operator-(const Float2& a, const Float2& b) { return MakeFloat2(a.x - b.x, a.y - b.y); }
+
+  inline Float3 operator+(const Float3& a, const Float3& b) { return MakeFloat3(a.x + b.x, a.y + b.y, a.z + b.z); }
+  inline Float3 operator-(const Float3& a, const Float3& b) { return MakeFloat3(a.x - b.x, a.y - b.y, a.z - b.z); }
+  inline Float3 operator*(const Float3& a, float s) { return MakeFloat3(a.x * s, a.y * s, a.z * s); }
+  inline Float3& operator+=(Float3& a, const Float3& b) { a.x += b.x; a.y += b.y; a.z += b.z; return a; }
+  inline Float3& operator/=(Float3& a, float s) { a.x /= s; a.y /= s; a.z /= s; return a; }
+
+  inline float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+  inline Float3 Cross(const Float3& a, const Float3& b)
+  {
+    return MakeFloat3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+  }
+
+  inline float Length(const Float3& a) { return std::sqrt(Dot(a, a)); }
+
+  //Normalizes in place, leaving zero length vectors untouched
+  inline void Normalize(Float3& a)
+  {
+    float len = Length(a);
+    if(len > 0.0f)
+      a /= len;
+  }
@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////
+//* Filename: MeshClean.cpp                           //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "MeshClean.h"
+#include "Hash.h"
+#include <algorithm>
+
+//Triangles whose height is less than this fraction of their longest edge have
+//no area worth drawing (float rounding alone gets collinear points to about 1e-7)
+const float CleanAreaEpsilon = 1e-6f;
+
+//A triangle's corners rotated so the smallest index comes first, which keeps the winding
+struct CleanTri
+{
+  int v_[3];
+  unsigned group_;
+};
+
+static CleanTri Canonical(const int* corners, unsigned group)
+{
+  int first = 0;
+  if(corners[1] < corners[first])
+    first = 1;
+  if(corners[2] < corners[first])
+    first = 2;
+
+  CleanTri tri;
+  for(int c = 0; c < 3; ++c)
+    tri.v_[c] = corners[(first + c) % 3];
+  tri.group_ = group;
+  return tri;
+}
+
+static bool SameTri(const CleanTri& a, const CleanTri& b)
+{
+  return a.group_ == b.group_ && a.v_[0] == b.v_[0] && a.v_[1] == b.v_[1] && a.v_[2] == b.v_[2];
+}
+
+static bool ZeroArea(const Float3& a, const Float3& b, const Float3& c)
+{
+  Float3 ab = b - a, bc = c - b, ca = a - c;
+  float longest = std::max(Dot(ab, ab), std::max(Dot(bc, bc), Dot(ca, ca)));
+  if(longest <= 0.0f)
+    return true;
+
+  //|cross| is the longest edge times the height, compare it squared to stay out of sqrt
+  Float3 n = Cross(ab, ca);
+  return Dot(n, n) <= CleanAreaEpsilon * CleanAreaEpsilon * longest * longest;
+}
+
+void FindWastedTriangles(const Float3* positions, const int* indices, unsigned indexCount,
+                         const unsigned* groups, std::vector<bool>& keep, CleanStats& stats)
+{
+  unsigned triCount = indexCount / 3;
+  keep.assign(triCount, true);
+  stats.collapsed_ = 0;
+  stats.zeroArea_ = 0;
+  stats.duplicates_ = 0;
+  stats.orphans_ = 0;
+  if(!triCount)
+    return;
+
+  //Open addressed set of the triangles kept so far, twice as many slots as triangles
+  unsigned slotCount = 1;
+  while(slotCount < triCount * 2)
+    slotCount *= 2;
+  std::vector<int> slots(slotCount, -1);
+  std::vector<CleanTri> tris(triCount);
+
+  for(unsigned t = 0; t < triCount; ++t)
+  {
+    const int *corners = indices + t * 3;
+    if(corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+    {
+      keep[t] = false;
+      ++stats.collapsed_;
+      continue;
+    }
+
+    if(ZeroArea(positions[corners[0]], positions[corners[1]], positions[corners[2]]))
+    {
+      keep[t] = false;
+      ++stats.zeroArea_;
+      continue;
+    }
+
+    tris[t] = Canonical(corners, groups ? groups[t] : 0);
+    unsigned s = static_cast<unsigned>(HashBytes(&tris[t], sizeof(CleanTri))) & (slotCount - 1);
+    while(slots[s] >= 0 && !SameTri(tris[slots[s]], tris[t]))
+      s = (s + 1) & (slotCount - 1);
+
+    if(slots[s] >= 0)
+    {
+      keep[t] = false;
+      ++stats.duplicates_;
+    }
+    else
+      slots[s] = t;
+  }
+}
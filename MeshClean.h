@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////
+//* Filename: MeshClean.h                             //
+//  Author: Colt Johnson                              //
+//  Info: Finds triangles that add nothing to a mesh  //
+//        so they can be dropped before output.       //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "MathTypes.h"
+
+  struct CleanStats
+  {
+    //Two corners on the same vertex
+    unsigned collapsed_;
+    //Corners on one line, or distinct vertices on one point
+    unsigned zeroArea_;
+    //The same three vertices as an earlier triangle, wound the same way
+    unsigned duplicates_;
+    //Vertices no triangle uses once the rest are gone, counted by the caller
+    unsigned orphans_;
+  };
+
+  //Flags the indexCount / 3 triangles worth keeping in keep and counts the rest
+  //in stats. Duplicates are only looked for among triangles of the same group
+  //(groups has one per triangle, NULL puts them all in one). A copy wound the
+  //other way is the back face of a double sided surface and stays.
+  void FindWastedTriangles(const Float3* positions, const int* indices, unsigned indexCount,
+                           const unsigned* groups, std::vector<bool>& keep, CleanStats& stats);
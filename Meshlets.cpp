@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////
+//* Filename: Meshlets.cpp                            //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Meshlets.h"
+#include "Bounds.h"
+#include <algorithm>
+#include <cfloat>
+
+//Marks a vertex as not being in the meshlet being built
+const unsigned char MeshletNoVertex = 0xff;
+
+static void ComputeMeshletBounds(const Float3* positions, MeshletData& data, Meshlet& meshlet)
+{
+  std::vector<Float3> points(meshlet.vertCount_);
+  for(unsigned i = 0; i < meshlet.vertCount_; ++i)
+    points[i] = positions[data.verts_[meshlet.vertOffset_ + i]];
+
+  BoundingSphere sphere = ComputeSphere(&points[0], meshlet.vertCount_);
+  meshlet.center_ = sphere.center_;
+  meshlet.radius_ = sphere.radius_;
+
+  //Average the face normals for the cone axis
+  std::vector<Float3> normals;
+  normals.reserve(meshlet.triCount_);
+  Float3 axis = MakeFloat3(0, 0, 0);
+  for(unsigned t = 0; t < meshlet.triCount_; ++t)
+  {
+    const unsigned char* tri = &data.tris_[(meshlet.triOffset_ + t) * 3];
+    const Float3& p0 = points[tri[0]];
+    Float3 n = Cross(points[tri[1]] - p0, points[tri[2]] - p0);
+    if(Length(n) <= 0.0f)
+      continue;
+
+    Normalize(n);
+    normals.push_back(n);
+    axis += n;
+  }
+  Normalize(axis);
+
+  meshlet.coneAxis_ = axis;
+  meshlet.coneApex_ = meshlet.center_;
+  meshlet.coneCutoff_ = 1.0f;
+
+  float minDot = 1.0f;
+  for(unsigned i = 0; i < normals.size(); ++i)
+    minDot = std::min(minDot, Dot(normals[i], axis));
+
+  //Normals spread over more than a hemisphere, no useful cone
+  if(normals.empty() || minDot <= 0.0f)
+    return;
+
+  //Move the apex back along the axis until it is behind every triangle's plane
+  float maxT = 0.0f;
+  for(unsigned t = 0, n = 0; t < meshlet.triCount_; ++t)
+  {
+    const unsigned char* tri = &data.tris_[(meshlet.triOffset_ + t) * 3];
+    const Float3& p0 = points[tri[0]];
+    Float3 normal = Cross(points[tri[1]] - p0, points[tri[2]] - p0);
+    if(Length(normal) <= 0.0f)
+      continue;
+
+    const Float3& nrm = normals[n++];
+    float dc = Dot(meshlet.center_ - p0, nrm);
+    float dn = Dot(axis, nrm);
+    maxT = std::max(maxT, dc / dn);
+  }
+
+  meshlet.coneApex_ = meshlet.center_ - axis * maxT;
+  meshlet.coneCutoff_ = std::sqrt(1.0f - minDot * minDot);
+}
+
+void BuildMeshlets(const Float3* positions, unsigned vertCount, const int* indices, unsigned indexCount, MeshletData& data)
+{
+  unsigned triCount = indexCount / 3;
+  if(!triCount)
+    return;
+
+  //Triangles around every vertex
+  std::vector<unsigned> triStart(vertCount + 1, 0);
+  for(unsigned i = 0; i < indexCount; ++i)
+    ++triStart[indices[i] + 1];
+  for(unsigned v = 0; v < vertCount; ++v)
+    triStart[v + 1] += triStart[v];
+
+  std::vector<unsigned> triList(indexCount);
+  std::vector<unsigned> fill(triStart.begin(), triStart.end() - 1);
+  for(unsigned i = 0; i < indexCount; ++i)
+    triList[fill[indices[i]]++] = i / 3;
+
+  std::vector<bool> used(triCount, false);
+  std::vector<unsigned char> local(vertCount, MeshletNoVertex);
+  unsigned nextSeed = 0;
+  unsigned remaining = triCount;
+
+  while(remaining)
+  {
+    Meshlet meshlet;
+    meshlet.vertOffset_ = data.verts_.size();
+    meshlet.triOffset_ = data.tris_.size() / 3;
+    meshlet.vertCount_ = 0;
+    meshlet.triCount_ = 0;
+
+    //Carry on from the previous meshlet's neighbourhood when it has one left over
+    unsigned seed = triCount;
+    if(!data.meshlets_.empty())
+    {
+      const Meshlet& last = data.meshlets_.back();
+      for(unsigned i = 0; i < last.vertCount_ && seed == triCount; ++i)
+      {
+        unsigned v = data.verts_[last.vertOffset_ + i];
+        for(unsigned t = triStart[v]; t < triStart[v + 1]; ++t)
+          if(!used[triList[t]])
+          {
+            seed = triList[t];
+            break;
+          }
+      }
+    }
+    if(seed == triCount)
+    {
+      while(used[nextSeed])
+        ++nextSeed;
+      seed = nextSeed;
+    }
+
+    unsigned candidate = seed;
+    Float3 centroid = MakeFloat3(0, 0, 0);
+
+    while(candidate != triCount)
+    {
+      //Add the triangle, giving its new vertices a local index
+      const int* tri = &indices[candidate * 3];
+      for(unsigned k = 0; k < 3; ++k)
+      {
+        if(local[tri[k]] == MeshletNoVertex)
+        {
+          local[tri[k]] = static_cast<unsigned char>(meshlet.vertCount_++);
+          data.verts_.push_back(tri[k]);
+          centroid += positions[tri[k]];
+        }
+        data.tris_.push_back(local[tri[k]]);
+      }
+      ++meshlet.triCount_;
+      used[candidate] = true;
+      --remaining;
+
+      if(meshlet.triCount_ == MeshletMaxTris)
+        break;
+
+      //Pick the neighbouring triangle adding the fewest vertices, closest to the middle on ties
+      Float3 center = centroid * (1.0f / meshlet.vertCount_);
+      unsigned best = triCount;
+      unsigned bestExtra = 4;
+      float bestDist = FLT_MAX;
+
+      for(unsigned i = meshlet.vertOffset_; i < data.verts_.size(); ++i)
+      {
+        unsigned v = data.verts_[i];
+        for(unsigned t = triStart[v]; t < triStart[v + 1]; ++t)
+        {
+          unsigned other = triList[t];
+          if(used[other])
+            continue;
+
+          const int* otherTri = &indices[other * 3];
+          unsigned extra = 0;
+          for(unsigned k = 0; k < 3; ++k)
+            if(local[otherTri[k]] == MeshletNoVertex)
+              ++extra;
+
+          if(meshlet.vertCount_ + extra > MeshletMaxVerts)
+            continue;
+
+          Float3 triCenter = (positions[otherTri[0]] + positions[otherTri[1]] + positions[otherTri[2]]) * (1.0f / 3.0f);
+          Float3 offset = triCenter - center;
+          float dist = Dot(offset, offset);
+          if(extra < bestExtra || (extra == bestExtra && dist < bestDist))
+          {
+            best = other;
+            bestExtra = extra;
+            bestDist = dist;
+          }
+        }
+      }
+
+      candidate = best;
+    }
+
+    //Reset the local indices for the next meshlet
+    for(unsigned i = meshlet.vertOffset_; i < data.verts_.size(); ++i)
+      local[data.verts_[i]] = MeshletNoVertex;
+
+    ComputeMeshletBounds(positions, data, meshlet);
+    data.meshlets_.push_back(meshlet);
+  }
+}
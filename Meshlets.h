@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////
+//* Filename: Meshlets.h                              //
+//  Author: Colt Johnson                              //
+//  Info: Splits triangle lists into small clusters   //
+//        with bounds for cluster culling.            //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "MathTypes.h"
+
+const unsigned MeshletMaxVerts = 64;
+const unsigned MeshletMaxTris = 124;
+
+  //A cluster of at most MeshletMaxVerts vertices and MeshletMaxTris triangles.
+  //The cluster is backfacing from camera position c when
+  //  dot(normalize(coneApex_ - c), coneAxis_) >= coneCutoff_
+  //A cutoff of 1 means the cone is too wide to ever cull.
+  struct Meshlet
+  {
+    unsigned vertOffset_;
+    unsigned triOffset_;
+    unsigned vertCount_;
+    unsigned triCount_;
+
+    Float3 center_;
+    float radius_;
+
+    Float3 coneApex_;
+    Float3 coneAxis_;
+    float coneCutoff_;
+  };
+
+  struct MeshletData
+  {
+    std::vector<Meshlet> meshlets_;
+
+    //Vertex buffer indices, vertCount_ of them per meshlet from vertOffset_
+    std::vector<unsigned> verts_;
+
+    //Three indices into the meshlet's vertices per triangle, from triOffset_ * 3
+    std::vector<unsigned char> tris_;
+  };
+
+  //Appends the meshlets for indexCount indices into a vertex buffer of vertCount
+  //vertices. Triangles are grown out from a seed by picking the neighbour that
+  //adds the fewest new vertices so each meshlet stays spatially compact.
+  void BuildMeshlets(const Float3* positions, unsigned vertCount, const int* indices, unsigned indexCount, MeshletData& data);
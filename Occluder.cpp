@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////
+//* Filename: Occluder.cpp                            //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Occluder.h"
+#include "Voxels.h"
+#include "Adjacency.h"
+#include <algorithm>
+
+//Triangles a box costs before any of its faces are dropped
+const unsigned OccluderBoxTris = 12;
+
+//Inside cells a box has already taken
+const unsigned char VoxelBoxed = VoxelCellStates;
+
+//Inclusive cell range of a box
+struct OccluderBox
+{
+  int lo_[3];
+  int hi_[3];
+  unsigned volume_;
+};
+
+static bool BoxLarger(const OccluderBox& a, const OccluderBox& b)
+{
+  return a.volume_ > b.volume_;
+}
+
+//Steps from every inside cell to the nearest cell that isn't, so boxes can be
+//seeded from the middle of the solid outwards
+static void InsideDepth(const VoxelGrid& grid, std::vector<unsigned short>& depth)
+{
+  std::vector<unsigned> queue;
+  depth.assign(grid.cells_.size(), 0);
+  for(unsigned i = 0; i < grid.cells_.size(); ++i)
+    if(grid.cells_[i] != VoxelInside)
+      queue.push_back(i);
+
+  for(unsigned q = 0; q < queue.size(); ++q)
+  {
+    unsigned index = queue[q];
+    int coords[3];
+    grid.Coords(index, coords);
+    for(int s = 0; s < 6; ++s)
+    {
+      int n[3] = {coords[0] + VoxelSteps[s][0], coords[1] + VoxelSteps[s][1], coords[2] + VoxelSteps[s][2]};
+      if(!grid.Contains(n))
+        continue;
+
+      unsigned next = grid.Index(n[0], n[1], n[2]);
+      if(grid.cells_[next] == VoxelInside && !depth[next])
+      {
+        depth[next] = depth[index] + 1;
+        queue.push_back(next);
+      }
+    }
+  }
+}
+
+//True when every cell of box's layer next to it along axis (side -1 or 1) is value
+static bool LayerIs(const VoxelGrid& grid, const int lo[3], const int hi[3], int axis, int side, unsigned char value)
+{
+  int layer = side < 0 ? lo[axis] - 1 : hi[axis] + 1;
+  if(layer < 0 || layer >= grid.dims_[axis])
+    return false;
+
+  int from[3] = {lo[0], lo[1], lo[2]};
+  int to[3] = {hi[0], hi[1], hi[2]};
+  from[axis] = to[axis] = layer;
+
+  for(int z = from[2]; z <= to[2]; ++z)
+    for(int y = from[1]; y <= to[1]; ++y)
+      for(int x = from[0]; x <= to[0]; ++x)
+        if(grid.cells_[grid.Index(x, y, z)] != value)
+          return false;
+  return true;
+}
+
+//Grows a box from the seed one layer at a time in every direction it can go
+//while it only covers inside cells no other box took
+static OccluderBox GrowBox(VoxelGrid& grid, unsigned seed)
+{
+  OccluderBox box;
+  grid.Coords(seed, box.lo_);
+  grid.Coords(seed, box.hi_);
+
+  for(bool grew = true; grew;)
+  {
+    grew = false;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+      for(int side = -1; side <= 1; side += 2)
+      {
+        if(LayerIs(grid, box.lo_, box.hi_, axis, side, VoxelInside))
+        {
+          if(side < 0)
+            --box.lo_[axis];
+          else
+            ++box.hi_[axis];
+          grew = true;
+        }
+      }
+    }
+  }
+
+  box.volume_ = 1;
+  for(int a = 0; a < 3; ++a)
+    box.volume_ *= box.hi_[a] - box.lo_[a] + 1;
+
+  for(int z = box.lo_[2]; z <= box.hi_[2]; ++z)
+    for(int y = box.lo_[1]; y <= box.hi_[1]; ++y)
+      for(int x = box.lo_[0]; x <= box.hi_[0]; ++x)
+        grid.cells_[grid.Index(x, y, z)] = VoxelBoxed;
+  return box;
+}
+
+//Writes the box's faces that aren't pressed flat against kept boxes. Kept cells
+//are marked VoxelInside again by the caller, everything else is not.
+static void EmitBox(const VoxelGrid& grid, const OccluderBox& box, OccluderMesh& occluder)
+{
+  Float3 lo = grid.Corner(box.lo_[0], box.lo_[1], box.lo_[2]);
+  Float3 hi = grid.Corner(box.hi_[0] + 1, box.hi_[1] + 1, box.hi_[2] + 1);
+
+  //Corner c has bit a set when it is on the max side of axis a
+  int corners[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
+
+  for(int axis = 0; axis < 3; ++axis)
+  {
+    for(int side = -1; side <= 1; side += 2)
+    {
+      if(LayerIs(grid, box.lo_, box.hi_, axis, side, VoxelInside))
+        continue;
+
+      //Walking u then v turns around +axis, so the max side goes forwards and
+      //the min side backwards to keep every face pointing out
+      int u = (axis + 1) % 3;
+      int v = (axis + 2) % 3;
+      int base = side > 0 ? 1 << axis : 0;
+      int quad[4] = {base, base | (1 << u), base | (1 << u) | (1 << v), base | (1 << v)};
+      if(side < 0)
+        std::swap(quad[1], quad[3]);
+
+      int ids[4];
+      for(int q = 0; q < 4; ++q)
+      {
+        int c = quad[q];
+        if(corners[c] < 0)
+        {
+          corners[c] = occluder.positions_.size();
+          occluder.positions_.push_back(MakeFloat3(c & 1 ? hi.x : lo.x, c & 2 ? hi.y : lo.y, c & 4 ? hi.z : lo.z));
+        }
+        ids[q] = corners[c];
+      }
+
+      occluder.indices_.push_back(ids[0]);
+      occluder.indices_.push_back(ids[1]);
+      occluder.indices_.push_back(ids[2]);
+      occluder.indices_.push_back(ids[0]);
+      occluder.indices_.push_back(ids[2]);
+      occluder.indices_.push_back(ids[3]);
+    }
+  }
+}
+
+bool BuildOccluder(const Float3* positions, const int* indices, unsigned indexCount,
+                   const unsigned* weldIds, unsigned resolution, unsigned targetTris,
+                   OccluderMesh& occluder)
+{
+  occluder.positions_.clear();
+  occluder.indices_.clear();
+  if(targetTris < OccluderBoxTris)
+    return false;
+
+  //A crack narrower than a cell would be sealed by the surface cells, the
+  //outside gets in along its open edges instead
+  MeshEdges edges;
+  BuildEdges(indices, indexCount, weldIds, edges);
+  std::vector<Float3> openEdges;
+  for(unsigned h = 0; h < edges.flags_.size(); ++h)
+  {
+    if(edges.flags_[h] & EdgeBoundary)
+    {
+      unsigned corner = h - h % 3;
+      openEdges.push_back(positions[indices[h]]);
+      openEdges.push_back(positions[indices[corner + (h + 1) % 3]]);
+    }
+  }
+
+  VoxelGrid grid;
+  if(!VoxelizeSolid(positions, indices, indexCount, resolution, grid,
+                    openEdges.empty() ? NULL : &openEdges[0], openEdges.size() / 2))
+    return false;
+
+  //Deepest cells first, then in grid order so the result is always the same
+  std::vector<unsigned short> depth;
+  InsideDepth(grid, depth);
+
+  std::vector<unsigned> seeds;
+  for(unsigned i = 0; i < grid.cells_.size(); ++i)
+    if(grid.cells_[i] == VoxelInside)
+      seeds.push_back(i);
+
+  std::stable_sort(seeds.begin(), seeds.end(), [&](unsigned a, unsigned b) { return depth[a] > depth[b]; });
+
+  std::vector<OccluderBox> boxes;
+  for(unsigned s = 0; s < seeds.size(); ++s)
+    if(grid.cells_[seeds[s]] == VoxelInside)
+      boxes.push_back(GrowBox(grid, seeds[s]));
+
+  std::stable_sort(boxes.begin(), boxes.end(), BoxLarger);
+  boxes.resize(std::min<size_t>(boxes.size(), targetTris / OccluderBoxTris));
+
+  //Only the kept boxes hide each other's faces
+  for(unsigned b = 0; b < boxes.size(); ++b)
+    for(int z = boxes[b].lo_[2]; z <= boxes[b].hi_[2]; ++z)
+      for(int y = boxes[b].lo_[1]; y <= boxes[b].hi_[1]; ++y)
+        for(int x = boxes[b].lo_[0]; x <= boxes[b].hi_[0]; ++x)
+          grid.cells_[grid.Index(x, y, z)] = VoxelInside;
+
+  for(unsigned b = 0; b < boxes.size(); ++b)
+    EmitBox(grid, boxes[b], occluder);
+
+  return !occluder.indices_.empty();
+}
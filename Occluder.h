@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////
+//* Filename: Occluder.h                              //
+//  Author: Colt Johnson                              //
+//  Info: Conservative low poly occluders for the     //
+//        software occlusion culling rasterizer.      //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "MathTypes.h"
+
+  //Position only triangle list, wound like the meshes it was made from
+  struct OccluderMesh
+  {
+    std::vector<Float3> positions_;
+    std::vector<int> indices_;
+  };
+
+  //Voxelizes the triangles at resolution cells along their longest axis, flood
+  //fills the outside and covers the cells left inside with boxes, largest first,
+  //until the next box could take the occluder past targetTris triangles. The
+  //boxes never leave the solid so the occluder only hides what the mesh would.
+  //Open meshes have no inside and give an empty occluder, however narrow the
+  //opening: the fill goes through every boundary edge (by weldIds, as for
+  //BuildEdges). Box faces pressed against other boxes are dropped. Returns
+  //false when occluder is empty.
+  bool BuildOccluder(const Float3* positions, const int* indices, unsigned indexCount,
+                     const unsigned* weldIds, unsigned resolution, unsigned targetTris,
+                     OccluderMesh& occluder);
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////
+//* Filename: Occlusion.cpp                           //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Occlusion.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+//Vertices a thread takes from the shared counter at a time
+const unsigned OcclusionBatch = 64;
+
+//Rays start this fraction of the ray length above the surface so they don't
+//hit the triangles around the vertex they leave from
+const float OcclusionBias = 1e-3f;
+
+const float OcclusionPi = 3.14159265f;
+
+//Van der Corput sequence, the second coordinate of the Hammersley points
+static float RadicalInverse(unsigned bits)
+{
+  bits = (bits << 16) | (bits >> 16);
+  bits = ((bits & 0x55555555u) << 1) | ((bits & 0xaaaaaaaau) >> 1);
+  bits = ((bits & 0x33333333u) << 2) | ((bits & 0xccccccccu) >> 2);
+  bits = ((bits & 0x0f0f0f0fu) << 4) | ((bits & 0xf0f0f0f0u) >> 4);
+  bits = ((bits & 0x00ff00ffu) << 8) | ((bits & 0xff00ff00u) >> 8);
+  return bits * (1.0f / 4294967296.0f);
+}
+
+//Scrambles the vertex index into the per vertex rotation of the sample pattern
+static unsigned HashVertex(unsigned v)
+{
+  v ^= v >> 16;
+  v *= 0x7feb352du;
+  v ^= v >> 15;
+  v *= 0x846ca68bu;
+  v ^= v >> 16;
+  return v;
+}
+
+//Orthonormal tangent and bitangent around a unit normal without any branches on
+//which axis to cross with
+static void Basis(const Float3& n, Float3& t, Float3& b)
+{
+  float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+  float a = -1.0f / (sign + n.z);
+  float c = n.x * n.y * a;
+  t = MakeFloat3(1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+  b = MakeFloat3(c, sign + n.y * n.y * a, -n.y);
+}
+
+static unsigned char VertexOcclusion(const Bvh& bvh, const Float3* positions, const int* indices,
+                                     const Float3& position, Float3 n, unsigned vertex,
+                                     unsigned sampleCount, float maxDistance)
+{
+  float length = Length(n);
+  if(length <= 0.0f)
+    return 255;
+  n /= length;
+
+  Float3 t, b;
+  Basis(n, t, b);
+
+  //Hammersley points shifted per vertex so neighbours don't band together
+  unsigned hash = HashVertex(vertex);
+  float shiftU = (hash & 0xffff) * (1.0f / 65536.0f);
+  float shiftV = (hash >> 16) * (1.0f / 65536.0f);
+
+  Float3 origin = position + n * (maxDistance * OcclusionBias);
+  unsigned open = 0;
+  for(unsigned s = 0; s < sampleCount; ++s)
+  {
+    float u = (s + 0.5f) / sampleCount + shiftU;
+    float v = RadicalInverse(s) + shiftV;
+    u -= std::floor(u);
+    v -= std::floor(v);
+
+    //Cosine weighted, so every ray counts the same towards the result
+    float r = std::sqrt(u);
+    float phi = 2.0f * OcclusionPi * v;
+    Float3 dir = t * (r * std::cos(phi)) + b * (r * std::sin(phi)) + n * std::sqrt(std::max(0.0f, 1.0f - u));
+
+    if(!OccludedBvh(bvh, positions, indices, origin, dir, maxDistance))
+      ++open;
+  }
+
+  return static_cast<unsigned char>((open * 255 + sampleCount / 2) / sampleCount);
+}
+
+void BakeOcclusion(const Bvh& bvh, const Float3* positions, const Float3* normals, unsigned vertCount,
+                   const int* indices, unsigned sampleCount, float maxDistance,
+                   std::vector<unsigned char>& occlusion, unsigned threadCount)
+{
+  occlusion.assign(vertCount, 255);
+  if(!vertCount || !sampleCount || bvh.nodes_.empty())
+    return;
+
+  if(!threadCount)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  threadCount = std::min(threadCount, (vertCount + OcclusionBatch - 1) / OcclusionBatch);
+
+  std::atomic<unsigned> nextBatch(0);
+  auto work = [&]()
+  {
+    for(unsigned start = nextBatch.fetch_add(OcclusionBatch); start < vertCount; start = nextBatch.fetch_add(OcclusionBatch))
+    {
+      unsigned end = std::min(vertCount, start + OcclusionBatch);
+      for(unsigned v = start; v < end; ++v)
+        occlusion[v] = VertexOcclusion(bvh, positions, indices, positions[v], normals[v], v, sampleCount, maxDistance);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(unsigned t = 1; t < threadCount; ++t)
+    threads.push_back(std::thread(work));
+  work();
+  for(unsigned t = 0; t < threads.size(); ++t)
+    threads[t].join();
+}
@@ -0,0 +1,21 @@
+////////////////////////////////////////////////////////
+//* Filename: Occlusion.h                             //
+//  Author: Colt Johnson                              //
+//  Info: Per vertex ambient occlusion baked by ray   //
+//        casting against the mesh BVH.               //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "Bvh.h"
+
+  //Casts sampleCount cosine weighted rays over each vertex's normal hemisphere,
+  //up to maxDistance long, and stores the unoccluded fraction as 0 (fully
+  //occluded) to 255 (open sky). Vertices are split across threadCount threads,
+  //0 uses every core. The samples only depend on the vertex so the result is the
+  //same however many threads run.
+  void BakeOcclusion(const Bvh& bvh, const Float3* positions, const Float3* normals, unsigned vertCount,
+                     const int* indices, unsigned sampleCount, float maxDistance,
+                     std::vector<unsigned char>& occlusion, unsigned threadCount = 0);
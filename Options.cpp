@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////
+//* Filename: Options.cpp                             //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Options.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+ConvertOptions::ConvertOptions(void)
+  : cleanMesh_(true), buildBvh_(false), bvhBenchRays_(0), aoSamples_(0), aoDistance_(0.0f), occluderTris_(0),
+    cookCollision_(false), maxHulls_(0), maxHullVerts_(64), buildEdges_(false), adjacencyIndices_(false),
+    depthStream_(false), buildMeshlets_(false), instanceMeshes_(false), gridCellSize_(0.0f),
+    animationOnly_(false), skipAnimations_(false), splitClips_(false), pruneBones_(false),
+    compressTextures_(false)
+{
+}
+
+//Reads a comma separated list of numbers such as 0.5,0.25,0.12
+//Reads a comma separated list of ratios, every one of them in (0, 1]
+static bool ParseRatioList(const char *text, std::vector<float>& values)
+{
+  values.clear();
+  while(*text)
+  {
+    char *end;
+    double value = strtod(text, &end);
+    if(end == text || !(value > 0.0 && value <= 1.0))
+      return false;
+
+    values.push_back(static_cast<float>(value));
+    text = *end == ',' ? end + 1 : end;
+  }
+
+  return !values.empty();
+}
+
+bool ParseOptions(int argc, char** argv, int first, ConvertOptions& options)
+{
+  for(int i = first; i < argc; ++i)
+  {
+    const char *arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if(!strcmp(arg, "-noclean"))
+      options.cleanMesh_ = false;
+    else if(!strcmp(arg, "-bvh"))
+      options.buildBvh_ = true;
+    else if(!strcmp(arg, "-bvhbench") && hasValue)
+    {
+      options.buildBvh_ = true;
+      options.bvhBenchRays_ = static_cast<unsigned>(atoi(argv[++i]));
+    }
+    else if(!strcmp(arg, "-ao") && hasValue)
+      options.aoSamples_ = static_cast<unsigned>(atoi(argv[++i]));
+    else if(!strcmp(arg, "-aodist") && hasValue)
+      options.aoDistance_ = static_cast<float>(atof(argv[++i]));
+    else if(!strcmp(arg, "-occluder") && hasValue)
+      options.occluderTris_ = static_cast<unsigned>(atoi(argv[++i]));
+    else if(!strcmp(arg, "-collision"))
+      options.cookCollision_ = true;
+    else if(!strcmp(arg, "-hulls") && hasValue)
+    {
+      options.cookCollision_ = true;
+      options.maxHulls_ = static_cast<unsigned>(atoi(argv[++i]));
+    }
+    else if(!strcmp(arg, "-hullverts") && hasValue)
+      options.maxHullVerts_ = static_cast<unsigned>(atoi(argv[++i]));
+    else if(!strcmp(arg, "-edges"))
+      options.buildEdges_ = true;
+    else if(!strcmp(arg, "-adjacency"))
+      options.buildEdges_ = options.adjacencyIndices_ = true;
+    else if(!strcmp(arg, "-depth"))
+      options.depthStream_ = true;
+    else if(!strcmp(arg, "-meshlets"))
+      options.buildMeshlets_ = true;
+    else if(!strcmp(arg, "-instance"))
+      options.instanceMeshes_ = true;
+    else if(!strcmp(arg, "-grid") && hasValue)
+      options.gridCellSize_ = static_cast<float>(atof(argv[++i]));
+    else if(!strcmp(arg, "-skeletons") && hasValue)
+      options.skeletonDir_ = argv[++i];
+    else if(!strcmp(arg, "-animonly"))
+      options.animationOnly_ = true;
+    else if(!strcmp(arg, "-noanims"))
+      options.skipAnimations_ = true;
+    else if(!strcmp(arg, "-clips"))
+      options.splitClips_ = true;
+    else if(!strcmp(arg, "-cache") && hasValue)
+      options.cacheDir_ = argv[++i];
+    else if(!strcmp(arg, "-textures"))
+      options.compressTextures_ = true;
+    else if(!strcmp(arg, "-prune"))
+      options.pruneBones_ = true;
+    else if(!strcmp(arg, "-skellod") && hasValue)
+    {
+      if(!ParseRatioList(argv[++i], options.skeletonLodRatios_))
+      {
+        printf("Bad skeleton level of detail list %s, ratios go above 0 up to 1\n", argv[i]);
+        return false;
+      }
+    }
+    else if(!strcmp(arg, "-lod") && hasValue)
+    {
+      if(!ParseRatioList(argv[++i], options.lodRatios_))
+      {
+        printf("Bad level of detail list %s, ratios go above 0 up to 1\n", argv[i]);
+        return false;
+      }
+    }
+    else
+    {
+      printf("Unknown option %s\n", arg);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void PrintUsage(void)
+{
+  printf("Please type FBXConverter filename [options]\n");
+  printf("  -noclean       keep degenerate and duplicate triangles and unused vertices\n");
+  printf("  -bvh           write a ray query BVH for the mesh\n");
+  printf("  -bvhbench N    build the BVH and time N random rays against it\n");
+  printf("  -ao N          bake per vertex ambient occlusion with N rays per vertex\n");
+  printf("  -aodist D      longest ambient occlusion ray (defaults to a quarter of the mesh radius)\n");
+  printf("  -occluder N    build an inner box occluder of at most N triangles per sub mesh (static only)\n");
+  printf("  -collision     cook a convex hull of every sub mesh for physics\n");
+  printf("  -hulls N       also split every sub mesh into at most N convex pieces\n");
+  printf("  -hullverts N   most vertices a collision hull keeps (default 64)\n");
+  printf("  -lod R,R,...   add simplified levels of detail at these triangle ratios\n");
+  printf("  -edges         write every triangle edge's neighbour and flag open and non manifold edges\n");
+  printf("  -adjacency     also write six index triangle list with adjacency indices\n");
+  printf("  -depth         add a position only stream with cache ordered indices for depth passes\n");
+  printf("  -meshlets      split the mesh into culling clusters with bounds\n");
+  printf("  -instance      write shared meshes once plus an instance table (static only)\n");
+  printf("  -grid SIZE     also write the scene split into SIZE sized streaming cells (static only)\n");
+  printf("  -cache DIR     reuse the imported scene from DIR when the input hasn't changed\n");
+  printf("  -textures      compress the material textures to mipmapped .dds files\n");
+  printf("  -prune         drop bones that don't move any vertices\n");
+  printf("  -skellod R,R   add reduced skeletons keeping these ratios of the bones\n");
+  printf("  -animonly      only export the clips, one file each, without touching the mesh\n");
+  printf("  -noanims       export the mesh and skeleton without any clips\n");
+  printf("  -clips         write each clip to its own file instead of the .gmf\n");
+  printf("  -skeletons DIR share the skeleton through a file in DIR instead of embedding it (skinned only)\n");
+  printf("Type FBXConverter -batch to convert a list of files with several processes\n");
+}
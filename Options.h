@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////
+//* Filename: Options.h                               //
+//  Author: Colt Johnson                              //
+//  Info: Command line switches for the optional      //
+//        processing stages.                          //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include <string>
+
+  struct ConvertOptions
+  {
+    ConvertOptions(void);
+
+    //Drop collapsed, zero area and duplicate triangles and the vertices only
+    //they used before anything else is built (on unless -noclean)
+    bool cleanMesh_;
+
+    //Build a ray query BVH over the combined mesh (-bvh)
+    bool buildBvh_;
+    //Rays cast against the BVH once it is built, 0 skips the benchmark (-bvhbench N)
+    unsigned bvhBenchRays_;
+
+    //Hemisphere rays cast per vertex to bake ambient occlusion, 0 is off (-ao N)
+    unsigned aoSamples_;
+    //Longest occlusion ray, 0 picks a quarter of the mesh's bounding radius (-aodist D)
+    float aoDistance_;
+
+    //Static scenes only: build a box occluder of at most this many triangles
+    //inside every sub mesh for software occlusion culling, 0 is off (-occluder N)
+    unsigned occluderTris_;
+
+    //Cook a convex hull of every sub mesh for physics (-collision)
+    bool cookCollision_;
+    //Also cut every sub mesh into at most this many convex pieces, 1 or less
+    //is off (-hulls N, implies -collision)
+    unsigned maxHulls_;
+    //Most vertices any collision hull keeps (-hullverts N)
+    unsigned maxHullVerts_;
+
+    //Pair up the triangles' edges and flag boundary and non manifold ones (-edges)
+    bool buildEdges_;
+    //Also write six indices per triangle for triangle list with adjacency
+    //drawing (-adjacency, implies -edges)
+    bool adjacencyIndices_;
+
+    //Also write the vertices welded back to their control points as a position
+    //only stream, with its own cache ordered indices, for depth and shadow passes (-depth)
+    bool depthStream_;
+
+    //Triangle ratios of the simplified levels of detail to make, each one
+    //built from the level before it (-lod 0.5,0.25,0.12)
+    std::vector<float> lodRatios_;
+
+    //Split the mesh into culling clusters (-meshlets)
+    bool buildMeshlets_;
+
+    //Static scenes only: write every distinct mesh once in its local space
+    //plus a table of the nodes placing it (-instance)
+    bool instanceMeshes_;
+
+    //Static scenes only: also write the triangles bucketed into cubic cells of
+    //this size, each cell as its own file plus a .grid index. 0 is off (-grid SIZE)
+    float gridCellSize_;
+
+    //Skinned only: write the skeleton once into this directory, named by a hash
+    //of its hierarchy and bind pose, and only refer to it from the .gmf (-skeletons DIR)
+    std::string skeletonDir_;
+
+    //Skinned only: skip the mesh and skin entirely and only write the
+    //skeleton's clips, each to its own file (-animonly)
+    bool animationOnly_;
+    //Leave the clips out of the .gmf (-noanims)
+    bool skipAnimations_;
+    //Write every clip to its own .gma next to the .gmf instead of into it (-clips)
+    bool splitClips_;
+
+    //Skinned only: drop bones that move no vertices and have no descendants that do (-prune)
+    bool pruneBones_;
+    //Skinned only: bone ratios of reduced skeletons, minor leaf bones are
+    //collapsed into their parents. Each level is built from the one before it (-skellod 0.5,0.25)
+    std::vector<float> skeletonLodRatios_;
+
+    //Keep a snapshot of the imported scene in this directory, keyed by a hash of
+    //the input file, and load it instead of importing on later runs (-cache DIR)
+    std::string cacheDir_;
+
+    //Decode the textures the materials use and write them next to the .gmf as
+    //mipmapped BC1/BC3/BC5 .dds files (-textures)
+    bool compressTextures_;
+  };
+
+  //Reads the switches in argv[first] onwards. Returns false on anything it doesn't know.
+  bool ParseOptions(int argc, char** argv, int first, ConvertOptions& options);
+  void PrintUsage(void);
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////
+//* Filename: OutputBuffer.cpp                        //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "OutputBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+#ifdef _WIN32
+  #define NOMINMAX
+  #define WIN32_LEAN_AND_MEAN
+  #include <Windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+//Tells apart temp files of the same process
+static std::atomic<unsigned> TempCounter(0);
+
+const char* FindSection(const OutputFile& file, unsigned tag, size_t& size)
+{
+  for(unsigned i = 0; i < file.sections_.size(); ++i)
+  {
+    if(file.sections_[i].tag_ == tag)
+    {
+      size = file.sections_[i].size_;
+      return file.data_.empty() ? NULL : &file.data_[file.sections_[i].offset_];
+    }
+  }
+
+  size = 0;
+  return NULL;
+}
+
+OutputFile WithoutDependency(const OutputFile& file)
+{
+  //Section offsets would go stale, the spliced copy is only for saving
+  OutputFile spliced;
+  spliced.name_ = file.name_;
+  size_t copied = 0;
+  for(unsigned i = 0; i < file.fallback_.size(); ++i)
+  {
+    const OutputSplice& splice = file.fallback_[i];
+    spliced.data_.insert(spliced.data_.end(), file.data_.begin() + copied, file.data_.begin() + splice.offset_);
+    spliced.data_.insert(spliced.data_.end(), splice.data_.begin(), splice.data_.end());
+    copied = splice.offset_ + splice.size_;
+  }
+  spliced.data_.insert(spliced.data_.end(), file.data_.begin() + copied, file.data_.end());
+  return spliced;
+}
+
+std::string TempPathFor(const std::string& path)
+{
+  //Process ids repeat across machines sharing a disk, the clock keeps them apart
+  unsigned long long ticks = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+  char suffix[96];
+#ifdef _WIN32
+  sprintf(suffix, ".tmp%lu_%u_%llx", GetCurrentProcessId(), TempCounter++, ticks);
+#else
+  sprintf(suffix, ".tmp%d_%u_%llx", static_cast<int>(getpid()), TempCounter++, ticks);
+#endif
+  return path + suffix;
+}
+
+bool MoveIntoPlace(const std::string& temp, const std::string& path)
+{
+#ifdef _WIN32
+  bool moved = MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  bool moved = !rename(temp.c_str(), path.c_str());
+#endif
+  if(!moved)
+  {
+    printf("Couldn't move %s into place!\n", temp.c_str());
+    remove(temp.c_str());
+  }
+  return moved;
+}
+
+//Whether the file at path holds exactly data
+static bool SameContents(const std::string& path, const std::vector<char>& data)
+{
+  FILE *fp = fopen(path.c_str(), "rb");
+  if(!fp)
+    return false;
+
+  std::vector<char> stored(data.size() + 1);
+  size_t read = fread(&stored[0], 1, stored.size(), fp);
+  fclose(fp);
+  return read == data.size() && std::equal(data.begin(), data.end(), stored.begin());
+}
+
+bool SaveOutputFile(const OutputFile& file)
+{
+  if(file.shared_)
+  {
+    if(SameContents(file.name_, file.data_))
+    {
+      printf("Sharing %s\n", file.name_.c_str());
+      return true;
+    }
+    FILE *fp = fopen(file.name_.c_str(), "rb");
+    if(fp)
+    {
+      fclose(fp);
+      printf("%s holds something else, replacing it\n", file.name_.c_str());
+    }
+  }
+
+  printf("Writing %s\n", file.name_.c_str());
+  std::string tempPath = TempPathFor(file.name_);
+  FILE *fp = fopen(tempPath.c_str(), "wb");
+  if(!fp)
+  {
+    printf("Couldn't open %s for writing!\n", tempPath.c_str());
+    return false;
+  }
+
+  bool written = file.data_.empty() || fwrite(&file.data_[0], file.data_.size(), 1, fp) == 1;
+  if(fclose(fp) || !written)
+  {
+    printf("Couldn't finish writing %s!\n", file.name_.c_str());
+    remove(tempPath.c_str());
+    return false;
+  }
+  return MoveIntoPlace(tempPath, file.name_);
+}
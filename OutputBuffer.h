@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////
+//* Filename: OutputBuffer.h                          //
+//  Author: Colt Johnson                              //
+//  Info: In memory output files the converter writes //
+//        into, saved to disk only when asked.        //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <cstring>
+#include <string>
+#include <vector>
+
+  //A tagged section of an output, offset_ is where its payload starts
+  struct OutputSection
+  {
+    unsigned tag_;
+    size_t offset_;
+    size_t size_;
+  };
+
+  //Bytes to put in place of data_[offset_, offset_ + size_)
+  struct OutputSplice
+  {
+    size_t offset_;
+    size_t size_;
+    std::vector<char> data_;
+  };
+
+  struct OutputFile
+  {
+    OutputFile(void) : shared_(false) {}
+
+    //Path the command line tool saves it to
+    std::string name_;
+    std::vector<char> data_;
+
+    //Tagged sections in the order they were written
+    std::vector<OutputSection> sections_;
+
+    //Written once for several assets (skeletons), the name says what is in it.
+    //Saving leaves a byte for byte identical copy on disk alone and replaces
+    //any other (a hash collision or a file from an older converter).
+    bool shared_;
+
+    //Name of a shared output this one refers to. When that can't be saved,
+    //the fallback splices are made, earliest offset first, and this is saved
+    //without the reference.
+    std::string dependency_;
+    std::vector<OutputSplice> fallback_;
+  };
+
+  //Same shape as fwrite so the writing code reads the same for files and buffers
+  inline void BufferWrite(const void *data, size_t size, size_t count, OutputFile *out)
+  {
+    size_t bytes = size * count;
+    if(!bytes)
+      return;
+
+    size_t pos = out->data_.size();
+    out->data_.resize(pos + bytes);
+    memcpy(&out->data_[pos], data, bytes);
+  }
+
+  //Payload of the first section with this tag, NULL if there is none
+  const char* FindSection(const OutputFile& file, unsigned tag, size_t& size);
+
+  //The file with its fallback splices made, for when its dependency is missing
+  OutputFile WithoutDependency(const OutputFile& file);
+
+  //Writes the file to its name, returns false if it couldn't be written. The
+  //data goes to a temp file first, readers only ever see the old or new file.
+  //Shared files already on disk count as written.
+  bool SaveOutputFile(const OutputFile& file);
+
+  //A name next to path no other thread or process will pick, to write into
+  //before MoveIntoPlace
+  std::string TempPathFor(const std::string& path);
+
+  //Renames temp to path in one step, replacing what is there. Removes temp and
+  //returns false if it can't.
+  bool MoveIntoPlace(const std::string& temp, const std::string& path);
@@ -10,18 +10,51 @@
 #include "Scene.h"
 #include "Functions.h"
 #include "Converter.h"
+#include "GmfFormat.h"
+#include "Simplify.h"
+#include "Hash.h"
+#include "Snapshot.h"
+#include "Texture.h"
+#include "Occlusion.h"
+#include "VertexCache.h"
+#include "Adjacency.h"
+#include "MeshClean.h"
 
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
 
- Scene::Scene(const char* filename) : filename_(filename)
+//The FBX SDK isn't thread safe, scenes converting at the same time take turns using it
+static std::mutex SdkMutex;
+
+//Samples per second used for the animated bounds tracks
+const float BoundsSampleRate = 30.0f;
+
+//Occlusion rays reach this fraction of the mesh's bounding radius unless told otherwise
+const float OcclusionRadiusScale = 0.25f;
+
+//Cells along the longest side of a sub mesh when voxelizing it for its occluder
+const unsigned OccluderResolution = 32;
+
+//Cells along the longest side of a sub mesh when decomposing it into convex pieces
+const unsigned CollisionResolution = 32;
+
+//Blend shape vertices that move less than this are left out
+const float MorphEpsilon = 1e-5f;
+
+
+ Scene::Scene(const char* filename, const ConvertOptions& options) : filename_(filename), fp_(NULL), skeletonId_(0), options_(options)
  {
-    maxWeights_ = 4;
+    std::lock_guard<std::mutex> lock(SdkMutex);
+
+    maxWeights_ = MaxSkinWeights;
+    mtxConverter_ = NULL;
+    fromSnapshot_ = false;
     tans_ = true;
     bitans_ = true;
 
-    output_ = filename;
-    extension_ = output_.find_last_of(".");
-    output_.erase(extension_);
-    output_.append(".gmf");
+    SetOutputName(filename);
 
     //Initialize the SDK
 	  sdkManager_ = KFbxSdkManager::Create();
@@ -30,12 +63,45 @@
 	  ios_ = KFbxIOSettings::Create(sdkManager_, IOSROOT );
 	  sdkManager_->SetIOSettings(ios_);
 
+    //What to pull out of the scene, skin and skeleton are narrowed down once the type is known
+    extractMesh_ = !options_.animationOnly_;
+    extractSkinData_ = extractMesh_;
+    extractSkeletonData_ = true;
+    extractAnimations_ = !options_.skipAnimations_;
+
+    //Clips don't need anything the mesh is drawn with, don't even import it
+    if(options_.animationOnly_)
+    {
+      ios_->SetBoolProp(IMP_FBX_MATERIAL, false);
+      ios_->SetBoolProp(IMP_FBX_TEXTURE, false);
+      ios_->SetBoolProp(IMP_FBX_SHAPE, false);
+      ios_->SetBoolProp(IMP_FBX_GOBO, false);
+    }
+
   	// Create the empty scene.
 	  scene_ = KFbxScene::Create(sdkManager_,"");
     KFbxGeometryConverter con(sdkManager_);
     converter_ = &con;
  }
 
+ Scene::~Scene(void)
+ {
+   std::lock_guard<std::mutex> lock(SdkMutex);
+
+   //Takes the scene and settings with it
+   sdkManager_->Destroy();
+ }
+
+ //Outputs are named after this, it only has to match the input file when converting from disk
+ void Scene::SetOutputName(const char* name)
+ {
+    output_ = name;
+    size_t extension = output_.find_last_of(".");
+    if(extension != std::string::npos)
+      output_.erase(extension);
+    output_.append(".gmf");
+ }
+
  void Scene::PrintTabs(void)
  {
    for(int i = 0; i < numTabs_; ++i)
@@ -47,6 +113,12 @@ bool Scene::LoadScene(void)
     int lSDKMajor,  lSDKMinor,  lSDKRevision;
     bool lStatus;
 
+    //A snapshot from an earlier run on the same input replaces the whole import
+    if(!options_.cacheDir_.empty() && LoadSnapshot())
+      return true;
+
+    std::lock_guard<std::mutex> lock(SdkMutex);
+
     // Get the version number of the FBX files generated by the
     // version of FBX SDK that you are using.
     KFbxSdkManager::GetFileFormatVersion(lSDKMajor, lSDKMinor, lSDKRevision);
@@ -96,6 +168,62 @@ bool Scene::LoadScene(void)
 
 }
 bool Scene::ExtractScene(void)
+{
+  if(!fromSnapshot_)
+  {
+    std::lock_guard<std::mutex> lock(SdkMutex);
+    StageTimer timer(timings_, "extract");
+    if(!ExtractSceneData())
+      return false;
+
+    if(!options_.cacheDir_.empty())
+      SaveSnapshot();
+  }
+
+  //Everything past here works on the mesh
+  if(!extractMesh_)
+    return true;
+
+  if(options_.instanceMeshes_)
+    RunStage("instance", &Scene::DeduplicateMeshes);
+
+  RunStage("combine", &Scene::CombineMeshes);
+  if(options_.cleanMesh_)
+    RunStage("clean", &Scene::CleanMesh);
+  RunStage("bounds", &Scene::ComputeBounds);
+  RunStage("animbounds", &Scene::CollectAnimatedBounds);
+
+  if(options_.buildBvh_)
+    RunStage("bvh", &Scene::GenerateBvh);
+
+  if(options_.aoSamples_)
+    RunStage("ao", &Scene::GenerateOcclusion);
+
+  if(options_.occluderTris_)
+    RunStage("occluders", &Scene::GenerateOccluders);
+
+  if(options_.cookCollision_)
+    RunStage("collision", &Scene::GenerateCollision);
+
+  if(options_.buildEdges_)
+    RunStage("edges", &Scene::GenerateEdges);
+
+  if(options_.depthStream_)
+    RunStage("depth", &Scene::GenerateDepthStream);
+
+  RunStage("lods", &Scene::GenerateLods);
+  RunStage("skellods", &Scene::GenerateSkeletonLods);
+
+  if(options_.buildMeshlets_)
+    RunStage("meshlets", &Scene::GenerateMeshlets);
+
+  RunStage("partition", &Scene::PartitionScene);
+
+ 
+  return true;
+}
+//Everything that reads the FBX scene, the results are what a snapshot holds
+bool Scene::ExtractSceneData(void)
 {
   KFbxNode* pRootNode = scene_->GetRootNode();
 
@@ -113,123 +241,366 @@ bool Scene::ExtractScene(void)
 
 
 
+  //Skinned meshes are bound to their bind pose, only static ones can be instanced
+  if(options_.instanceMeshes_ && type_ == Skinned)
+  {
+    printf("Instancing is only supported for static scenes, baking transforms.\n");
+    options_.instanceMeshes_ = false;
+  }
+
+  //Static scenes have no bones to skin to or animate
+  extractSkeletonData_ = type_ == Skinned;
+  extractSkinData_ = extractSkinData_ && extractSkeletonData_;
+
+  if(!extractMesh_ && !(extractAnimations_ && extractSkeletonData_))
+  {
+    printf("Animation only export needs a skinned scene with animations.\n");
+    return false;
+  }
+
   //Create a converter to change coordinate spaces for DirectX
   mtxConverter_ = new Converter(scene_);
   PrintScene(scene_->GetRootNode());
-  CollectMeshes(scene_->GetRootNode());
-  CollectBones(scene_->GetRootNode());
-  CollectAnimations();
-  ProcessMeshes();
-  ProcessBones();
 
-  CombineMeshes();
+  if(extractMesh_)
+    CollectMeshes(scene_->GetRootNode());
+  if(extractSkeletonData_)
+  {
+    FillBindPose();
+    CollectBones(scene_->GetRootNode());
+  }
+  if(extractMesh_)
+    ProcessMeshes();
+
+  //Without bones a take can still key the blend shapes
+  bool morphs = false;
+  for(unsigned int i = 0; i < meshes_.size(); ++i)
+    morphs = morphs || !meshes_[i].morphs_.empty();
+  extractAnimations_ = extractAnimations_ && (extractSkeletonData_ || morphs);
+
+  //Needs the skin weights, and has to happen before any keys are sampled
+  if(options_.pruneBones_ && extractSkinData_)
+    PruneBones();
+
+  if(extractAnimations_)
+    CollectAnimations();
+  if(extractSkeletonData_)
+    ProcessBones();
+
+  //Animated bounds need the mesh
+  if(extractMesh_)
+    SampleBoneTransforms();
 
- 
   return true;
 }
 
-void WriteDoubleToFloat(FILE *fp, const double *dubs, int size)
+void WriteDoubleToFloat(OutputFile *fp, const double *dubs, int size)
 {
   for(int i = 0; i < size; ++i)
   {
     float fTd = static_cast<float>(dubs[i]);
-    fwrite(&fTd, sizeof(float), 1, fp);
+    BufferWrite(&fTd, sizeof(float), 1, fp);
+  }
+}
+//Interleaves the vertex streams into the output layout
+void WriteVertex(OutputFile *fp, const VertexStreams& verts, unsigned int i)
+{
+  float vertex[GmfVertexFloats];
+  memcpy(&vertex[0],  &verts.pos_[i],   sizeof(Float3)); //position
+  memcpy(&vertex[3],  &verts.nrm_[i],   sizeof(Float3)); //normal
+  memcpy(&vertex[6],  &verts.uv_[i],    sizeof(Float2)); //uv
+  memcpy(&vertex[8],  &verts.tan_[i],   sizeof(Float3)); //tangent
+  memcpy(&vertex[11], &verts.bitan_[i], sizeof(Float3)); //bitangent
+  BufferWrite(vertex, sizeof(vertex), 1, fp);
+}
+//Writes a section header with a placeholder size and returns where the size lives
+long BeginSection(OutputFile *fp, unsigned tag)
+{
+  unsigned size = 0;
+  BufferWrite(&tag, sizeof(unsigned), 1, fp);
+  long sizePos = fp->data_.size();
+  BufferWrite(&size, sizeof(unsigned), 1, fp);
+  return sizePos;
+}
+//Patches the size of the section started at sizePos and records where it is
+void EndSection(OutputFile *fp, long sizePos)
+{
+  size_t start = sizePos + sizeof(unsigned);
+  unsigned size = static_cast<unsigned>(fp->data_.size() - start);
+  memcpy(&fp->data_[sizePos], &size, sizeof(unsigned));
+
+  OutputSection section;
+  memcpy(&section.tag_, &fp->data_[sizePos - sizeof(unsigned)], sizeof(unsigned));
+  section.offset_ = start;
+  section.size_ = size;
+  fp->sections_.push_back(section);
+}
+//Materials and the ranges of indices drawn with them
+static void WriteMaterialSection(OutputFile *fp, std::vector<Material>& materials, std::vector<MaterialRange>& ranges)
+{
+  long section = BeginSection(fp, GmfSectionMaterials);
+  unsigned int materialCount = materials.size();
+  BufferWrite(&materialCount, sizeof(unsigned int), 1, fp);
+  for(unsigned int i = 0; i < materialCount; ++i)
+  {
+    Material& material = materials[i];
+    unsigned int strsize = material.name_.size();
+    BufferWrite(&strsize, sizeof(unsigned int), 1, fp);
+    BufferWrite(material.name_.c_str(), strsize, 1, fp);
+    BufferWrite(&material.diffuse_, sizeof(Float3), 1, fp);
+    BufferWrite(&material.specular_, sizeof(Float3), 1, fp);
+    BufferWrite(&material.emissive_, sizeof(Float3), 1, fp);
+    BufferWrite(&material.opacity_, sizeof(float), 1, fp);
+    BufferWrite(&material.shininess_, sizeof(float), 1, fp);
+
+    for(unsigned int t = 0; t < GmfTextureSlots; ++t)
+    {
+      strsize = material.textures_[t].size();
+      BufferWrite(&strsize, sizeof(unsigned int), 1, fp);
+      BufferWrite(material.textures_[t].c_str(), strsize, 1, fp);
+    }
+  }
+
+  unsigned int rangeCount = ranges.size();
+  BufferWrite(&rangeCount, sizeof(unsigned int), 1, fp);
+  if(rangeCount)
+    BufferWrite(&ranges[0], sizeof(MaterialRange) * rangeCount, 1, fp);
+  EndSection(fp, section);
+}
+static void WriteMeshBounds(OutputFile *fp, const Aabb& bounds, const BoundingSphere& sphere, const std::vector<SubMesh>& subMeshes)
+{
+  long section = BeginSection(fp, GmfSectionBounds);
+  BufferWrite(&bounds, sizeof(Aabb), 1, fp);
+  BufferWrite(&sphere, sizeof(BoundingSphere), 1, fp);
+
+  unsigned int subCount = subMeshes.size();
+  BufferWrite(&subCount, sizeof(unsigned int), 1, fp);
+  for(unsigned int i = 0; i < subCount; ++i)
+  {
+    const SubMesh& sub = subMeshes[i];
+    BufferWrite(&sub.indexStart_, sizeof(unsigned int), 1, fp);
+    BufferWrite(&sub.indexCount_, sizeof(unsigned int), 1, fp);
+    BufferWrite(&sub.vertStart_, sizeof(unsigned int), 1, fp);
+    BufferWrite(&sub.vertCount_, sizeof(unsigned int), 1, fp);
+
+    unsigned int strsize = sub.name_.size();
+    BufferWrite(&strsize, sizeof(unsigned int), 1, fp);
+    BufferWrite(sub.name_.c_str(), strsize, 1, fp);
+
+    BufferWrite(&sub.bounds_, sizeof(Aabb), 1, fp);
+    BufferWrite(&sub.sphere_, sizeof(BoundingSphere), 1, fp);
+  }
+  EndSection(fp, section);
+}
+//Bone list layout shared by the .gmf payload and skeleton files
+static void WriteBones(OutputFile *fp, std::vector<FbxBone>& bones)
+{
+  unsigned int boneCount = bones.size();
+  BufferWrite(&boneCount, sizeof(unsigned int), 1, fp);
+
+  //Write out all the bone info.
+  for(unsigned int i = 0; i < boneCount; ++i)
+  {
+    WriteDoubleToFloat(fp, reinterpret_cast<double*>(&bones[i].localPos_), 3);      //write bone position
+    WriteDoubleToFloat(fp, reinterpret_cast<double*>(&bones[i].localRot_), 4);      //write bone quaternion
+    WriteDoubleToFloat(fp, reinterpret_cast<double*>(&bones[i].invTransform_), 16); //write inverse bone transform
+    BufferWrite(&bones[i].index_, sizeof(unsigned int), 1, fp);              //write index
+    BufferWrite(&bones[i].pIndex_, sizeof(int), 1, fp);             //write parent index
+
+    //Write out the bone name and its name's length
+    unsigned int strsize = bones[i].name_.size();
+    BufferWrite(&strsize, sizeof(unsigned int), 1, fp);
+    BufferWrite(bones[i].name_.c_str(), strsize, 1, fp);
+  }
+}
+//One animation as laid out in the .gmf payload
+static void WriteAnimation(OutputFile *fp, FbxAnimation& anim)
+{
+  //Write out the animation name and its name's length
+  unsigned int strsize = anim.name_.size();
+  BufferWrite(&strsize, sizeof(unsigned int), 1, fp);
+  BufferWrite(anim.name_.c_str(), strsize, 1, fp);
+
+  BufferWrite(&anim.length_, sizeof(float), 1, fp);          //write animation length
+  unsigned int frameVecCount = anim.frames_.size();
+  BufferWrite(&frameVecCount, sizeof(unsigned int), 1, fp);           //write key frame vector count
+  
+  for(unsigned int j = 0; j < frameVecCount; ++j)                 //write key frame information
+  {
+    unsigned int frameCount = anim.frames_[j].size();
+    BufferWrite(&frameCount, sizeof(unsigned int), 1, fp);             //write key frame count
+    
+    for(unsigned int k = 0; k < frameCount; ++k)
+    {
+      BufferWrite(&anim.frames_[j][k].time_, sizeof(float), 1, fp);          //write time of key frame
+      WriteDoubleToFloat(fp, reinterpret_cast<double*>(&anim.frames_[j][k].localPos_), 3); //write translation
+      WriteDoubleToFloat(fp, reinterpret_cast<double*>(&anim.frames_[j][k].localRot_), 4); //write rotation
+    }
+  }
+}
+//Animated bounds of animCount animations starting at anims
+static void WriteAnimBounds(OutputFile *fp, FbxAnimation *anims, unsigned int animCount)
+{
+  long section = BeginSection(fp, GmfSectionAnimBounds);
+  BufferWrite(&animCount, sizeof(unsigned int), 1, fp);
+  for(unsigned int i = 0; i < animCount; ++i)
+  {
+    unsigned int sampleCount = anims[i].boundsTrack_.size() / 6;
+    BufferWrite(&anims[i].boundsRate_, sizeof(float), 1, fp);
+    BufferWrite(&sampleCount, sizeof(unsigned int), 1, fp);
+    BufferWrite(&anims[i].bounds_, sizeof(Aabb), 1, fp);
+    if(sampleCount)
+      BufferWrite(&anims[i].boundsTrack_[0], sizeof(unsigned short) * 6 * sampleCount, 1, fp);
+  }
+  EndSection(fp, section);
+}
+static void WriteSkinWeights(OutputFile *fp, SkinData& skin, int point)
+{
+  const JointWeight *weights = skin.Weights(point);
+
+  //Write bone indices out as unsigned values.
+  for(unsigned int j = 0; j < 4; ++j)
+  {
+    unsigned char index = static_cast<unsigned char>(weights[j].index);
+    BufferWrite(&index, sizeof(unsigned char), 1, fp);
+  }
+  //write bone weights
+  for(unsigned int j = 0; j < 4; ++j)
+    BufferWrite(&weights[j].weight, sizeof(float), 1, fp);
+}
+static void WriteHull(OutputFile *fp, const ConvexHull& hull)
+{
+  unsigned int vertCount = hull.positions_.size();
+  unsigned int indexCount = hull.indices_.size();
+  BufferWrite(&vertCount, sizeof(unsigned int), 1, fp);
+  BufferWrite(&indexCount, sizeof(unsigned int), 1, fp);
+  BufferWrite(&hull.volume_, sizeof(float), 1, fp);
+  BufferWrite(&hull.centroid_, sizeof(Float3), 1, fp);
+  if(vertCount)
+  {
+    BufferWrite(&hull.positions_[0], sizeof(Float3) * vertCount, 1, fp);
+    BufferWrite(&hull.indices_[0], sizeof(int) * indexCount, 1, fp);
+  }
+}
+//Blend shape curves of animCount animations starting at anims
+static void WriteMorphCurves(OutputFile *fp, FbxAnimation *anims, unsigned int animCount)
+{
+  long section = BeginSection(fp, GmfSectionMorphCurves);
+  BufferWrite(&animCount, sizeof(unsigned int), 1, fp);
+  for(unsigned int i = 0; i < animCount; ++i)
+  {
+    //Static scenes have no animations in the payload to match these up with
+    unsigned int strsize = anims[i].name_.size();
+    BufferWrite(&strsize, sizeof(unsigned int), 1, fp);
+    BufferWrite(anims[i].name_.c_str(), strsize, 1, fp);
+    BufferWrite(&anims[i].length_, sizeof(float), 1, fp);
+
+    unsigned int curveCount = anims[i].morphCurves_.size();
+    BufferWrite(&curveCount, sizeof(unsigned int), 1, fp);
+    for(unsigned int c = 0; c < curveCount; ++c)
+    {
+      MorphCurve& curve = anims[i].morphCurves_[c];
+      unsigned int strsize = curve.name_.size();
+      BufferWrite(&strsize, sizeof(unsigned int), 1, fp);
+      BufferWrite(curve.name_.c_str(), strsize, 1, fp);
+
+      unsigned int keyCount = curve.times_.size();
+      BufferWrite(&keyCount, sizeof(unsigned int), 1, fp);
+      for(unsigned int k = 0; k < keyCount; ++k)
+      {
+        BufferWrite(&curve.times_[k], sizeof(float), 1, fp);
+        BufferWrite(&curve.weights_[k], sizeof(float), 1, fp);
+      }
+    }
   }
+  EndSection(fp, section);
 }
 void Scene::SaveScene(void)
 {
-  printf("Writing %s\n", output_.c_str());
+  if(extractAnimations_ && (options_.splitClips_ || !extractMesh_))
+    SaveClips();
+
+  if(!extractMesh_)
+  {
+    //Make sure the clips' skeleton is available to the engine
+    if(!options_.skeletonDir_.empty())
+      SaveSkeleton();
+    delete mtxConverter_;
+    return;
+  }
+
   //All of the meshes are now stored in meshes_[0]
   FbxMesh& mesh = meshes_[0];
   SkinData& skin = meshes_[0].skin;
 
-  fp_ = fopen(output_.c_str(), "wb");
+  //Renames the materials' textures, so it has to come before they are written
+  if(options_.compressTextures_)
+    SaveTextures();
+
+  fp_ = AddOutput(output_);
 
-  fwrite(&type_, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&type_, sizeof(unsigned int), 1, fp_);
     
   unsigned int vertCount = mesh.verts_.size();
   unsigned int indexCount = mesh.indices_.size();
 
-  fwrite(&vertCount, sizeof(unsigned int), 1, fp_);
-  fwrite(&indexCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&vertCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&indexCount, sizeof(unsigned int), 1, fp_);
 
   for(unsigned int i = 0; i < vertCount; ++i)
   {
-    WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&mesh.verts_[i].pos_), 3);   //write position
-    WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&mesh.verts_[i].nrm_), 3);   //write normal
-    WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&mesh.verts_[i].uv_), 2);    //write uv
-
-    WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&mesh.verts_[i].tan_), 3);   //write tangent
-    WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&mesh.verts_[i].bitan_), 3); //write bitangent
+    WriteVertex(fp_, mesh.verts_, i);
 
     if(type_ == Skinned)
-    {
-      int originalPosInd = mesh.source[i].posIndex;
-      WeightVector& weights = skin.PointWeights[originalPosInd];
-
-      //Write bone indices out as unsigned values.
-      for(unsigned int j = 0; j < 4; ++j)
-      {
-        unsigned char index = static_cast<unsigned char>(weights[j].index);
-        fwrite(&index, sizeof(unsigned char), 1, fp_);
-      }
-      //write bone weights
-      for(unsigned int j = 0; j < 4; ++j)
-        fwrite(&weights[j].weight, sizeof(float), 1, fp_);  
-    }
+      WriteSkinWeights(fp_, skin, mesh.source[i].posIndex);
   }
-  //write out the indices
-  fwrite(&mesh.indices_[0], sizeof(int) * indexCount, 1, fp_);
+  //write out the indices, cleaning can leave none
+  if(indexCount)
+    BufferWrite(&mesh.indices_[0], sizeof(int) * indexCount, 1, fp_);
 
   if(type_ == Skinned)
   {
-    unsigned int boneCount = bones_.size();
-    fwrite(&boneCount, sizeof(unsigned int), 1, fp_);
-
-    //Write out all the bone info.
-    for(unsigned int i = 0; i < boneCount; ++i)
+    //A shared skeleton leaves an empty bone list and is referenced by a section
+    //instead. If the skeleton file can't be saved the bones go back in place.
+    if(!options_.skeletonDir_.empty())
     {
-      WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&bones_[i].localPos_), 3);      //write bone position
-      WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&bones_[i].localRot_), 4);      //write bone quaternion
-      WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&bones_[i].invTransform_), 16); //write inverse bone transform
-      fwrite(&bones_[i].index_, sizeof(unsigned int), 1, fp_);              //write index
-      fwrite(&bones_[i].pIndex_, sizeof(int), 1, fp_);             //write parent index
-
-      //Write out the bone name and its name's length
-      unsigned int strsize = bones_[i].name_.size();
-      fwrite(&strsize, sizeof(unsigned int), 1, fp_);
-      fwrite(bones_[i].name_.c_str(), strsize, 1, fp_);
+      OutputFile *skeleton = SaveSkeleton();
+      OutputSplice bones;
+      bones.offset_ = fp_->data_.size();
+      bones.size_ = sizeof(unsigned int);
+      bones.data_.assign(skeleton->data_.begin() + sizeof(unsigned long long), skeleton->data_.end());
+      fp_->dependency_ = skeleton->name_;
+      fp_->fallback_.push_back(bones);
+
+      unsigned int boneCount = 0;
+      BufferWrite(&boneCount, sizeof(unsigned int), 1, fp_);
     }
+    else
+      WriteBones(fp_, bones_);
     
-    unsigned int animCount = anims_.size();
-    fwrite(&animCount, sizeof(unsigned int), 1, fp_); //write animation count
+    unsigned int animCount = EmbeddedAnimCount();
+    BufferWrite(&animCount, sizeof(unsigned int), 1, fp_); //write animation count
     for(unsigned int i = 0; i < animCount; ++i)      //write animation info
-    {
-      //Write out the animation name and its name's length
-      unsigned int strsize = anims_[i].name_.size();
-      fwrite(&strsize, sizeof(unsigned int), 1, fp_);
-      fwrite(anims_[i].name_.c_str(), strsize, 1, fp_);
-
-      fwrite(&anims_[i].length_, sizeof(float), 1, fp_);          //write animation length
-      unsigned int frameVecCount = anims_[i].frames_.size();
-      fwrite(&frameVecCount, sizeof(unsigned int), 1, fp_);           //write key frame vector count
-      
-      for(unsigned int j = 0; j < frameVecCount; ++j)                 //write key frame information
-      {
-        unsigned int frameCount = anims_[i].frames_[j].size();
-        fwrite(&frameCount, sizeof(unsigned int), 1, fp_);             //write key frame count
-        
-        for(unsigned int k = 0; k < frameCount; ++k)
-        {
-          fwrite(&anims_[i].frames_[j][k].time_, sizeof(float), 1, fp_);          //write time of key frame
-          WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&anims_[i].frames_[j][k].localPos_), 3); //write translation
-          WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&anims_[i].frames_[j][k].localRot_), 4); //write rotation
-        }
-      }
-    }
+      WriteAnimation(fp_, anims_[i]);
   }
 
-  fclose(fp_);
+  WriteBounds(mesh);
+  WriteBvh(mesh);
+  WriteOcclusion(mesh);
+  WriteOccluders(mesh);
+  WriteCollision(mesh);
+  WriteEdges(mesh);
+  WriteDepthStream(mesh);
+  WriteLods(mesh);
+  WriteMeshlets(mesh);
+  WriteInstances();
+  WriteMorphs(mesh);
+  WriteSkeletonRef();
+  WriteSkeletonLods(mesh);
+  WriteMaterials(mesh);
+  fp_ = NULL;
+
+  SaveCells();
   delete mtxConverter_;
 }
 
@@ -323,76 +694,80 @@ void Scene::TransformTansBitans(FbxMesh& mesh, KFbxXMatrix& transform)
 {
   for(unsigned int i = 0; i < mesh.verts_.size(); ++i)
   {
-    mesh.verts_[i].tan_.Normalize();
-    mesh.verts_[i].bitan_.Normalize();
+    Normalize(mesh.verts_.tan_[i]);
+    Normalize(mesh.verts_.bitan_[i]);
   }
 }
-void Scene::AvgTanBins(std::vector<Tri>& triangles, unsigned int numTris, std::vector<FbxVert>& verts, unsigned int numVerts)
+void Scene::AvgTanBins(std::vector<Tri>& triangles, unsigned int numTris, VertexStreams& verts, unsigned int numVerts)
 {
-  //For every vert
+  //Figure out how many triangles share each vertex in one pass over the triangles
+  std::vector<unsigned int> sharedTris(numVerts, 0);
+  for(unsigned int j = 0; j < numTris; ++j)
+    for(unsigned int k = 0; k < 3; ++k)
+      ++sharedTris[triangles[j].v_[k]];
+
+  //For every vert average the tangent and binormal.
   for(unsigned int i = 0; i < numVerts; ++i)
   {
-    unsigned int sharedTris = 0;
-
-    //Figure out how many triangles share this vertex
-    for(unsigned int j = 0; j < numTris; ++j)
-      if(i == triangles[j].p0_ || i == triangles[j].p1_ || i == triangles[j].p2_)
-        ++sharedTris;
+    if(!sharedTris[i])
+      continue;
 
-    //Average the tangent and binormal.
-      verts[i].tan_   /= sharedTris;
-      verts[i].bitan_ /= sharedTris;
+    verts.tan_[i]   /= static_cast<float>(sharedTris[i]);
+    verts.bitan_[i] /= static_cast<float>(sharedTris[i]);
   }
 }
-void Scene::CalcTriTanBinNorm(const KFbxVector4& P1, const KFbxVector4& P2, const KFbxVector4& P3, 
-                       const KFbxVector2& UV1, const KFbxVector2& UV2, const KFbxVector2& UV3,
-                       KFbxVector4 &tangent, KFbxVector4 &binormal)
+void Scene::CalcTriTanBinNorm(const Float3& P1, const Float3& P2, const Float3& P3, 
+                       const Float2& UV1, const Float2& UV2, const Float2& UV3,
+                       Float3 &tangent, Float3 &binormal)
 {
   //Create a vector from p1_ to p2 and p1_ to p3, same with the uv coordinates
-  KFbxVector4 Edge1 = P2 - P1;
-  KFbxVector4 Edge2 = P3 - P1;
-  KFbxVector4 Edge1uv = UV2 - UV1;
-  KFbxVector4 Edge2uv = UV3 - UV1;
+  Float3 Edge1 = P2 - P1;
+  Float3 Edge2 = P3 - P1;
+  Float2 Edge1uv = UV2 - UV1;
+  Float2 Edge2uv = UV3 - UV1;
 
   //Grab the determinant of the matrix created by the uv edges.
-  float det = Edge1uv[1] * Edge2uv[0] - Edge1uv[0] * Edge2uv[1];
+  float det = Edge1uv.y * Edge2uv.x - Edge1uv.x * Edge2uv.y;
 
   if(det) 
   {
     //Use it to "solve" for the tangent and binormal.
     float inverse = 1.0f / det;
-    tangent   = (Edge1 * -Edge2uv[1] + Edge2 *  Edge1uv[1]) * inverse;
-    binormal  = (Edge1 *  Edge2uv[0] + Edge2 * -Edge1uv[0]) * inverse;
+    tangent   = (Edge1 * -Edge2uv.y + Edge2 *  Edge1uv.y) * inverse;
+    binormal  = (Edge1 *  Edge2uv.x + Edge2 * -Edge1uv.x) * inverse;
   }
 }
 void Scene::CalculateTansAndBitans(FbxMesh& mesh)
 {
+  VertexStreams& verts = mesh.verts_;
+
   //Initialize all tangents and binormals.
-  for(unsigned int i = 0; i < mesh.verts_.size(); ++i)
-    mesh.verts_[i].bitan_ = mesh.verts_[i].tan_ = KFbxVector4(0,0,0,0);
+  const Float3 zero = {0, 0, 0};
+  verts.tan_.assign(verts.size(), zero);
+  verts.bitan_.assign(verts.size(), zero);
 
   //Generate tangents and binormals for each triangle.
   for(unsigned int i = 0; i < mesh.numTris; ++i)
   {
-    //Grab the vertexes out of the vertex list to work with.
-    FbxVert& p1 = mesh.verts_[mesh.triangles[i].p0_];
-    FbxVert& p2 = mesh.verts_[mesh.triangles[i].p1_];
-    FbxVert& p3 = mesh.verts_[mesh.triangles[i].p2_];
+    //Grab the vertex indices of this triangle to work with.
+    unsigned p1 = mesh.triangles[i].p0_;
+    unsigned p2 = mesh.triangles[i].p1_;
+    unsigned p3 = mesh.triangles[i].p2_;
 
     //Calculate tangent and binormal for this triangle
-    KFbxVector4 tan, bin;
-    CalcTriTanBinNorm(p1.pos_, p2.pos_, p3.pos_, 
-                      p1.uv_, p2.uv_, p3.uv_, 
+    Float3 tan = zero, bin = zero;
+    CalcTriTanBinNorm(verts.pos_[p1], verts.pos_[p2], verts.pos_[p3], 
+                      verts.uv_[p1], verts.uv_[p2], verts.uv_[p3], 
                       tan, bin);
 
     //Add it to the average of all the vertexes in the triangle.
-    p1.bitan_ += bin;
-    p2.bitan_ += bin;
-    p3.bitan_ += bin;
+    verts.bitan_[p1] += bin;
+    verts.bitan_[p2] += bin;
+    verts.bitan_[p3] += bin;
 
-    p1.tan_ += tan;
-    p2.tan_ += tan;
-    p3.tan_ += tan;
+    verts.tan_[p1] += tan;
+    verts.tan_[p2] += tan;
+    verts.tan_[p3] += tan;
   }
 
   //Now go back through the vert list, and average every triangle that has that vert to get
@@ -412,18 +787,31 @@ void Scene::ProcessMeshes(void)
   //Iterate over all the meshes and get the data we want.
   for(unsigned int i = 0; i < meshes_.size(); ++i)
   {
+    //Everything made per polygon vertex lives in here and goes away with the mesh
+    Arena arena;
+    meshes_[i].UseArena(&arena);
+
     KFbxXMatrix transform;
     GetPositions(meshes_[i], transform);
+    GetMaterials(meshes_[i]);
     GetNormalsUvs(meshes_[i], transform);
     //Generate the correct vertices for this thing.
     GenerateVertices(meshes_[i]);
     meshes_[i].verts_.swap(meshes_[i].ProcessedVertices);
     meshes_[i].indices_.swap(meshes_[i].ProcessedIndices);
-    GrabSkinWeights(meshes_[i]);
+    GetMorphTargets(meshes_[i], transform);
+    meshes_[i].ReleaseIntermediates();
+
+    //Until meshes are combined each one is a single range
+    SubMesh sub = {meshes_[i].name_, 0, meshes_[i].verts_.size(), 0, meshes_[i].indices_.size()};
+    meshes_[i].subMeshes_.push_back(sub);
+    if(extractSkinData_)
+      GrabSkinWeights(meshes_[i]);
 
     //Flip the ys on the UV coordinates for DX
-    for(unsigned int j = 0; j < meshes_[i].verts_.size(); ++j)
-      meshes_[i].verts_[j].uv_[1] = 1.0f - meshes_[i].verts_[j].uv_[1];
+    std::vector<Float2>& uvs = meshes_[i].verts_.uv_;
+    for(unsigned int j = 0; j < uvs.size(); ++j)
+      uvs[j].y = 1.0f - uvs[j].y;
 
 
     //If we didn't get tangents or bitangents for the mesh, we should generate them.
@@ -442,7 +830,12 @@ void Scene::ProcessMeshes(void)
 }
 void Scene::GrabSkinWeights(FbxMesh& mesh)
 {
-  mesh.skin.PointWeights.resize( mesh.verts_.size() );
+  const JointWeight empty = {0, 0};
+  unsigned int pointCount = mesh.mesh_->GetControlPointsCount();
+  mesh.skin.PointWeights.assign(pointCount * MaxSkinWeights, empty);
+
+  //How many weights each control point has so far, the first MaxSkinWeights found are kept
+  std::vector<unsigned char> found(pointCount, 0);
 
   //Now grab skin weights
   int skinCount = mesh.mesh_->GetDeformerCount(KFbxDeformer::eSKIN);
@@ -459,15 +852,6 @@ void Scene::GrabSkinWeights(FbxMesh& mesh)
       if(!link)
         continue;
 
-      //Find that link in the pose, or add the link if it's not present.
-      int nodeIndex = pose_->Find(link);
-      if(nodeIndex == -1)
-      {
-        KFbxXMatrix linkMtx;
-        cluster->GetTransformLinkMatrix(linkMtx);
-        pose_->Add(link, KFbxMatrix(linkMtx));
-      }
-
       //Now grab the actual weights from the skin
       double *weights = cluster->GetControlPointWeights();
       int *ctrlPtIndices = cluster->GetControlPointIndices();
@@ -478,31 +862,52 @@ void Scene::GrabSkinWeights(FbxMesh& mesh)
       {
         //Grab the current vertex index
         int vertIndex = ctrlPtIndices[l];
+        if(vertIndex < 0 || static_cast<unsigned int>(vertIndex) >= pointCount || found[vertIndex] >= MaxSkinWeights)
+          continue;
 
         //Grab its weight and assign it to our temporary vertex buffer.
         float weight = static_cast<float>(weights[l]);
 
         JointWeight jw = {weight, boneIndex};
-        mesh.skin.PointWeights[vertIndex].push_back(jw);
+        mesh.skin.Weights(vertIndex)[found[vertIndex]++] = jw;
       }
     }
   }
 
   //Normalize the skin weights for 4 weights for vertex that sum to one
-  for(unsigned int j = 0; j < mesh.skin.PointWeights.size(); ++j)
+  for(unsigned int j = 0; j < pointCount; ++j)
   {
-    //Make sure there is MaxWeights by inserting dummies
-    while(mesh.skin.PointWeights[j].size() < maxWeights_)
-    {						
-      JointWeight jw = {0,0};
-      mesh.skin.PointWeights[j].push_back(jw);
-    }
-    //Normalize the weights
+    //Normalize the weights, points no cluster touches stay all zero
+    JointWeight *pointWeights = mesh.skin.Weights(j);
     float sum = 0.0f;
     for(unsigned int w = 0; w < maxWeights_; ++w)
-      sum += mesh.skin.PointWeights[j][w].weight;
+      sum += pointWeights[w].weight;
+    if(sum <= 0.0f)
+      continue;
     for(unsigned int w = 0; w < maxWeights_; ++w)
-      mesh.skin.PointWeights[j][w].weight /= sum;
+      pointWeights[w].weight /= sum;
+  }
+}
+void Scene::FillBindPose(void)
+{
+  //Every skin in the file, the meshes may not be collected (animation only export)
+  int skinCount = scene_->GetSrcObjectCount(FBX_TYPE(KFbxSkin));
+  for(int i = 0; i < skinCount; ++i)
+  {
+    KFbxSkin *skin = scene_->GetSrcObject(FBX_TYPE(KFbxSkin), i);
+    int clusterCount = skin->GetClusterCount();
+    for(int k = 0; k < clusterCount; ++k)
+    {
+      //Links the pose leaves out are bound where the cluster says
+      KFbxCluster *cluster = skin->GetCluster(k);
+      KFbxNode *link = cluster->GetLink();
+      if(!link || pose_->Find(link) != -1)
+        continue;
+
+      KFbxXMatrix linkMtx;
+      cluster->GetTransformLinkMatrix(linkMtx);
+      pose_->Add(link, KFbxMatrix(linkMtx));
+    }
   }
 }
 void Scene::GetNormalsUvs(FbxMesh& inmesh, KFbxXMatrix& transform)
@@ -518,13 +923,7 @@ void Scene::GetNormalsUvs(FbxMesh& inmesh, KFbxXMatrix& transform)
   KFbxLayerElementNormal *normLayer = layer->GetNormals();
   if(normLayer)
   {
-    ConvertToStl(inmesh.norms, &normLayer->GetDirectArray() );
-
-    for(unsigned int n = 0; n < inmesh.norms.size(); ++n)
-    {
-      inmesh.norms[n] = Transform( transform , inmesh.norms[n] );
-      inmesh.norms[n].Normalize();
-    }
+    ConvertDirections(inmesh.norms, &normLayer->GetDirectArray(), transform);
 
     KFbxLayerElement::EReferenceMode refMode = normLayer->GetReferenceMode();
 
@@ -537,7 +936,7 @@ void Scene::GetNormalsUvs(FbxMesh& inmesh, KFbxXMatrix& transform)
       //If there is a uv layer.
       if(uvlayer)
       {
-        ConvertToStl( inmesh.uvs , &uvlayer->GetDirectArray() );
+        ConvertUvs( inmesh.uvs , &uvlayer->GetDirectArray() );
         KFbxLayerElement::EMappingMode Mapping = uvlayer->GetMappingMode();
         if( uvlayer->GetReferenceMode() == KFbxLayerElement::eINDEX_TO_DIRECT )
           ConvertToStl( inmesh.uvInd , &uvlayer->GetIndexArray() );
@@ -553,7 +952,7 @@ void Scene::GetNormalsUvs(FbxMesh& inmesh, KFbxXMatrix& transform)
         inmesh.nInd = inmesh.posInd;
         if(uvlayer)
         {
-          ConvertToStl( inmesh.uvs , &uvlayer->GetDirectArray() );
+          ConvertUvs( inmesh.uvs , &uvlayer->GetDirectArray() );
           KFbxLayerElement::EMappingMode Mapping = uvlayer->GetMappingMode();
           if(uvlayer->GetReferenceMode() == KFbxLayerElement::eINDEX_TO_DIRECT)
             ConvertToStl( inmesh.uvInd , &uvlayer->GetIndexArray() );
@@ -566,7 +965,7 @@ void Scene::GetNormalsUvs(FbxMesh& inmesh, KFbxXMatrix& transform)
         FillStl(inmesh.nInd, vertexCount);
         if(uvlayer)
         {
-          ConvertToStl( inmesh.uvs , &uvlayer->GetDirectArray() );
+          ConvertUvs( inmesh.uvs , &uvlayer->GetDirectArray() );
           KFbxLayerElement::EMappingMode Mapping = uvlayer->GetMappingMode();
           if(uvlayer->GetReferenceMode() == KFbxLayerElement::eINDEX_TO_DIRECT)
             ConvertToStl( inmesh.uvInd , &uvlayer->GetIndexArray());
@@ -580,13 +979,7 @@ void Scene::GetNormalsUvs(FbxMesh& inmesh, KFbxXMatrix& transform)
   KFbxLayerElementTangent *tanLayer = layer->GetTangents();
   if(tanLayer)
   {
-    ConvertToStl(inmesh.tans, &tanLayer->GetDirectArray());
-
-    for(unsigned int t = 0; t < inmesh.tans.size(); ++t)
-    {
-      inmesh.tans[t] = Transform( transform , inmesh.tans[t] );
-      inmesh.tans[t].Normalize();
-    }
+    ConvertDirections(inmesh.tans, &tanLayer->GetDirectArray(), transform);
 
     KFbxLayerElement::EReferenceMode refMode = tanLayer->GetReferenceMode();
 
@@ -614,13 +1007,7 @@ void Scene::GetNormalsUvs(FbxMesh& inmesh, KFbxXMatrix& transform)
   KFbxLayerElementBinormal *binLayer = layer->GetBinormals();
   if(binLayer)
   {
-    ConvertToStl(inmesh.bitans, &binLayer->GetDirectArray());
-
-    for(unsigned int b = 0; b < inmesh.bitans.size(); ++b)
-    {
-      inmesh.bitans[b] = Transform( transform , inmesh.bitans[b]);
-      inmesh.bitans[b].Normalize();
-    }
+    ConvertDirections(inmesh.bitans, &binLayer->GetDirectArray(), transform);
 
     KFbxLayerElement::EReferenceMode refMode = binLayer->GetReferenceMode();
 
@@ -650,20 +1037,42 @@ void Scene::ConvertTriWinding(FbxMesh& mesh)
 }
 void Scene::Triangulate(FbxMesh& mesh)
 {
-  std::vector<int> NewIndices;
+  //Simple Convex Polygon Triangulation: always n-2 tris. They are counted up
+  //front per material so each material's triangles land in one range.
+  std::vector<unsigned int> materialNext(materials_.size(), 0);
+  for(unsigned int i = 0; i  < mesh.polySizeArray.size(); ++i)
+    if(mesh.polySizeArray[i] > 2)
+      materialNext[mesh.polyMaterials[i]] += mesh.polySizeArray[i] - 2;
+
+  unsigned int triCount = 0;
+  mesh.materialRanges_.clear();
+  for(unsigned int m = 0; m < materialNext.size(); ++m)
+  {
+    unsigned int count = materialNext[m];
+    if(count)
+    {
+      MaterialRange range = {m, triCount * 3, count * 3};
+      mesh.materialRanges_.push_back(range);
+    }
+    materialNext[m] = triCount;
+    triCount += count;
+  }
+
+  std::vector<int> NewIndices(triCount * 3);
   int c = 0;
    
   for(unsigned int i = 0; i  < mesh.polySizeArray.size(); ++i)
   {
     int size = mesh.polySizeArray[i];		
-    //Simple Convex Polygon Triangulation: always n-2 tris
     const int NumberOfTris = size - 2;
+    unsigned int& next = materialNext[mesh.polyMaterials[i]];
 
     for(int p = 0; p < NumberOfTris; ++p)
     {
-      NewIndices.push_back(mesh.ProcessedIndices[c+0]);
-      NewIndices.push_back(mesh.ProcessedIndices[c+1+p]);
-      NewIndices.push_back(mesh.ProcessedIndices[c+2+p]);
+      int *tri = &NewIndices[next++ * 3];
+      tri[0] = mesh.ProcessedIndices[c+0];
+      tri[1] = mesh.ProcessedIndices[c+1+p];
+      tri[2] = mesh.ProcessedIndices[c+2+p];
     }	
     c += size;
   }
@@ -673,23 +1082,29 @@ void Scene::Triangulate(FbxMesh& mesh)
 }
 int Scene::AddNewVertex(IndexedVert v, FbxMesh& mesh)
 {
-  FbxVert nv;
-  nv.nrm_ = mesh.norms[v.normIndex];
-  nv.pos_ = mesh.positions[v.posIndex];
-  nv.uv_ = mesh.uvs[v.uvIndex];
+  VertexStreams& verts = mesh.ProcessedVertices;
+  verts.pos_.push_back(mesh.positions[v.posIndex]);
+  verts.nrm_.push_back(mesh.norms[v.normIndex]);
+  verts.uv_.push_back(mesh.uvs[v.uvIndex]);
 
   if(tans_ && bitans_)
   {
-    nv.tan_ = mesh.tans[v.tanIndex];
-    nv.bitan_ = mesh.bitans[v.bitanIndex];
+    verts.tan_.push_back(mesh.tans[v.tanIndex]);
+    verts.bitan_.push_back(mesh.bitans[v.bitanIndex]);
+  }
+  else
+  {
+    //Filled in by CalculateTansAndBitans once the triangles are known
+    const Float3 zero = {0, 0, 0};
+    verts.tan_.push_back(zero);
+    verts.bitan_.push_back(zero);
   }
 
-  mesh.ProcessedVertices.push_back(nv);
   mesh.source.push_back(v);
 
   return mesh.ProcessedVertices.size() - 1;
 }
-bool Scene::IsMatchingVertex(FbxVert& vertex, IndexedVert& cur, IndexedVert& v)
+bool Scene::IsMatchingVertex(IndexedVert& cur, IndexedVert& v)
 {
   //Need to check to see if the normals and uvs match if not generate a new vertex
   if(v.normIndex != cur.normIndex)
@@ -702,16 +1117,17 @@ bool Scene::IsMatchingVertex(FbxVert& vertex, IndexedVert& cur, IndexedVert& v)
 }
 int Scene::FindMatchingVertex(IndexedVert& v, FbxMesh& mesh)
 {
-  std::vector<int>& mappedVertices = mesh.mappedVerts[v.posIndex];
-  for(unsigned int i = 0; i < mappedVertices.size(); ++i)
+  int& first = mesh.firstMapped[v.posIndex];
+  for(int i = first; i >= 0; i = mesh.nextMapped[i])
   {
-    if(IsMatchingVertex(mesh.ProcessedVertices[mappedVertices[i]], mesh.source[mappedVertices[i]], v))
-      return mappedVertices[i];
+    if(IsMatchingVertex(mesh.source[i], v))
+      return i;
   }
 
-  //No matching vertices mapped for this index, just add one
+  //No matching vertices mapped for this index, just add one to the front of the chain
   int newIndex = AddNewVertex(v, mesh);
-  mappedVertices.push_back(newIndex);
+  mesh.nextMapped.push_back(first);
+  first = newIndex;
   
   return newIndex;
 }
@@ -723,10 +1139,15 @@ void Scene::GenerateVertices(FbxMesh& mesh)
     //Fill UvIndices with zeros
     mesh.uvInd.resize( mesh.posInd.size());
     //Put in a dummy UV
-    mesh.uvs.push_back( KFbxVector2(0,0));
+    mesh.uvs.push_back( MakeFloat2(0,0));
   }
-  //Create a vertex and an index buffer
-  mesh.mappedVerts.resize(mesh.posInd.size());
+  //Create a vertex and an index buffer, a control point makes at least one vertex
+  unsigned int ctrlPtCount = mesh.positions.size();
+  mesh.firstMapped.assign(ctrlPtCount, -1);
+  mesh.nextMapped.reserve(mesh.posInd.size());
+  mesh.ProcessedVertices.reserve(ctrlPtCount);
+  mesh.source.reserve(ctrlPtCount);
+  mesh.ProcessedIndices.reserve(mesh.posInd.size());
   printf("%d\n", mesh.posInd.size());
   printf("%d\n", mesh.tInd.size());
   printf("%d\n", mesh.bInd.size());
@@ -829,6 +1250,7 @@ void Scene::GetPositions(FbxMesh& inmesh, KFbxXMatrix& trans)
   inmesh.transformMtx_ = transformMatrix;
 
   KFbxMesh *mesh = inmesh.mesh_;
+  KFbxNode *node = inmesh.node_;
 
   int polyCount = mesh->GetPolygonCount();
 
@@ -839,21 +1261,41 @@ void Scene::GetPositions(FbxMesh& inmesh, KFbxXMatrix& trans)
   inmesh.posInd.resize(vertexCount);
   memcpy(&inmesh.posInd[0], indices, sizeof(int) * vertexCount);
 
+  inmesh.polySizeArray.resize(polyCount);
   for(int p = 0; p < polyCount; ++p)
-    inmesh.polySizeArray.push_back(mesh->GetPolygonSize(p));
+    inmesh.polySizeArray[p] = mesh->GetPolygonSize(p);
 
   //Grab the control points, triangle count, and use them to get the vertex positions.
   int ctrlPtCount = mesh->GetControlPointsCount();
   KFbxVector4 *ctrlPts = mesh->GetControlPoints();
   int tris = polyCount;
 
-  //Grab the normal matrix of each mesh and the "world positions" of each vertex
-  KFbxNode *node = mesh->GetNode();
+  //Instanced meshes stay in their own space, the node transform goes in the instance table
+  if(options_.instanceMeshes_)
+    trans.SetIdentity();
+  else
+  {
+    //Grab the normal matrix of each mesh and the "world positions" of each vertex
+    KFbxXMatrix mtw = GetNodeWorldMatrix(node);
+
+    //create the transform by appending the world to the local transform
+    trans = mtw * GetGeometricMatrix(node);
+  }
+
+  //Converter to DX space
+  mtxConverter_->ConvertMeshMatrix(trans);
+
+  inmesh.positions.resize(ctrlPtCount);
+  for(int cp = 0; cp < ctrlPtCount; ++cp)
+    inmesh.positions[cp] = ToFloat3(Transform(trans, ctrlPts[cp]));
+}
+KFbxXMatrix Scene::GetNodeWorldMatrix(KFbxNode *node)
+{
   KFbxXMatrix mtw;
 
   if(pose_)
   {
-    int nodeIndex = pose_->Find(mesh->GetNode());
+    int nodeIndex = pose_->Find(node);
     KFbxMatrix mtx = pose_->GetMatrix(nodeIndex);
     mtw = *(reinterpret_cast<KFbxXMatrix*>(&mtx));
 
@@ -870,74 +1312,2231 @@ void Scene::GetPositions(FbxMesh& inmesh, KFbxXMatrix& trans)
   else 
     mtw = node->GetScene()->GetEvaluator()->GetNodeGlobalTransform(node);
 
+  return mtw;
+}
+KFbxXMatrix Scene::GetGeometricMatrix(KFbxNode *node)
+{
   //Create an offset matrix that is the local transform
   KFbxVector4 t = node->GetGeometricTranslation(KFbxNode::eSOURCE_SET);
   KFbxVector4 r = node->GetGeometricRotation(KFbxNode::eSOURCE_SET);
   KFbxVector4 s = node->GetGeometricScaling(KFbxNode::eSOURCE_SET);
 
-  KFbxXMatrix geoTransform (t,r,s);
-
-  //create the transform by appending the world to the local transform
-  trans = mtw * geoTransform;
-
-  //Converter to DX space
-  mtxConverter_->ConvertMeshMatrix(trans);
-
-  inmesh.positions.resize(ctrlPtCount);
-  for(int cp = 0; cp < ctrlPtCount; ++cp)
-    inmesh.positions[cp] = Transform(trans, ctrlPts[cp]);
+  return KFbxXMatrix(t,r,s);
 }
-void Scene::CombineMeshes(void)
+int Scene::FindMesh(KFbxMesh *mesh)
 {
-  printf("Combining meshes\n");
-  printf("%d", meshes_.size());
-  
-  for(unsigned int i = 1; i < meshes_.size(); ++i)
-    meshes_[0].CombineInto( meshes_[i] );
+  //Return the index of the first collected copy of the mesh or -1
+  for(unsigned i = 0; i < meshes_.size(); ++i)
+    if(meshes_[i].mesh_ == mesh)
+      return i;
+  return -1;
 }
-KFbxVector4 Scene::Transform(const KFbxXMatrix& pXMatrix, const KFbxVector4& point)
+void Scene::AddInstance(unsigned int meshIndex, KFbxNode *node)
 {
-  KFbxMatrix * m = (KFbxMatrix*)&pXMatrix;
-  return m->MultNormalize( point );
+  //Instanced vertices are only converted to DX space so the whole node
+  //transform, geometric offset included, goes into the instance
+  KFbxXMatrix world = GetNodeWorldMatrix(node) * GetGeometricMatrix(node);
+  mtxConverter_->ConvertMatrix(world);
+
+  MeshInstance instance;
+  instance.mesh_ = meshIndex;
+  instance.node_ = node;
+  instance.name_ = node->GetName();
+  instance.transform_ = *(reinterpret_cast<KFbxMatrix*>(&world));
+  instances_.push_back(instance);
 }
-void Scene::CollectBones(KFbxNode* pRootNode)
+static unsigned long long HashMesh(const FbxMesh& mesh)
 {
-    printf("Collecting Bones from the scene...\n");
+  unsigned long long hash = HashVector(mesh.verts_.pos_);
+  hash = HashVector(mesh.verts_.nrm_, hash);
+  hash = HashVector(mesh.verts_.uv_, hash);
+  hash = HashVector(mesh.verts_.tan_, hash);
+  hash = HashVector(mesh.verts_.bitan_, hash);
+  return HashVector(mesh.indices_, hash);
+}
+template<typename type>
+static bool SameContents(const std::vector<type>& a, const std::vector<type>& b)
+{
+  return a.size() == b.size() && (a.empty() || !memcmp(&a[0], &b[0], sizeof(type) * a.size()));
+}
+static bool SameGeometry(const FbxMesh& a, const FbxMesh& b)
+{
+  //Blend shapes can move identical meshes apart
+  if(!a.morphs_.empty() || !b.morphs_.empty())
+    return false;
 
-    //Get the queue of bones set up
-    int bIndex = -1;
-    std::queue<FbxParent> boneQ;
-    boneQ.push(FbxParent(bIndex, pRootNode));
+  return SameContents(a.verts_.pos_, b.verts_.pos_) && SameContents(a.verts_.nrm_, b.verts_.nrm_) &&
+         SameContents(a.verts_.uv_, b.verts_.uv_) && SameContents(a.verts_.tan_, b.verts_.tan_) &&
+         SameContents(a.verts_.bitan_, b.verts_.bitan_) && SameContents(a.indices_, b.indices_) &&
+         SameContents(a.materialRanges_, b.materialRanges_);
+}
+void Scene::DeduplicateMeshes(void)
+{
+  printf("Looking for duplicate meshes.\n");
 
-    //Extract relevant data from each bone into our structures
-    //Then get its children into the queue
-    while(!boneQ.empty())
-    {
-      //Grab the top bone
-      FbxParent curNode = boneQ.front();
-      boneQ.pop();
+  //Meshes that share a KFbxMesh were already folded together when collected,
+  //this catches separate meshes whose processed geometry is identical
+  std::vector<unsigned long long> hashes(meshes_.size());
+  for(unsigned int i = 0; i < meshes_.size(); ++i)
+    hashes[i] = HashMesh(meshes_[i]);
 
-      //Get the attributes off the node if it's valid
-      if(GetNodeAttributeType(curNode.node_) == KFbxNodeAttribute::eSKELETON)
+  std::vector<unsigned int> remap(meshes_.size());
+  std::vector<unsigned int> kept;
+  for(unsigned int i = 0; i < meshes_.size(); ++i)
+  {
+    remap[i] = kept.size();
+    for(unsigned int k = 0; k < kept.size(); ++k)
+    {
+      unsigned int other = kept[k];
+      if(hashes[other] == hashes[i] && SameGeometry(meshes_[other], meshes_[i]))
       {
-        //Fill in a bone and add it to our list of bones
-        FbxBone bone;
-        bone.bone_ = curNode.node_->GetSkeleton();
-        bone.name_ = bone.bone_->GetName();
-        printf("Collecting bone: %s\n", bone.name_.c_str());
-        bone.pIndex_ = curNode.parent_;
-        bIndex = bones_.size();
-        bone.index_ = bIndex;
-        bones_.push_back(bone);
+        remap[i] = k;
+        break;
       }
-
-      //Push all the children bones onto the queue
-      int childCount =  curNode.node_->GetChildCount();
-      for(int i = 0; i < childCount; ++i)
-        boneQ.push(FbxParent(bIndex, curNode.node_->GetChild(i)));
     }
+    if(remap[i] == kept.size())
+      kept.push_back(i);
+  }
 
-    printf("Done...\n");
+  for(unsigned int i = 0; i < instances_.size(); ++i)
+    instances_[i].mesh_ = remap[instances_[i].mesh_];
+
+  //Drop the duplicates, back to front so the kept indices stay put
+  for(unsigned int i = meshes_.size(); i-- > 0; )
+    if(kept[remap[i]] != i)
+      meshes_.erase(meshes_.begin() + i);
+
+  printf("%d instances of %d unique meshes.\n", instances_.size(), meshes_.size());
+}
+void Scene::WriteInstances(void)
+{
+  if(instances_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionInstances);
+  unsigned int instanceCount = instances_.size();
+  BufferWrite(&instanceCount, sizeof(unsigned int), 1, fp_);
+  for(unsigned int i = 0; i < instanceCount; ++i)
+  {
+    BufferWrite(&instances_[i].mesh_, sizeof(unsigned int), 1, fp_);
+    WriteDoubleToFloat(fp_, reinterpret_cast<double*>(&instances_[i].transform_), 16);
+
+    unsigned int strsize = instances_[i].name_.size();
+    BufferWrite(&strsize, sizeof(unsigned int), 1, fp_);
+    BufferWrite(instances_[i].name_.c_str(), strsize, 1, fp_);
+  }
+  EndSection(fp_, section);
+}
+struct GridKey
+{
+  int x, y, z;
+
+  bool operator<(const GridKey& rhs) const
+  {
+    if(x != rhs.x) return x < rhs.x;
+    if(y != rhs.y) return y < rhs.y;
+    return z < rhs.z;
+  }
+};
+void Scene::PartitionScene(void)
+{
+  float cellSize = options_.gridCellSize_;
+  if(meshes_.empty() || cellSize <= 0.0f)
+    return;
+
+  if(type_ == Skinned || options_.instanceMeshes_)
+  {
+    printf("Grid partitioning needs a static scene with baked transforms, skipping it.\n");
+    return;
+  }
+
+  printf("Partitioning the scene into %f unit cells.\n", cellSize);
+  FbxMesh& mesh = meshes_[0];
+  VertexStreams& verts = mesh.verts_;
+
+  //Every sub mesh and material piece of the indices, with its sub mesh and material range
+  std::vector<unsigned int> cuts;
+  IndexCuts(mesh, cuts);
+  unsigned int pieceCount = cuts.empty() ? 0 : cuts.size() - 1;
+  std::vector<int> pieceSubs(pieceCount, -1), pieceRanges(pieceCount, -1);
+  for(unsigned int c = 0; c < pieceCount; ++c)
+  {
+    for(unsigned int s = 0; s < mesh.subMeshes_.size(); ++s)
+      if(cuts[c] >= mesh.subMeshes_[s].indexStart_ && cuts[c + 1] <= mesh.subMeshes_[s].indexStart_ + mesh.subMeshes_[s].indexCount_)
+        pieceSubs[c] = s;
+    for(unsigned int r = 0; r < mesh.materialRanges_.size(); ++r)
+      if(cuts[c] >= mesh.materialRanges_[r].indexStart_ && cuts[c + 1] <= mesh.materialRanges_[r].indexStart_ + mesh.materialRanges_[r].indexCount_)
+        pieceRanges[c] = r;
+  }
+
+  //Triangles go whole into the cell holding their centroid. Walking the pieces
+  //in order keeps each cell's triangles grouped by sub mesh, then material.
+  std::map<GridKey, unsigned int> lookup;
+  std::vector<std::vector<unsigned int> > cellTris;
+  std::vector<std::vector<unsigned int> > cellPieces;
+
+  for(unsigned int p = 0; p < pieceCount; ++p)
+  {
+    if(pieceSubs[p] < 0)
+      continue;
+    for(unsigned int i = cuts[p]; i < cuts[p + 1]; i += 3)
+    {
+      Float3 centroid = (verts.pos_[mesh.indices_[i]] + verts.pos_[mesh.indices_[i + 1]] + verts.pos_[mesh.indices_[i + 2]]) * (1.0f / 3.0f);
+      GridKey key = {static_cast<int>(floor(centroid.x / cellSize)),
+                     static_cast<int>(floor(centroid.y / cellSize)),
+                     static_cast<int>(floor(centroid.z / cellSize))};
+
+      std::map<GridKey, unsigned int>::iterator it = lookup.find(key);
+      if(it == lookup.end())
+      {
+        it = lookup.insert(std::make_pair(key, static_cast<unsigned int>(cells_.size()))).first;
+        cells_.push_back(GridCell());
+        cells_.back().x_ = key.x;
+        cells_.back().y_ = key.y;
+        cells_.back().z_ = key.z;
+        cellTris.push_back(std::vector<unsigned int>());
+        cellPieces.push_back(std::vector<unsigned int>());
+      }
+
+      cellTris[it->second].push_back(i);
+      cellPieces[it->second].push_back(p);
+    }
+  }
+
+  //Give every cell its own compact vertex buffer
+  std::vector<int> remap(verts.size(), -1);
+  for(unsigned int c = 0; c < cells_.size(); ++c)
+  {
+    GridCell& cell = cells_[c];
+    std::vector<unsigned int>& tris = cellTris[c];
+
+    for(unsigned int t = 0; t < tris.size(); ++t)
+    {
+      //Sub meshes don't share vertices so each one's vertices come out contiguous
+      unsigned int p = cellPieces[c][t];
+      int s = pieceSubs[p];
+      if(t == 0 || pieceSubs[cellPieces[c][t - 1]] != s)
+      {
+        SubMesh sub = {mesh.subMeshes_[s].name_, cell.verts_.size(), 0, cell.indices_.size(), 0};
+        cell.subMeshes_.push_back(sub);
+      }
+      int r = pieceRanges[p];
+      if(r >= 0 && (t == 0 || pieceRanges[cellPieces[c][t - 1]] != r))
+      {
+        MaterialRange range = {mesh.materialRanges_[r].material_, cell.indices_.size(), 0};
+        cell.materialRanges_.push_back(range);
+      }
+
+      for(unsigned int k = 0; k < 3; ++k)
+      {
+        int v = mesh.indices_[tris[t] + k];
+        if(remap[v] < 0)
+        {
+          remap[v] = cell.verts_.size();
+          cell.verts_.AppendVertex(verts, v);
+        }
+        cell.indices_.push_back(remap[v]);
+      }
+
+      SubMesh& current = cell.subMeshes_.back();
+      current.vertCount_ = cell.verts_.size() - current.vertStart_;
+      current.indexCount_ = cell.indices_.size() - current.indexStart_;
+      if(r >= 0)
+        cell.materialRanges_.back().indexCount_ = cell.indices_.size() - cell.materialRanges_.back().indexStart_;
+    }
+
+    for(unsigned int t = 0; t < tris.size(); ++t)
+      for(unsigned int k = 0; k < 3; ++k)
+        remap[mesh.indices_[tris[t] + k]] = -1;
+
+    const Float3* points = &cell.verts_.pos_[0];
+    cell.bounds_ = ComputeAabb(points, cell.verts_.size());
+    cell.sphere_ = ComputeSphere(points, cell.verts_.size());
+    for(unsigned int s = 0; s < cell.subMeshes_.size(); ++s)
+    {
+      SubMesh& sub = cell.subMeshes_[s];
+      sub.bounds_ = ComputeAabb(points + sub.vertStart_, sub.vertCount_);
+      sub.sphere_ = ComputeSphere(points + sub.vertStart_, sub.vertCount_);
+    }
+  }
+
+  printf("Scene split into %d cells.\n", cells_.size());
+}
+void Scene::SaveCells(void)
+{
+  if(cells_.empty())
+    return;
+
+  std::string base = output_.substr(0, output_.find_last_of("."));
+  OutputFile *grid = AddOutput(base + ".grid");
+
+  unsigned int cellCount = cells_.size();
+  BufferWrite(&options_.gridCellSize_, sizeof(float), 1, grid);
+  BufferWrite(&cellCount, sizeof(unsigned int), 1, grid);
+
+  for(unsigned int c = 0; c < cellCount; ++c)
+  {
+    GridCell& cell = cells_[c];
+
+    char suffix[64];
+    sprintf(suffix, "_cell_%d_%d_%d.gmf", cell.x_, cell.y_, cell.z_);
+    std::string cellName = base + suffix;
+
+    OutputFile *fp = AddOutput(cellName);
+
+    //Cells are plain static meshes with bounds
+    unsigned int type = Static;
+    unsigned int vertCount = cell.verts_.size();
+    unsigned int indexCount = cell.indices_.size();
+    BufferWrite(&type, sizeof(unsigned int), 1, fp);
+    BufferWrite(&vertCount, sizeof(unsigned int), 1, fp);
+    BufferWrite(&indexCount, sizeof(unsigned int), 1, fp);
+    for(unsigned int i = 0; i < vertCount; ++i)
+      WriteVertex(fp, cell.verts_, i);
+    BufferWrite(&cell.indices_[0], sizeof(int) * indexCount, 1, fp);
+    WriteMeshBounds(fp, cell.bounds_, cell.sphere_, cell.subMeshes_);
+    if(!materials_.empty())
+      WriteMaterialSection(fp, materials_, cell.materialRanges_);
+
+    //Index entry, with the file name relative to the grid file
+    std::string relative = cellName.substr(cellName.find_last_of("/\\") + 1);
+    unsigned int strsize = relative.size();
+    BufferWrite(&cell.x_, sizeof(int), 1, grid);
+    BufferWrite(&cell.y_, sizeof(int), 1, grid);
+    BufferWrite(&cell.z_, sizeof(int), 1, grid);
+    BufferWrite(&cell.bounds_, sizeof(Aabb), 1, grid);
+    BufferWrite(&cell.sphere_, sizeof(BoundingSphere), 1, grid);
+    BufferWrite(&vertCount, sizeof(unsigned int), 1, grid);
+    BufferWrite(&indexCount, sizeof(unsigned int), 1, grid);
+    BufferWrite(&strsize, sizeof(unsigned int), 1, grid);
+    BufferWrite(relative.c_str(), strsize, 1, grid);
+  }
+}
+void Scene::GetMorphTargets(FbxMesh& mesh, KFbxXMatrix& transform)
+{
+  int blendShapeCount = mesh.mesh_->GetDeformerCount(KFbxDeformer::eBLENDSHAPE);
+  if(!blendShapeCount)
+    return;
+
+  printf("Collecting blend shapes for %s.\n", mesh.name_.c_str());
+
+  //transform has had its translation cleared by GetNormalsUvs, which is all a delta needs
+  KFbxVector4 *basePts = mesh.mesh_->GetControlPoints();
+  int ctrlPtCount = mesh.mesh_->GetControlPointsCount();
+
+  for(int b = 0; b < blendShapeCount; ++b)
+  {
+    KFbxBlendShape *blendShape = reinterpret_cast<KFbxBlendShape*>(mesh.mesh_->GetDeformer(b, KFbxDeformer::eBLENDSHAPE));
+    int channelCount = blendShape->GetBlendShapeChannelCount();
+    for(int c = 0; c < channelCount; ++c)
+    {
+      KFbxBlendShapeChannel *channel = blendShape->GetBlendShapeChannel(c);
+      double *fullWeights = channel->GetTargetShapeFullWeights();
+
+      //In between targets are kept as their own target at their full weight
+      int targetCount = channel->GetTargetShapeCount();
+      for(int t = 0; t < targetCount; ++t)
+      {
+        KFbxShape *shape = channel->GetTargetShape(t);
+        if(!shape || shape->GetControlPointsCount() != ctrlPtCount)
+          continue;
+
+        KFbxVector4 *shapePts = shape->GetControlPoints();
+
+        //Normals can only be compared when they are laid out like the base mesh's
+        ArenaVector<Float3> shapeNorms;
+        KFbxLayer *layer = shape->GetLayer(0);
+        if(layer && layer->GetNormals())
+          ConvertDirections(shapeNorms, &layer->GetNormals()->GetDirectArray(), transform);
+        bool hasNormals = !shapeNorms.empty() && shapeNorms.size() == mesh.norms.size();
+
+        MorphTarget target;
+        target.name_ = channel->GetName();
+        target.fullWeight_ = fullWeights ? static_cast<float>(fullWeights[t]) : 100.0f;
+
+        //Map the control point offsets through the welded vertices
+        for(unsigned int v = 0; v < mesh.source.size(); ++v)
+        {
+          const IndexedVert& src = mesh.source[v];
+          Float3 posDelta = ToFloat3(Transform(transform, shapePts[src.posIndex])) - ToFloat3(Transform(transform, basePts[src.posIndex]));
+          Float3 nrmDelta = hasNormals ? shapeNorms[src.normIndex] - mesh.norms[src.normIndex] : MakeFloat3(0, 0, 0);
+
+          if(Length(posDelta) <= MorphEpsilon && Length(nrmDelta) <= MorphEpsilon)
+            continue;
+
+          target.verts_.push_back(v);
+          target.posDeltas_.push_back(posDelta);
+          target.nrmDeltas_.push_back(nrmDelta);
+        }
+
+        printf("Blend shape %s moves %d of %d vertices.\n", target.name_.c_str(), target.verts_.size(), mesh.source.size());
+        mesh.morphs_.push_back(target);
+      }
+    }
+  }
+}
+void Scene::CollectMorphCurves(FbxAnimation& anim, const char *takeName)
+{
+  KFbxAnimStack *animStack = scene_->FindMember(FBX_TYPE(KFbxAnimStack), takeName);
+  if(!animStack)
+    return;
+  KFbxAnimLayer *animLayer = animStack->GetMember(FBX_TYPE(KFbxAnimLayer), 0);
+
+  for(unsigned int m = 0; m < meshes_.size(); ++m)
+  {
+    KFbxMesh *mesh = meshes_[m].mesh_;
+    int blendShapeCount = mesh->GetDeformerCount(KFbxDeformer::eBLENDSHAPE);
+    for(int b = 0; b < blendShapeCount; ++b)
+    {
+      KFbxBlendShape *blendShape = reinterpret_cast<KFbxBlendShape*>(mesh->GetDeformer(b, KFbxDeformer::eBLENDSHAPE));
+      int channelCount = blendShape->GetBlendShapeChannelCount();
+      for(int c = 0; c < channelCount; ++c)
+      {
+        KFbxAnimCurve *curve = mesh->GetShapeChannel(b, c, animLayer);
+        if(!curve)
+          continue;
+
+        //Channels split across meshes are driven by one curve
+        std::string name = blendShape->GetBlendShapeChannel(c)->GetName();
+        bool found = false;
+        for(unsigned int i = 0; i < anim.morphCurves_.size() && !found; ++i)
+          found = anim.morphCurves_[i].name_ == name;
+        if(found)
+          continue;
+
+        MorphCurve morphCurve;
+        morphCurve.name_ = name;
+        int keyCount = curve->KeyGetCount();
+        for(int k = 0; k < keyCount; ++k)
+        {
+          KFbxAnimCurveKey key = curve->KeyGet(k);
+          morphCurve.times_.push_back(static_cast<float>((key.GetTime() - anim.start_).GetSecondDouble()));
+          morphCurve.weights_.push_back(key.GetValue());
+        }
+        anim.morphCurves_.push_back(morphCurve);
+      }
+    }
+  }
+}
+//Scale that maps the largest component of the deltas onto a short
+static float MorphScale(const std::vector<Float3>& deltas)
+{
+  float largest = 0.0f;
+  for(unsigned int i = 0; i < deltas.size(); ++i)
+    for(int k = 0; k < 3; ++k)
+      largest = std::max(largest, std::fabs(deltas[i][k]));
+  return largest > 0.0f ? largest / 32767.0f : 1.0f;
+}
+static void WriteQuantizedDeltas(OutputFile *fp, const std::vector<Float3>& deltas, float scale)
+{
+  for(unsigned int i = 0; i < deltas.size(); ++i)
+  {
+    short quantized[3];
+    for(int k = 0; k < 3; ++k)
+      quantized[k] = static_cast<short>(floor(deltas[i][k] / scale + 0.5f));
+    BufferWrite(quantized, sizeof(quantized), 1, fp);
+  }
+}
+void Scene::WriteMorphs(FbxMesh& mesh)
+{
+  if(mesh.morphs_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionMorphs);
+  unsigned int targetCount = mesh.morphs_.size();
+  BufferWrite(&targetCount, sizeof(unsigned int), 1, fp_);
+  for(unsigned int i = 0; i < targetCount; ++i)
+  {
+    MorphTarget& target = mesh.morphs_[i];
+    unsigned int strsize = target.name_.size();
+    BufferWrite(&strsize, sizeof(unsigned int), 1, fp_);
+    BufferWrite(target.name_.c_str(), strsize, 1, fp_);
+    BufferWrite(&target.fullWeight_, sizeof(float), 1, fp_);
+
+    unsigned int vertCount = target.verts_.size();
+    float posScale = MorphScale(target.posDeltas_);
+    float nrmScale = MorphScale(target.nrmDeltas_);
+    BufferWrite(&vertCount, sizeof(unsigned int), 1, fp_);
+    BufferWrite(&posScale, sizeof(float), 1, fp_);
+    BufferWrite(&nrmScale, sizeof(float), 1, fp_);
+    if(vertCount)
+      BufferWrite(&target.verts_[0], sizeof(unsigned int) * vertCount, 1, fp_);
+    WriteQuantizedDeltas(fp_, target.posDeltas_, posScale);
+    WriteQuantizedDeltas(fp_, target.nrmDeltas_, nrmScale);
+  }
+  EndSection(fp_, section);
+
+  WriteMorphCurves(fp_, anims_.empty() ? NULL : &anims_[0], EmbeddedAnimCount());
+}
+//Index of the scene material for this FBX material, added the first time it is seen.
+//Polygons without a material share a plain grey one.
+int Scene::GetMaterial(KFbxSurfaceMaterial *material)
+{
+  for(unsigned int i = 0; i < materials_.size(); ++i)
+    if(materials_[i].source_ == material)
+      return i;
+
+  Material result;
+  result.source_ = material;
+  result.name_ = material ? material->GetName() : "default";
+  result.diffuse_ = MakeFloat3(0.8f, 0.8f, 0.8f);
+  result.specular_ = MakeFloat3(0, 0, 0);
+  result.emissive_ = MakeFloat3(0, 0, 0);
+  result.opacity_ = 1.0f;
+  result.shininess_ = 0.0f;
+
+  //Phong is a Lambert with highlights
+  KFbxSurfaceLambert *lambert = material ? KFbxCast<KFbxSurfaceLambert>(material) : NULL;
+  if(lambert)
+  {
+    fbxDouble3 diffuse = lambert->Diffuse.Get();
+    fbxDouble3 emissive = lambert->Emissive.Get();
+    float diffuseFactor = static_cast<float>(lambert->DiffuseFactor.Get());
+    float emissiveFactor = static_cast<float>(lambert->EmissiveFactor.Get());
+    result.diffuse_ = MakeFloat3(float(diffuse[0]), float(diffuse[1]), float(diffuse[2])) * diffuseFactor;
+    result.emissive_ = MakeFloat3(float(emissive[0]), float(emissive[1]), float(emissive[2])) * emissiveFactor;
+    result.opacity_ = 1.0f - static_cast<float>(lambert->TransparencyFactor.Get());
+  }
+
+  KFbxSurfacePhong *phong = material ? KFbxCast<KFbxSurfacePhong>(material) : NULL;
+  if(phong)
+  {
+    fbxDouble3 specular = phong->Specular.Get();
+    float specularFactor = static_cast<float>(phong->SpecularFactor.Get());
+    result.specular_ = MakeFloat3(float(specular[0]), float(specular[1]), float(specular[2])) * specularFactor;
+    result.shininess_ = static_cast<float>(phong->Shininess.Get());
+  }
+
+  if(material)
+  {
+    result.textures_[GmfTextureDiffuse] = FindTexture(material, KFbxSurfaceMaterial::sDiffuse);
+    result.textures_[GmfTextureNormal] = FindTexture(material, KFbxSurfaceMaterial::sNormalMap);
+    if(result.textures_[GmfTextureNormal].empty())
+      result.textures_[GmfTextureNormal] = FindTexture(material, KFbxSurfaceMaterial::sBump);
+    result.textures_[GmfTextureSpecular] = FindTexture(material, KFbxSurfaceMaterial::sSpecular);
+    result.textures_[GmfTextureEmissive] = FindTexture(material, KFbxSurfaceMaterial::sEmissive);
+  }
+
+  materials_.push_back(result);
+  return materials_.size() - 1;
+}
+static bool FileExists(const std::string& path)
+{
+  FILE *fp = fopen(path.c_str(), "rb");
+  if(fp)
+    fclose(fp);
+  return fp != NULL;
+}
+//The file of the first texture connected to a material property, empty if there is none
+std::string Scene::FindTexture(KFbxSurfaceMaterial *material, const char *property)
+{
+  KFbxProperty prop = material->FindProperty(property);
+  if(!prop.IsValid())
+    return "";
+
+  KFbxFileTexture *texture = prop.GetSrcObject(FBX_TYPE(KFbxFileTexture), 0);
+  if(!texture)
+    return "";
+
+  //Absolute paths are usually from the artist's machine, so also look relative to
+  //the FBX and then for the bare file name next to it
+  std::string absolute = texture->GetFileName();
+  std::string directory = filename_.substr(0, filename_.find_last_of("/\\") + 1);
+  std::string relative = directory + texture->GetRelativeFileName();
+  std::string local = directory + absolute.substr(absolute.find_last_of("/\\") + 1);
+
+  if(FileExists(absolute))
+    return absolute;
+  if(FileExists(relative))
+    return relative;
+  if(FileExists(local))
+    return local;
+
+  printf("Couldn't find texture %s\n", absolute.c_str());
+  return absolute;
+}
+void Scene::GetMaterials(FbxMesh& inmesh)
+{
+  KFbxMesh *mesh = inmesh.mesh_;
+  KFbxNode *node = inmesh.node_;
+  int polyCount = mesh->GetPolygonCount();
+
+  //The node owns the materials, the mesh only says which of the node's each polygon uses
+  std::vector<int> nodeMaterials(node->GetMaterialCount());
+  for(unsigned int i = 0; i < nodeMaterials.size(); ++i)
+    nodeMaterials[i] = GetMaterial(node->GetMaterial(i));
+
+  int fallback = nodeMaterials.empty() ? GetMaterial(NULL) : nodeMaterials[0];
+  inmesh.polyMaterials.assign(polyCount, fallback);
+
+  KFbxLayer *layer = mesh->GetLayer(0);
+  KFbxLayerElementMaterial *materialLayer = layer ? layer->GetMaterials() : NULL;
+  if(!materialLayer || materialLayer->GetMappingMode() != KFbxLayerElement::eBY_POLYGON)
+    return;
+
+  KFbxLayerElementArrayTemplate<int>& indices = materialLayer->GetIndexArray();
+  int count = std::min(polyCount, indices.GetCount());
+  for(int p = 0; p < count; ++p)
+  {
+    int index = indices.GetAt(p);
+    if(index >= 0 && index < static_cast<int>(nodeMaterials.size()))
+      inmesh.polyMaterials[p] = nodeMaterials[index];
+  }
+}
+void Scene::SaveTextures(void)
+{
+  printf("Compressing textures.\n");
+  std::string directory = output_.substr(0, output_.find_last_of("/\\") + 1);
+
+  //Every file is converted once per use (color or normal map) however many materials share it
+  std::map<std::string, std::string> converted;
+  std::set<std::string> usedNames;
+
+  for(unsigned int m = 0; m < materials_.size(); ++m)
+  {
+    for(unsigned int t = 0; t < GmfTextureSlots; ++t)
+    {
+      std::string& texture = materials_[m].textures_[t];
+      if(texture.empty())
+        continue;
+
+      bool normalMap = t == GmfTextureNormal;
+      std::string key = texture + (normalMap ? "|normal" : "|color");
+      std::map<std::string, std::string>::iterator it = converted.find(key);
+      if(it != converted.end())
+      {
+        texture = it->second;
+        continue;
+      }
+
+      //Named after the source, numbered when two sources share a name
+      std::string stem = texture.substr(texture.find_last_of("/\\") + 1);
+      stem = stem.substr(0, stem.find_last_of("."));
+      std::string name = stem + ".dds";
+      for(unsigned int n = 2; usedNames.count(name); ++n)
+      {
+        char suffix[32];
+        sprintf(suffix, "_%d.dds", n);
+        name = stem + suffix;
+      }
+
+      OutputFile *out = AddOutput(directory + name);
+      if(!ConvertTexture(texture.c_str(), normalMap, *out))
+      {
+        //Leave the reference to the source so the engine can still find something
+        outputs_.pop_back();
+        converted[key] = texture;
+        continue;
+      }
+
+      usedNames.insert(name);
+      converted[key] = name;
+      texture = name;
+    }
+  }
+}
+void Scene::WriteMaterials(FbxMesh& mesh)
+{
+  if(!materials_.empty())
+    WriteMaterialSection(fp_, materials_, mesh.materialRanges_);
+}
+unsigned long long Scene::HashSkeleton(void)
+{
+  //Hash what gets written, in floats, so round off in the FBX doubles can't split a skeleton
+  unsigned long long hash = HashSeed;
+  for(unsigned int i = 0; i < bones_.size(); ++i)
+  {
+    FbxBone& bone = bones_[i];
+    float pose[3 + 4 + 16];
+    const double *pos = reinterpret_cast<double*>(&bone.localPos_);
+    const double *rot = reinterpret_cast<double*>(&bone.localRot_);
+    const double *inv = reinterpret_cast<double*>(&bone.invTransform_);
+    for(int k = 0; k < 3; ++k)
+      pose[k] = static_cast<float>(pos[k]);
+    for(int k = 0; k < 4; ++k)
+      pose[3 + k] = static_cast<float>(rot[k]);
+    for(int k = 0; k < 16; ++k)
+      pose[7 + k] = static_cast<float>(inv[k]);
+
+    hash = HashBytes(bone.name_.c_str(), bone.name_.size() + 1, hash);
+    hash = HashBytes(&bone.pIndex_, sizeof(int), hash);
+    hash = HashBytes(pose, sizeof(pose), hash);
+  }
+  return hash;
+}
+OutputFile* Scene::SaveSkeleton(void)
+{
+  skeletonId_ = HashSkeleton();
+
+  char name[64];
+  sprintf(name, "skeleton_%016llx.gsk", skeletonId_);
+  skeletonFile_ = name;
+
+  std::string path = options_.skeletonDir_;
+  if(path[path.size() - 1] != '/' && path[path.size() - 1] != '\\')
+    path.push_back('/');
+  path += skeletonFile_;
+
+  //Saved only if no other asset on the same skeleton wrote it already
+  OutputFile *out = AddOutput(path);
+  out->shared_ = true;
+  BufferWrite(&skeletonId_, sizeof(unsigned long long), 1, out);
+  WriteBones(out, bones_);
+  return out;
+}
+void Scene::WriteSkeletonRef(void)
+{
+  if(skeletonFile_.empty())
+    return;
+
+  //Only the file name is stored, the engine keeps shared skeletons in one place
+  OutputSplice drop;
+  drop.offset_ = fp_->data_.size();
+  long section = BeginSection(fp_, GmfSectionSkeleton);
+  unsigned int boneCount = bones_.size();
+  unsigned int strsize = skeletonFile_.size();
+  BufferWrite(&skeletonId_, sizeof(unsigned long long), 1, fp_);
+  BufferWrite(&boneCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&strsize, sizeof(unsigned int), 1, fp_);
+  BufferWrite(skeletonFile_.c_str(), strsize, 1, fp_);
+  EndSection(fp_, section);
+
+  //Embedded bones need no reference
+  drop.size_ = fp_->data_.size() - drop.offset_;
+  fp_->fallback_.push_back(drop);
+}
+unsigned int Scene::EmbeddedAnimCount(void)
+{
+  //Split clips live in their own files
+  return options_.splitClips_ || !extractMesh_ ? 0 : anims_.size();
+}
+void Scene::SaveClips(void)
+{
+  std::string base = output_.substr(0, output_.find_last_of("."));
+  unsigned long long skeletonId = HashSkeleton();
+  unsigned int boneCount = bones_.size();
+
+  //Names already given out, lower case since Windows doesn't tell case apart
+  std::set<std::string> used;
+  for(unsigned int i = 0; i < anims_.size(); ++i)
+  {
+    FbxAnimation& anim = anims_[i];
+
+    //Keep the clip name usable as part of a file name
+    std::string clipName = anim.name_;
+    for(unsigned int c = 0; c < clipName.size(); ++c)
+      if(strchr("\\/:*?\"<>| ", clipName[c]))
+        clipName[c] = '_';
+
+    //Clips whose names only differ in the replaced characters get a number
+    std::string name = base + "_" + clipName;
+    for(unsigned int n = 2; ; ++n)
+    {
+      std::string key = name;
+      std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+      if(used.insert(key).second)
+        break;
+      char suffix[16];
+      sprintf(suffix, "_%u", n);
+      name = base + "_" + clipName + suffix;
+    }
+    if(name != base + "_" + clipName)
+      printf("Clip %s would overwrite another clip's file, writing it to %s.gma\n", anim.name_.c_str(), name.c_str());
+
+    OutputFile *fp = AddOutput(name + ".gma");
+
+    BufferWrite(&skeletonId, sizeof(unsigned long long), 1, fp);
+    BufferWrite(&boneCount, sizeof(unsigned int), 1, fp);
+    WriteAnimation(fp, anim);
+
+    //Bounds need the mesh's bone boxes
+    if(extractMesh_ && type_ == Skinned)
+      WriteAnimBounds(fp, &anim, 1);
+    if(!anim.morphCurves_.empty())
+      WriteMorphCurves(fp, &anim, 1);
+  }
+}
+void Scene::PruneBones(void)
+{
+  unsigned int boneCount = bones_.size();
+  if(!boneCount)
+    return;
+
+  //Anything a cluster puts weight on stays
+  std::vector<bool> keep(boneCount, false);
+  for(unsigned int m = 0; m < meshes_.size(); ++m)
+  {
+    std::vector<JointWeight>& pointWeights = meshes_[m].skin.PointWeights;
+    for(unsigned int i = 0; i < pointWeights.size(); ++i)
+      if(pointWeights[i].weight > 0.0f && pointWeights[i].index < boneCount)
+        keep[pointWeights[i].index] = true;
+  }
+
+  //With no weights at all the root still stays, the padding weights below
+  //need a bone to point at
+  if(std::find(keep.begin(), keep.end(), true) == keep.end())
+  {
+    printf("No bone moves any vertices, keeping the root\n");
+    keep[0] = true;
+  }
+
+  //Bones are collected breadth first so a parent always comes before its children,
+  //walking backwards keeps every ancestor of a bone that stays
+  for(unsigned int i = boneCount; i-- > 0; )
+    if(keep[i] && bones_[i].pIndex_ >= 0)
+      keep[bones_[i].pIndex_] = true;
+
+  std::vector<unsigned int> remap(boneCount, 0);
+  unsigned int kept = 0;
+  for(unsigned int i = 0; i < boneCount; ++i)
+  {
+    if(!keep[i])
+    {
+      printf("Pruning bone: %s\n", bones_[i].name_.c_str());
+      continue;
+    }
+
+    remap[i] = kept;
+    bones_[kept] = bones_[i];
+    bones_[kept].index_ = kept;
+    if(bones_[kept].pIndex_ >= 0)
+      bones_[kept].pIndex_ = remap[bones_[kept].pIndex_];
+    ++kept;
+  }
+  bones_.resize(kept);
+
+  //Padding weights of zero pointed at removed bones just go to the root
+  for(unsigned int m = 0; m < meshes_.size(); ++m)
+  {
+    std::vector<JointWeight>& pointWeights = meshes_[m].skin.PointWeights;
+    for(unsigned int i = 0; i < pointWeights.size(); ++i)
+    {
+      unsigned int& index = pointWeights[i].index;
+      index = index < boneCount && keep[index] ? remap[index] : 0;
+    }
+  }
+
+  printf("Pruned %d of %d bones.\n", boneCount - kept, boneCount);
+}
+void Scene::GenerateSkeletonLods(void)
+{
+  if(type_ != Skinned || meshes_.empty() || bones_.empty() || options_.skeletonLodRatios_.empty())
+    return;
+
+  printf("Generating skeleton levels of detail.\n");
+  FbxMesh& mesh = meshes_[0];
+  unsigned int boneCount = bones_.size();
+
+  //How much skin each bone moves, collapsed bones hand theirs to the parent
+  std::vector<float> influence(boneCount, 0.0f);
+  for(unsigned int i = 0; i < mesh.verts_.size(); ++i)
+  {
+    const JointWeight *weights = mesh.skin.Weights(mesh.source[i].posIndex);
+    for(unsigned int w = 0; w < maxWeights_; ++w)
+      if(weights[w].index < boneCount)
+        influence[weights[w].index] += weights[w].weight;
+  }
+
+  std::vector<unsigned int> target(boneCount);
+  std::vector<unsigned int> childCount(boneCount, 0);
+  std::vector<bool> alive(boneCount, true);
+  for(unsigned int i = 0; i < boneCount; ++i)
+  {
+    target[i] = i;
+    if(bones_[i].pIndex_ >= 0)
+      ++childCount[bones_[i].pIndex_];
+  }
+
+  unsigned int aliveCount = boneCount;
+  for(unsigned int l = 0; l < options_.skeletonLodRatios_.size(); ++l)
+  {
+    float ratio = options_.skeletonLodRatios_[l];
+    unsigned int wanted = std::max(1u, static_cast<unsigned int>(ceil(boneCount * ratio)));
+
+    while(aliveCount > wanted)
+    {
+      //Cheapest leaf to lose is a short bone moving little skin, roots always stay
+      int best = -1;
+      float bestCost = 0.0f;
+      for(unsigned int b = 0; b < boneCount; ++b)
+      {
+        int parent = bones_[b].pIndex_;
+        if(!alive[b] || childCount[b] || parent < 0)
+          continue;
+
+        float length = Length(ToFloat3(bones_[b].localPos_) - ToFloat3(bones_[parent].localPos_));
+        float cost = influence[b] * (length + 1e-3f);
+        if(best < 0 || cost < bestCost)
+        {
+          best = b;
+          bestCost = cost;
+        }
+      }
+
+      if(best < 0)
+        break;
+
+      int parent = bones_[best].pIndex_;
+      alive[best] = false;
+      --aliveCount;
+      --childCount[parent];
+      influence[parent] += influence[best];
+      for(unsigned int b = 0; b < boneCount; ++b)
+        if(target[b] == static_cast<unsigned int>(best))
+          target[b] = parent;
+    }
+
+    SkeletonLod lod;
+    lod.ratio_ = ratio;
+    std::vector<unsigned int> slot(boneCount, 0);
+    for(unsigned int b = 0; b < boneCount; ++b)
+      if(alive[b])
+      {
+        slot[b] = lod.bones_.size();
+        lod.bones_.push_back(b);
+      }
+
+    lod.remap_.resize(boneCount);
+    for(unsigned int b = 0; b < boneCount; ++b)
+      lod.remap_[b] = slot[target[b]];
+
+    printf("Skeleton level %d keeps %d of %d bones.\n", l + 1, lod.bones_.size(), boneCount);
+    skeletonLods_.push_back(lod);
+  }
+}
+void Scene::WriteSkeletonLods(FbxMesh& mesh)
+{
+  if(skeletonLods_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionSkeletonLods);
+  unsigned int levelCount = skeletonLods_.size();
+  unsigned int vertCount = mesh.verts_.size();
+  BufferWrite(&levelCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&vertCount, sizeof(unsigned int), 1, fp_);
+
+  for(unsigned int l = 0; l < levelCount; ++l)
+  {
+    SkeletonLod& lod = skeletonLods_[l];
+    unsigned int boneCount = lod.bones_.size();
+    BufferWrite(&lod.ratio_, sizeof(float), 1, fp_);
+    BufferWrite(&boneCount, sizeof(unsigned int), 1, fp_);
+    BufferWrite(&lod.bones_[0], sizeof(unsigned int) * boneCount, 1, fp_);
+
+    //Same weights as the payload, pointed at the bones they collapsed into
+    for(unsigned int i = 0; i < vertCount; ++i)
+    {
+      const JointWeight *weights = mesh.skin.Weights(mesh.source[i].posIndex);
+      for(unsigned int j = 0; j < 4; ++j)
+      {
+        unsigned int index = weights[j].index < lod.remap_.size() ? weights[j].index : 0;
+        unsigned char slot = static_cast<unsigned char>(lod.remap_[index]);
+        BufferWrite(&slot, sizeof(unsigned char), 1, fp_);
+      }
+    }
+  }
+  EndSection(fp_, section);
+}
+//Bump when anything a snapshot holds changes
+const unsigned SnapshotVersion = 6;
+const unsigned SnapshotMagic = GMF_TAG('G','S','N','P');
+
+//Snapshots copy these byte for byte, a build where they differ can't read them
+static void SnapshotLayout(unsigned layout[6])
+{
+  layout[0] = sizeof(KFbxXMatrix);
+  layout[1] = sizeof(KFbxMatrix);
+  layout[2] = sizeof(KFbxVector4);
+  layout[3] = sizeof(FbxKeyFrame);
+  layout[4] = sizeof(JointWeight);
+  layout[5] = sizeof(IndexedVert);
+}
+void Scene::SaveSnapshot(void)
+{
+  if(snapshotPath_.empty())
+    return;
+
+  //Written aside and moved into place so a crash never leaves half a snapshot
+  std::string tempPath = TempPathFor(snapshotPath_);
+  SnapshotWriter out;
+  out.fp_ = fopen(tempPath.c_str(), "wb");
+  if(!out.fp_)
+  {
+    printf("Couldn't open %s for writing!\n", tempPath.c_str());
+    return;
+  }
+
+  printf("Writing snapshot %s\n", snapshotPath_.c_str());
+  unsigned layout[6];
+  SnapshotLayout(layout);
+  out.Write(SnapshotMagic);
+  out.Write(SnapshotVersion);
+  out.Write(layout);
+
+  unsigned type = type_;
+  out.Write(type);
+  out.Write(extractMesh_);
+  out.Write(extractSkinData_);
+  out.Write(extractSkeletonData_);
+  out.Write(extractAnimations_);
+  out.Write(options_.instanceMeshes_);
+
+  unsigned materialCount = materials_.size();
+  out.Write(materialCount);
+  for(unsigned int i = 0; i < materialCount; ++i)
+  {
+    Material& material = materials_[i];
+    out.WriteString(material.name_);
+    out.Write(material.diffuse_);
+    out.Write(material.specular_);
+    out.Write(material.emissive_);
+    out.Write(material.opacity_);
+    out.Write(material.shininess_);
+    for(unsigned int t = 0; t < GmfTextureSlots; ++t)
+      out.WriteString(material.textures_[t]);
+  }
+
+  unsigned meshCount = meshes_.size();
+  out.Write(meshCount);
+  for(unsigned int m = 0; m < meshCount; ++m)
+  {
+    FbxMesh& mesh = meshes_[m];
+    out.WriteString(mesh.name_);
+    out.WriteVector(mesh.verts_.pos_);
+    out.WriteVector(mesh.verts_.nrm_);
+    out.WriteVector(mesh.verts_.uv_);
+    out.WriteVector(mesh.verts_.tan_);
+    out.WriteVector(mesh.verts_.bitan_);
+    out.WriteVector(mesh.indices_);
+    out.WriteVector(mesh.source);
+
+    out.WriteVector(mesh.skin.PointWeights);
+    out.WriteVector(mesh.materialRanges_);
+
+    unsigned subCount = mesh.subMeshes_.size();
+    out.Write(subCount);
+    for(unsigned int i = 0; i < subCount; ++i)
+    {
+      SubMesh& sub = mesh.subMeshes_[i];
+      out.WriteString(sub.name_);
+      out.Write(sub.vertStart_);
+      out.Write(sub.vertCount_);
+      out.Write(sub.indexStart_);
+      out.Write(sub.indexCount_);
+    }
+
+    unsigned morphCount = mesh.morphs_.size();
+    out.Write(morphCount);
+    for(unsigned int i = 0; i < morphCount; ++i)
+    {
+      MorphTarget& target = mesh.morphs_[i];
+      out.WriteString(target.name_);
+      out.Write(target.fullWeight_);
+      out.WriteVector(target.verts_);
+      out.WriteVector(target.posDeltas_);
+      out.WriteVector(target.nrmDeltas_);
+    }
+  }
+
+  unsigned instanceCount = instances_.size();
+  out.Write(instanceCount);
+  for(unsigned int i = 0; i < instanceCount; ++i)
+  {
+    out.Write(instances_[i].mesh_);
+    out.WriteString(instances_[i].name_);
+    out.Write(instances_[i].transform_);
+  }
+
+  unsigned boneCount = bones_.size();
+  out.Write(boneCount);
+  for(unsigned int i = 0; i < boneCount; ++i)
+  {
+    FbxBone& bone = bones_[i];
+    out.WriteString(bone.name_);
+    out.Write(bone.localPos_);
+    out.Write(bone.localRot_);
+    out.Write(bone.invTransform_);
+    out.Write(bone.index_);
+    out.Write(bone.pIndex_);
+  }
+
+  unsigned animCount = anims_.size();
+  out.Write(animCount);
+  for(unsigned int i = 0; i < animCount; ++i)
+  {
+    FbxAnimation& anim = anims_[i];
+    out.WriteString(anim.name_);
+    out.Write(anim.length_);
+    out.Write(anim.boundsRate_);
+
+    unsigned frameVecCount = anim.frames_.size();
+    out.Write(frameVecCount);
+    for(unsigned int j = 0; j < frameVecCount; ++j)
+      out.WriteVector(anim.frames_[j]);
+
+    unsigned curveCount = anim.morphCurves_.size();
+    out.Write(curveCount);
+    for(unsigned int c = 0; c < curveCount; ++c)
+    {
+      out.WriteString(anim.morphCurves_[c].name_);
+      out.WriteVector(anim.morphCurves_[c].times_);
+      out.WriteVector(anim.morphCurves_[c].weights_);
+    }
+
+    out.WriteVector(anim.boneSamples_);
+  }
+
+  fclose(out.fp_);
+  MoveIntoPlace(tempPath, snapshotPath_);
+}
+bool Scene::LoadSnapshot(void)
+{
+  unsigned long long key;
+  if(!HashFile(filename_.c_str(), key))
+    return false;
+
+  //Options that change what gets pulled out of the FBX scene are part of the key,
+  //everything done after that is free to change between runs
+  key = HashBytes(&SnapshotVersion, sizeof(unsigned), key);
+  key = HashBytes(&options_.instanceMeshes_, sizeof(bool), key);
+  key = HashBytes(&options_.animationOnly_, sizeof(bool), key);
+  key = HashBytes(&options_.skipAnimations_, sizeof(bool), key);
+  key = HashBytes(&options_.pruneBones_, sizeof(bool), key);
+
+  char name[64];
+  sprintf(name, "%016llx.gsnap", key);
+  snapshotPath_ = options_.cacheDir_;
+  if(snapshotPath_[snapshotPath_.size() - 1] != '/' && snapshotPath_[snapshotPath_.size() - 1] != '\\')
+    snapshotPath_.push_back('/');
+  snapshotPath_ += name;
+
+  MappedFile file;
+  if(!file.Open(snapshotPath_.c_str()))
+    return false;
+
+  SnapshotReader in = {file.Data(), file.Data(), file.Data() + file.Size(), true};
+  unsigned magic, version, layout[6], expected[6];
+  SnapshotLayout(expected);
+  in.Read(magic);
+  in.Read(version);
+  in.Read(layout);
+  if(magic != SnapshotMagic || version != SnapshotVersion || memcmp(layout, expected, sizeof(layout)))
+  {
+    printf("Snapshot %s is out of date, importing.\n", snapshotPath_.c_str());
+    return false;
+  }
+
+  printf("Loading snapshot %s\n", snapshotPath_.c_str());
+  //Read aside and only taken once the whole file checks out, so a damaged
+  //snapshot leaves nothing behind for the import that replaces it
+  unsigned type;
+  bool extractMesh, extractSkinData, extractSkeletonData, extractAnimations, instanceMeshes;
+  std::vector<Material> materials;
+  std::vector<FbxMesh> meshes;
+  std::vector<MeshInstance> instances;
+  std::vector<FbxBone> bones;
+  std::vector<FbxAnimation> anims;
+  in.Read(type);
+  in.Read(extractMesh);
+  in.Read(extractSkinData);
+  in.Read(extractSkeletonData);
+  in.Read(extractAnimations);
+  in.Read(instanceMeshes);
+
+  unsigned materialCount;
+  in.Read(materialCount);
+  for(unsigned int i = 0; i < materialCount && in.ok_; ++i)
+  {
+    Material material;
+    material.source_ = NULL;
+    in.ReadString(material.name_);
+    in.Read(material.diffuse_);
+    in.Read(material.specular_);
+    in.Read(material.emissive_);
+    in.Read(material.opacity_);
+    in.Read(material.shininess_);
+    for(unsigned int t = 0; t < GmfTextureSlots; ++t)
+      in.ReadString(material.textures_[t]);
+    materials.push_back(material);
+  }
+
+  unsigned meshCount;
+  in.Read(meshCount);
+  for(unsigned int m = 0; m < meshCount && in.ok_; ++m)
+  {
+    meshes.push_back(FbxMesh(NULL, NULL));
+    FbxMesh& mesh = meshes.back();
+    in.ReadString(mesh.name_);
+    in.ReadVector(mesh.verts_.pos_);
+    in.ReadVector(mesh.verts_.nrm_);
+    in.ReadVector(mesh.verts_.uv_);
+    in.ReadVector(mesh.verts_.tan_);
+    in.ReadVector(mesh.verts_.bitan_);
+    in.ReadVector(mesh.indices_);
+    in.ReadVector(mesh.source);
+
+    in.ReadVector(mesh.skin.PointWeights);
+    in.ReadVector(mesh.materialRanges_);
+
+    unsigned subCount;
+    in.Read(subCount);
+    for(unsigned int i = 0; i < subCount && in.ok_; ++i)
+    {
+      SubMesh sub;
+      in.ReadString(sub.name_);
+      in.Read(sub.vertStart_);
+      in.Read(sub.vertCount_);
+      in.Read(sub.indexStart_);
+      in.Read(sub.indexCount_);
+      mesh.subMeshes_.push_back(sub);
+    }
+
+    unsigned morphCount;
+    in.Read(morphCount);
+    for(unsigned int i = 0; i < morphCount && in.ok_; ++i)
+    {
+      MorphTarget target;
+      in.ReadString(target.name_);
+      in.Read(target.fullWeight_);
+      in.ReadVector(target.verts_);
+      in.ReadVector(target.posDeltas_);
+      in.ReadVector(target.nrmDeltas_);
+      mesh.morphs_.push_back(target);
+    }
+  }
+
+  unsigned instanceCount;
+  in.Read(instanceCount);
+  for(unsigned int i = 0; i < instanceCount && in.ok_; ++i)
+  {
+    MeshInstance instance;
+    instance.node_ = NULL;
+    in.Read(instance.mesh_);
+    in.ReadString(instance.name_);
+    in.Read(instance.transform_);
+    instances.push_back(instance);
+  }
+
+  unsigned boneCount;
+  in.Read(boneCount);
+  for(unsigned int i = 0; i < boneCount && in.ok_; ++i)
+  {
+    FbxBone bone;
+    bone.bone_ = NULL;
+    in.ReadString(bone.name_);
+    in.Read(bone.localPos_);
+    in.Read(bone.localRot_);
+    in.Read(bone.invTransform_);
+    in.Read(bone.index_);
+    in.Read(bone.pIndex_);
+    bones.push_back(bone);
+  }
+
+  unsigned animCount;
+  in.Read(animCount);
+  for(unsigned int i = 0; i < animCount && in.ok_; ++i)
+  {
+    anims.push_back(FbxAnimation());
+    FbxAnimation& anim = anims.back();
+    in.ReadString(anim.name_);
+    in.Read(anim.length_);
+    in.Read(anim.boundsRate_);
+
+    unsigned frameVecCount;
+    in.Read(frameVecCount);
+    for(unsigned int j = 0; j < frameVecCount && in.ok_; ++j)
+    {
+      anim.frames_.push_back(std::vector<FbxKeyFrame>());
+      in.ReadVector(anim.frames_.back());
+    }
+
+    unsigned curveCount;
+    in.Read(curveCount);
+    for(unsigned int c = 0; c < curveCount && in.ok_; ++c)
+    {
+      MorphCurve curve;
+      in.ReadString(curve.name_);
+      in.ReadVector(curve.times_);
+      in.ReadVector(curve.weights_);
+      anim.morphCurves_.push_back(curve);
+    }
+
+    in.ReadVector(anim.boneSamples_);
+  }
+
+  if(!in.ok_ || in.cur_ != in.end_)
+  {
+    printf("Snapshot %s is damaged, importing.\n", snapshotPath_.c_str());
+    return false;
+  }
+
+  type_ = static_cast<ModelType>(type);
+  extractMesh_ = extractMesh;
+  extractSkinData_ = extractSkinData;
+  extractSkeletonData_ = extractSkeletonData;
+  extractAnimations_ = extractAnimations;
+  options_.instanceMeshes_ = instanceMeshes;
+  materials_.swap(materials);
+  meshes_.swap(meshes);
+  instances_.swap(instances);
+  bones_.swap(bones);
+  anims_.swap(anims);
+  fromSnapshot_ = true;
+  return true;
+}
+OutputFile* Scene::AddOutput(const std::string& name)
+{
+  outputs_.push_back(OutputFile());
+  outputs_.back().name_ = name;
+  return &outputs_.back();
+}
+void Scene::RunStage(const char *name, void (Scene::*stage)(void))
+{
+  StageTimer timer(timings_, name);
+  (this->*stage)();
+}
+void Scene::TakeTimings(std::vector<StageTime>& timings)
+{
+  timings.insert(timings.end(), timings_.begin(), timings_.end());
+  timings_.clear();
+}
+void Scene::TakeOutputs(std::vector<OutputFile>& outputs)
+{
+  //Swapped rather than copied, the buffers can be large
+  for(std::list<OutputFile>::iterator it = outputs_.begin(); it != outputs_.end(); ++it)
+  {
+    outputs.push_back(OutputFile());
+    outputs.back().name_.swap(it->name_);
+    outputs.back().data_.swap(it->data_);
+    outputs.back().sections_.swap(it->sections_);
+    outputs.back().shared_ = it->shared_;
+    outputs.back().dependency_.swap(it->dependency_);
+    outputs.back().fallback_.swap(it->fallback_);
+  }
+  outputs_.clear();
+}
+void Scene::CombineMeshes(void)
+{
+  printf("Combining meshes\n");
+  printf("%d", meshes_.size());
+  
+  for(unsigned int i = 1; i < meshes_.size(); ++i)
+    meshes_[0].CombineInto( meshes_[i] );
+}
+void Scene::IndexCuts(FbxMesh& mesh, std::vector<unsigned int>& cuts)
+{
+  cuts.clear();
+  for(unsigned int s = 0; s < mesh.subMeshes_.size(); ++s)
+  {
+    cuts.push_back(mesh.subMeshes_[s].indexStart_);
+    cuts.push_back(mesh.subMeshes_[s].indexStart_ + mesh.subMeshes_[s].indexCount_);
+  }
+  for(unsigned int r = 0; r < mesh.materialRanges_.size(); ++r)
+  {
+    cuts.push_back(mesh.materialRanges_[r].indexStart_);
+    cuts.push_back(mesh.materialRanges_[r].indexStart_ + mesh.materialRanges_[r].indexCount_);
+  }
+  std::sort(cuts.begin(), cuts.end());
+  cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+}
+void Scene::CleanMesh(void)
+{
+  if(meshes_.empty())
+    return;
+
+  FbxMesh& mesh = meshes_[0];
+  unsigned int triCount = mesh.indices_.size() / 3;
+  if(!triCount)
+    return;
+
+  printf("Cleaning the mesh.\n");
+
+  //Duplicates only count inside one sub mesh and material, a copy in another
+  //material draws something different
+  std::vector<unsigned int> cuts;
+  IndexCuts(mesh, cuts);
+  std::vector<unsigned> groups(triCount);
+  unsigned int cut = 0;
+  for(unsigned int t = 0; t < triCount; ++t)
+  {
+    while(cut < cuts.size() && cuts[cut] <= t * 3)
+      ++cut;
+    groups[t] = cut;
+  }
+
+  std::vector<bool> keep;
+  CleanStats stats;
+  FindWastedTriangles(&mesh.verts_.pos_[0], &mesh.indices_[0], triCount * 3, &groups[0], keep, stats);
+
+  //Kept triangles before each triangle, index ranges are moved through it
+  std::vector<unsigned int> keptTris(triCount + 1, 0);
+  for(unsigned int t = 0; t < triCount; ++t)
+  {
+    keptTris[t + 1] = keptTris[t] + (keep[t] ? 1 : 0);
+    if(keep[t])
+      for(int c = 0; c < 3; ++c)
+        mesh.indices_[keptTris[t] * 3 + c] = mesh.indices_[t * 3 + c];
+  }
+  mesh.indices_.resize(keptTris[triCount] * 3);
+
+  for(unsigned int s = 0; s < mesh.subMeshes_.size(); ++s)
+  {
+    SubMesh& sub = mesh.subMeshes_[s];
+    unsigned int end = keptTris[(sub.indexStart_ + sub.indexCount_) / 3] * 3;
+    sub.indexStart_ = keptTris[sub.indexStart_ / 3] * 3;
+    sub.indexCount_ = end - sub.indexStart_;
+  }
+  for(unsigned int r = 0; r < mesh.materialRanges_.size(); ++r)
+  {
+    MaterialRange& range = mesh.materialRanges_[r];
+    unsigned int end = keptTris[(range.indexStart_ + range.indexCount_) / 3] * 3;
+    range.indexStart_ = keptTris[range.indexStart_ / 3] * 3;
+    range.indexCount_ = end - range.indexStart_;
+  }
+
+  //Vertices nothing uses any more, or never did, are dropped from every stream
+  unsigned int vertCount = mesh.verts_.size();
+  std::vector<int> remap(vertCount, -1);
+  for(unsigned int i = 0; i < mesh.indices_.size(); ++i)
+    remap[mesh.indices_[i]] = 0;
+
+  std::vector<unsigned int> keptVerts(vertCount + 1, 0);
+  for(unsigned int v = 0; v < vertCount; ++v)
+  {
+    if(remap[v] == 0)
+      remap[v] = keptVerts[v];
+    keptVerts[v + 1] = keptVerts[v] + (remap[v] >= 0 ? 1 : 0);
+  }
+  stats.orphans_ = vertCount - keptVerts[vertCount];
+
+  if(stats.orphans_)
+  {
+    VertexStreams verts;
+    std::vector<IndexedVert> source;
+    verts.reserve(keptVerts[vertCount]);
+    source.reserve(keptVerts[vertCount]);
+    for(unsigned int v = 0; v < vertCount; ++v)
+    {
+      if(remap[v] < 0)
+        continue;
+      verts.AppendVertex(mesh.verts_, v);
+      if(v < mesh.source.size())
+        source.push_back(mesh.source[v]);
+    }
+    mesh.verts_.swap(verts);
+    mesh.source.swap(source);
+
+    for(unsigned int i = 0; i < mesh.indices_.size(); ++i)
+      mesh.indices_[i] = remap[mesh.indices_[i]];
+
+    for(unsigned int s = 0; s < mesh.subMeshes_.size(); ++s)
+    {
+      SubMesh& sub = mesh.subMeshes_[s];
+      unsigned int end = keptVerts[sub.vertStart_ + sub.vertCount_];
+      sub.vertStart_ = keptVerts[sub.vertStart_];
+      sub.vertCount_ = end - sub.vertStart_;
+    }
+
+    for(unsigned int m = 0; m < mesh.morphs_.size(); ++m)
+    {
+      MorphTarget& morph = mesh.morphs_[m];
+      unsigned int kept = 0;
+      for(unsigned int i = 0; i < morph.verts_.size(); ++i)
+      {
+        if(remap[morph.verts_[i]] < 0)
+          continue;
+        morph.verts_[kept] = remap[morph.verts_[i]];
+        morph.posDeltas_[kept] = morph.posDeltas_[i];
+        morph.nrmDeltas_[kept] = morph.nrmDeltas_[i];
+        ++kept;
+      }
+      morph.verts_.resize(kept);
+      morph.posDeltas_.resize(kept);
+      morph.nrmDeltas_.resize(kept);
+    }
+  }
+
+  unsigned int removed = triCount - keptTris[triCount];
+  printf("Removed %d of %d triangles (%.1f%%): %d collapsed, %d zero area, %d duplicates.\n",
+         removed, triCount, 100.0f * removed / triCount, stats.collapsed_, stats.zeroArea_, stats.duplicates_);
+  printf("Removed %d of %d vertices (%.1f%%) no triangle uses.\n",
+         stats.orphans_, vertCount, vertCount ? 100.0f * stats.orphans_ / vertCount : 0.0f);
+}
+void Scene::ComputeBounds(void)
+{
+  printf("Computing bounds.\n");
+  if(meshes_.empty())
+    return;
+
+  //All of the meshes are now stored in meshes_[0]
+  FbxMesh& mesh = meshes_[0];
+  const std::vector<Float3>& pos = mesh.verts_.pos_;
+  const Float3* points = pos.empty() ? NULL : &pos[0];
+
+  mesh.bounds_ = ComputeAabb(points, pos.size());
+  mesh.sphere_ = ComputeSphere(points, pos.size());
+
+  for(unsigned int i = 0; i < mesh.subMeshes_.size(); ++i)
+  {
+    SubMesh& sub = mesh.subMeshes_[i];
+    sub.bounds_ = ComputeAabb(points + sub.vertStart_, sub.vertCount_);
+    sub.sphere_ = ComputeSphere(points + sub.vertStart_, sub.vertCount_);
+  }
+
+  if(type_ == Skinned)
+    ComputeBoneBounds(mesh);
+}
+void Scene::ComputeBoneBounds(FbxMesh& mesh)
+{
+  for(unsigned int i = 0; i < bones_.size(); ++i)
+    bones_[i].bounds_ = EmptyAabb();
+
+  //Grow each bone's box by every vertex it has weight on, taken into the bone's bind space
+  for(unsigned int i = 0; i < mesh.verts_.size(); ++i)
+  {
+    const Float3& p = mesh.verts_.pos_[i];
+    KFbxVector4 pos(p.x, p.y, p.z, 1.0);
+
+    const JointWeight *weights = mesh.skin.Weights(mesh.source[i].posIndex);
+    for(unsigned int w = 0; w < maxWeights_; ++w)
+    {
+      if(weights[w].weight <= 0.0f || weights[w].index >= bones_.size())
+        continue;
+
+      FbxBone& bone = bones_[weights[w].index];
+      Grow(bone.bounds_, ToFloat3(bone.invTransform_.MultNormalize(pos)));
+    }
+  }
+}
+void Scene::SampleBoneTransforms(void)
+{
+  if(type_ != Skinned || anims_.empty() || bones_.empty())
+    return;
+
+  printf("Sampling bone transforms.\n");
+  KFbxAnimEvaluator *evaluator = scene_->GetEvaluator();
+  unsigned int boneCount = bones_.size();
+
+  for(unsigned int i = 0; i < anims_.size(); ++i)
+  {
+    FbxAnimation& anim = anims_[i];
+    scene_->ActiveAnimStackName = anim.name_.c_str();
+
+    unsigned int sampleCount = static_cast<unsigned int>(ceil(anim.length_ * BoundsSampleRate)) + 1;
+    anim.boundsRate_ = BoundsSampleRate;
+    anim.boneSamples_.resize(sampleCount * boneCount);
+
+    for(unsigned int s = 0; s < sampleCount; ++s)
+    {
+      double seconds = s / BoundsSampleRate;
+      if(seconds > anim.length_)
+        seconds = anim.length_;
+
+      KTime time;
+      time.SetSecondDouble(anim.start_.GetSecondDouble() + seconds);
+
+      for(unsigned int b = 0; b < boneCount; ++b)
+      {
+        KFbxXMatrix matrix = evaluator->GetNodeGlobalTransform(bones_[b].bone_->GetNode(), time);
+
+        //Normalize the scaling the same way the bind pose was
+        KFbxVector4 scale = matrix.GetS();
+        for(int k = 0; k < 4; ++k)
+          scale.SetAt(k, 1 / scale[k]);
+        KFbxXMatrix scaleMatrix;
+        scaleMatrix.SetS(scale);
+        matrix = scaleMatrix * matrix;
+
+        mtxConverter_->ConvertMatrix(matrix);
+        anim.boneSamples_[s * boneCount + b] = matrix;
+      }
+    }
+  }
+}
+void Scene::CollectAnimatedBounds(void)
+{
+  if(type_ != Skinned || anims_.empty() || bones_.empty())
+    return;
+
+  printf("Computing animated bounds.\n");
+  unsigned int boneCount = bones_.size();
+
+  for(unsigned int i = 0; i < anims_.size(); ++i)
+  {
+    FbxAnimation& anim = anims_[i];
+
+    unsigned int sampleCount = anim.boneSamples_.size() / boneCount;
+    std::vector<Aabb> samples(sampleCount, EmptyAabb());
+    anim.bounds_ = EmptyAabb();
+
+    for(unsigned int s = 0; s < sampleCount; ++s)
+    {
+      //Move every bone's bind space box by the bone's pose at this time
+      for(unsigned int b = 0; b < boneCount; ++b)
+      {
+        const Aabb& boneBox = bones_[b].bounds_;
+        if(IsEmpty(boneBox))
+          continue;
+
+        const KFbxXMatrix& matrix = anim.boneSamples_[s * boneCount + b];
+        for(int c = 0; c < 8; ++c)
+        {
+          KFbxVector4 corner((c & 1) ? boneBox.max_.x : boneBox.min_.x,
+                             (c & 2) ? boneBox.max_.y : boneBox.min_.y,
+                             (c & 4) ? boneBox.max_.z : boneBox.min_.z, 1.0);
+          Grow(samples[s], ToFloat3(Transform(matrix, corner)));
+        }
+      }
+
+      Grow(anim.bounds_, samples[s]);
+    }
+
+    //Store each sample relative to the clip's box
+    anim.boundsTrack_.resize(sampleCount * 6);
+    for(unsigned int s = 0; s < sampleCount; ++s)
+      QuantizeAabb(samples[s], anim.bounds_, &anim.boundsTrack_[s * 6]);
+
+    std::vector<KFbxXMatrix>().swap(anim.boneSamples_);
+  }
+}
+void Scene::WriteBounds(FbxMesh& mesh)
+{
+  WriteMeshBounds(fp_, mesh.bounds_, mesh.sphere_, mesh.subMeshes_);
+
+  if(type_ == Skinned)
+  {
+    long section = BeginSection(fp_, GmfSectionBoneBounds);
+    unsigned int boneCount = bones_.size();
+    BufferWrite(&boneCount, sizeof(unsigned int), 1, fp_);
+    for(unsigned int i = 0; i < boneCount; ++i)
+      BufferWrite(&bones_[i].bounds_, sizeof(Aabb), 1, fp_);
+    EndSection(fp_, section);
+
+    WriteAnimBounds(fp_, anims_.empty() ? NULL : &anims_[0], EmbeddedAnimCount());
+  }
+}
+void Scene::GenerateBvh(void)
+{
+  if(meshes_.empty())
+    return;
+
+  printf("Building BVH.\n");
+  FbxMesh& mesh = meshes_[0];
+  if(mesh.indices_.empty())
+    return;
+
+  BuildBvh(&mesh.verts_.pos_[0], &mesh.indices_[0], mesh.indices_.size() / 3, mesh.bvh_);
+  printf("BVH has %d nodes.\n", mesh.bvh_.nodes_.size());
+
+  if(options_.bvhBenchRays_)
+    BenchmarkBvh(mesh.bvh_, &mesh.verts_.pos_[0], &mesh.indices_[0], options_.bvhBenchRays_);
+}
+void Scene::WriteBvh(FbxMesh& mesh)
+{
+  if(mesh.bvh_.nodes_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionBvh);
+  unsigned int nodeCount = mesh.bvh_.nodes_.size();
+  unsigned int triCount = mesh.bvh_.triIndices_.size();
+  BufferWrite(&nodeCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&triCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&mesh.bvh_.nodes_[0], sizeof(BvhNode) * nodeCount, 1, fp_);
+  BufferWrite(&mesh.bvh_.triIndices_[0], sizeof(unsigned int) * triCount, 1, fp_);
+  EndSection(fp_, section);
+}
+void Scene::GenerateOcclusion(void)
+{
+  if(meshes_.empty())
+    return;
+
+  //Instanced meshes sit on top of each other in their local spaces
+  if(options_.instanceMeshes_)
+  {
+    printf("Ambient occlusion needs baked transforms, skipping it.\n");
+    return;
+  }
+
+  FbxMesh& mesh = meshes_[0];
+  if(mesh.indices_.empty())
+    return;
+
+  //Use the BVH when one is being written anyway, otherwise build one just for the bake
+  Bvh bakeBvh;
+  const Bvh *bvh = &mesh.bvh_;
+  if(mesh.bvh_.nodes_.empty())
+  {
+    BuildBvh(&mesh.verts_.pos_[0], &mesh.indices_[0], mesh.indices_.size() / 3, bakeBvh);
+    bvh = &bakeBvh;
+  }
+
+  float distance = options_.aoDistance_ > 0.0f ? options_.aoDistance_ : mesh.sphere_.radius_ * OcclusionRadiusScale;
+  mesh.occlusionDistance_ = distance;
+  printf("Baking ambient occlusion, %d rays per vertex up to %f units.\n", options_.aoSamples_, distance);
+
+  BakeOcclusion(*bvh, &mesh.verts_.pos_[0], &mesh.verts_.nrm_[0], mesh.verts_.size(), &mesh.indices_[0],
+                options_.aoSamples_, distance, mesh.occlusion_);
+  printf("Baked %d vertices.\n", mesh.verts_.size());
+}
+void Scene::WriteOcclusion(FbxMesh& mesh)
+{
+  if(mesh.occlusion_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionOcclusion);
+  unsigned int vertCount = mesh.occlusion_.size();
+  BufferWrite(&vertCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&mesh.occlusionDistance_, sizeof(float), 1, fp_);
+  BufferWrite(&mesh.occlusion_[0], sizeof(unsigned char) * vertCount, 1, fp_);
+  EndSection(fp_, section);
+}
+void Scene::GenerateOccluders(void)
+{
+  if(meshes_.empty())
+    return;
+
+  //Skinned meshes move away from whatever was built in the bind pose
+  if(type_ == Skinned)
+  {
+    printf("Occluders are only built for static scenes, skipping them.\n");
+    return;
+  }
+
+  FbxMesh& mesh = meshes_[0];
+  if(mesh.indices_.empty())
+    return;
+
+  printf("Building occluders, at most %d triangles each.\n", options_.occluderTris_);
+
+  //Seams aren't cracks
+  std::vector<unsigned> weldIds;
+  WeldVertices(mesh, weldIds);
+
+  unsigned int built = 0, triCount = 0;
+  mesh.occluders_.resize(mesh.subMeshes_.size());
+  for(unsigned int s = 0; s < mesh.subMeshes_.size(); ++s)
+  {
+    SubMesh& sub = mesh.subMeshes_[s];
+    OccluderMesh& occluder = mesh.occluders_[s];
+    if(BuildOccluder(&mesh.verts_.pos_[0], &mesh.indices_[sub.indexStart_], sub.indexCount_, &weldIds[0],
+                     OccluderResolution, options_.occluderTris_, occluder))
+    {
+      ++built;
+      triCount += occluder.indices_.size() / 3;
+    }
+    else
+      printf("%s has no closed inside, it gets no occluder.\n", sub.name_.c_str());
+  }
+
+  printf("Built %d occluders with %d triangles.\n", built, triCount);
+}
+void Scene::WriteOccluders(FbxMesh& mesh)
+{
+  if(mesh.occluders_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionOccluders);
+  unsigned int occluderCount = mesh.occluders_.size();
+  BufferWrite(&occluderCount, sizeof(unsigned int), 1, fp_);
+  for(unsigned int i = 0; i < occluderCount; ++i)
+  {
+    OccluderMesh& occluder = mesh.occluders_[i];
+    unsigned int vertCount = occluder.positions_.size();
+    unsigned int indexCount = occluder.indices_.size();
+    BufferWrite(&vertCount, sizeof(unsigned int), 1, fp_);
+    BufferWrite(&indexCount, sizeof(unsigned int), 1, fp_);
+    if(vertCount)
+    {
+      BufferWrite(&occluder.positions_[0], sizeof(Float3) * vertCount, 1, fp_);
+      BufferWrite(&occluder.indices_[0], sizeof(int) * indexCount, 1, fp_);
+    }
+  }
+  EndSection(fp_, section);
+}
+void Scene::GenerateCollision(void)
+{
+  if(meshes_.empty())
+    return;
+
+  FbxMesh& mesh = meshes_[0];
+  if(mesh.indices_.empty())
+    return;
+
+  CollisionSettings settings;
+  settings.maxHulls_ = options_.maxHulls_;
+  settings.maxHullVerts_ = options_.maxHullVerts_;
+  settings.resolution_ = CollisionResolution;
+
+  std::vector<CollisionRange> ranges(mesh.subMeshes_.size());
+  for(unsigned int s = 0; s < ranges.size(); ++s)
+  {
+    ranges[s].indexStart_ = mesh.subMeshes_[s].indexStart_;
+    ranges[s].indexCount_ = mesh.subMeshes_[s].indexCount_;
+  }
+
+  printf("Cooking collision hulls.\n");
+  CookCollision(&mesh.verts_.pos_[0], &mesh.indices_[0], ranges, settings, mesh.collision_);
+
+  unsigned int pieceCount = 0;
+  for(unsigned int s = 0; s < mesh.collision_.size(); ++s)
+  {
+    if(mesh.collision_[s].hull_.indices_.empty())
+      printf("%s is flat, it gets no hull.\n", mesh.subMeshes_[s].name_.c_str());
+    pieceCount += mesh.collision_[s].parts_.size();
+  }
+
+  printf("Cooked %d shapes with %d convex pieces.\n", mesh.collision_.size(), pieceCount);
+}
+void Scene::WriteCollision(FbxMesh& mesh)
+{
+  if(mesh.collision_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionCollision);
+  unsigned int shapeCount = mesh.collision_.size();
+  BufferWrite(&shapeCount, sizeof(unsigned int), 1, fp_);
+  for(unsigned int s = 0; s < shapeCount; ++s)
+  {
+    CollisionShape& shape = mesh.collision_[s];
+    WriteHull(fp_, shape.hull_);
+
+    unsigned int partCount = shape.parts_.size();
+    BufferWrite(&partCount, sizeof(unsigned int), 1, fp_);
+    for(unsigned int p = 0; p < partCount; ++p)
+      WriteHull(fp_, shape.parts_[p]);
+  }
+  EndSection(fp_, section);
+}
+//Vertices split off the same control point of the same source mesh get one id.
+//CombineInto keeps control point numbers apart between source meshes, so one
+//table covers the whole mesh. Returns how many ids there are.
+unsigned int Scene::WeldVertices(FbxMesh& mesh, std::vector<unsigned>& weldIds)
+{
+  weldIds.assign(mesh.verts_.size(), 0);
+
+  unsigned int weldCount = 0;
+  std::vector<int> welded;
+  for(unsigned int v = 0; v < mesh.verts_.size(); ++v)
+  {
+    unsigned int point = mesh.source[v].posIndex;
+    if(point >= welded.size())
+      welded.resize(point + 1, -1);
+    if(welded[point] < 0)
+      welded[point] = weldCount++;
+    weldIds[v] = welded[point];
+  }
+  return weldCount;
+}
+void Scene::GenerateEdges(void)
+{
+  if(meshes_.empty())
+    return;
+
+  FbxMesh& mesh = meshes_[0];
+  if(mesh.indices_.empty())
+    return;
+
+  printf("Building edge adjacency.\n");
+  std::vector<unsigned> weldIds;
+  WeldVertices(mesh, weldIds);
+
+  BuildEdges(&mesh.indices_[0], mesh.indices_.size(), &weldIds[0], mesh.edges_);
+  if(options_.adjacencyIndices_)
+    BuildAdjacencyIndices(&mesh.indices_[0], mesh.indices_.size(), mesh.edges_, mesh.adjacency_);
+
+  printf("Mesh has %d edges, %d on boundaries and %d non manifold.\n",
+         mesh.edges_.edgeCount_, mesh.edges_.boundaryCount_, mesh.edges_.nonManifoldCount_);
+}
+void Scene::WriteEdges(FbxMesh& mesh)
+{
+  if(mesh.edges_.twins_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionEdges);
+  unsigned int halfCount = mesh.edges_.twins_.size();
+  BufferWrite(&mesh.edges_.edgeCount_, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&mesh.edges_.boundaryCount_, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&mesh.edges_.nonManifoldCount_, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&halfCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&mesh.edges_.twins_[0], sizeof(int) * halfCount, 1, fp_);
+  BufferWrite(&mesh.edges_.flags_[0], sizeof(unsigned char) * halfCount, 1, fp_);
+  EndSection(fp_, section);
+
+  if(mesh.adjacency_.empty())
+    return;
+
+  section = BeginSection(fp_, GmfSectionAdjacency);
+  unsigned int indexCount = mesh.adjacency_.size();
+  BufferWrite(&indexCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&mesh.adjacency_[0], sizeof(int) * indexCount, 1, fp_);
+  EndSection(fp_, section);
+}
+void Scene::GenerateDepthStream(void)
+{
+  if(meshes_.empty())
+    return;
+
+  FbxMesh& mesh = meshes_[0];
+  if(mesh.indices_.empty())
+    return;
+
+  printf("Building the depth stream.\n");
+  unsigned int indexCount = mesh.indices_.size();
+  mesh.depthVerts_.clear();
+  mesh.depthIndices_.assign(indexCount, 0);
+
+  //Triangles only move inside these, so every range of the payload's indices holds for the depth ones
+  std::vector<unsigned int> cuts;
+  IndexCuts(mesh, cuts);
+
+  //Weld ids never cross sub meshes, so each sub mesh's depth vertices stay together
+  std::vector<unsigned> weldIds;
+  std::vector<int> welded(WeldVertices(mesh, weldIds), -1);
+
+  std::vector<int> optimized, firstUse;
+  std::vector<unsigned int> ordered;
+  for(unsigned int s = 0; s < mesh.subMeshes_.size(); ++s)
+  {
+    SubMesh& sub = mesh.subMeshes_[s];
+    unsigned int start = sub.indexStart_, end = sub.indexStart_ + sub.indexCount_;
+    unsigned int depthStart = mesh.depthVerts_.size();
+
+    for(unsigned int i = start; i < end; ++i)
+    {
+      int v = mesh.indices_[i];
+      int& depthVert = welded[weldIds[v]];
+      if(depthVert < 0)
+      {
+        depthVert = mesh.depthVerts_.size() - depthStart;
+        mesh.depthVerts_.push_back(v);
+      }
+      mesh.depthIndices_[i] = depthVert;
+    }
+    unsigned int subVerts = mesh.depthVerts_.size() - depthStart;
+
+    for(unsigned int c = 0; c + 1 < cuts.size(); ++c)
+    {
+      if(cuts[c] < start || cuts[c + 1] > end)
+        continue;
+
+      unsigned int count = cuts[c + 1] - cuts[c];
+      optimized.resize(count);
+      OptimizeVertexCache(&mesh.depthIndices_[cuts[c]], count, subVerts, &optimized[0]);
+      std::copy(optimized.begin(), optimized.end(), mesh.depthIndices_.begin() + cuts[c]);
+    }
+
+    //Vertices go in the order the triangles first use them so fetches stay close together
+    firstUse.assign(subVerts, -1);
+    ordered.clear();
+    for(unsigned int i = start; i < end; ++i)
+    {
+      int& local = firstUse[mesh.depthIndices_[i]];
+      if(local < 0)
+      {
+        local = ordered.size();
+        ordered.push_back(mesh.depthVerts_[depthStart + mesh.depthIndices_[i]]);
+      }
+      mesh.depthIndices_[i] = depthStart + local;
+    }
+    std::copy(ordered.begin(), ordered.end(), mesh.depthVerts_.begin() + depthStart);
+  }
+
+  float before = AverageCacheMissRatio(&mesh.indices_[0], indexCount, mesh.verts_.size());
+  float after = AverageCacheMissRatio(&mesh.depthIndices_[0], indexCount, mesh.depthVerts_.size());
+  printf("Depth stream has %d of %d vertices, %.2f vertices transformed per triangle instead of %.2f.\n",
+         mesh.depthVerts_.size(), mesh.verts_.size(), after, before);
+}
+void Scene::WriteDepthStream(FbxMesh& mesh)
+{
+  if(mesh.depthVerts_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionDepth);
+  unsigned int vertCount = mesh.depthVerts_.size();
+  unsigned int indexCount = mesh.depthIndices_.size();
+  BufferWrite(&vertCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&indexCount, sizeof(unsigned int), 1, fp_);
+  for(unsigned int i = 0; i < vertCount; ++i)
+  {
+    unsigned int v = mesh.depthVerts_[i];
+    BufferWrite(&mesh.verts_.pos_[v], sizeof(Float3), 1, fp_);
+    if(type_ == Skinned)
+      WriteSkinWeights(fp_, mesh.skin, mesh.source[v].posIndex);
+  }
+  BufferWrite(&mesh.depthVerts_[0], sizeof(unsigned int) * vertCount, 1, fp_);
+  BufferWrite(&mesh.depthIndices_[0], sizeof(int) * indexCount, 1, fp_);
+  EndSection(fp_, section);
+}
+void Scene::GenerateLods(void)
+{
+  if(meshes_.empty() || options_.lodRatios_.empty())
+    return;
+
+  printf("Generating levels of detail.\n");
+  FbxMesh& mesh = meshes_[0];
+  unsigned int vertCount = mesh.verts_.size();
+  if(!vertCount)
+    return;
+
+  //Vertices split off the same control point share a position
+  std::vector<unsigned> weldIds;
+  WeldVertices(mesh, weldIds);
+
+  //Keep vertices driven by different bones from collapsing into each other
+  std::vector<unsigned> skinKeys;
+  if(type_ == Skinned)
+  {
+    skinKeys.resize(vertCount);
+    for(unsigned int i = 0; i < vertCount; ++i)
+    {
+      const JointWeight *weights = mesh.skin.Weights(mesh.source[i].posIndex);
+      unsigned int dominant = 0;
+      for(unsigned int w = 1; w < maxWeights_; ++w)
+        if(weights[w].weight > weights[dominant].weight)
+          dominant = w;
+      skinKeys[i] = weights[dominant].index;
+    }
+  }
+
+  //Carried from level to level so every level's error is against the full mesh
+  std::vector<float> moved(vertCount, 0.0f);
+
+  //Each material of each sub mesh is simplified on its own so every range stays intact
+  std::vector<unsigned int> cuts;
+  IndexCuts(mesh, cuts);
+  unsigned int pieceCount = cuts.empty() ? 0 : cuts.size() - 1;
+
+  //Where every piece's triangles are in the level before
+  std::vector<unsigned int> pieceStarts, pieceCounts;
+
+  for(unsigned int l = 0; l < options_.lodRatios_.size(); ++l)
+  {
+    LodLevel level;
+    level.ratio_ = options_.lodRatios_[l];
+    level.error_ = 0.0f;
+
+    std::vector<unsigned int> starts(pieceCount, 0), counts(pieceCount, 0);
+    for(unsigned int s = 0; s < mesh.subMeshes_.size(); ++s)
+    {
+      SubMesh& sub = mesh.subMeshes_[s];
+      level.subMeshStarts_.push_back(level.indices_.size());
+
+      for(unsigned int c = 0; c < pieceCount; ++c)
+      {
+        if(cuts[c] < sub.indexStart_ || cuts[c + 1] > sub.indexStart_ + sub.indexCount_)
+          continue;
+        starts[c] = level.indices_.size();
+
+        //Each level starts from the one before it
+        const int *source = &mesh.indices_[cuts[c]];
+        unsigned int sourceCount = cuts[c + 1] - cuts[c];
+        if(l > 0)
+        {
+          sourceCount = pieceCounts[c];
+          source = sourceCount ? &mesh.lods_[l - 1].indices_[pieceStarts[c]] : NULL;
+        }
+        if(!sourceCount)
+          continue;
+
+        std::vector<int> local(source, source + sourceCount);
+        for(unsigned int i = 0; i < sourceCount; ++i)
+          local[i] -= sub.vertStart_;
+
+        SimplifyInput input;
+        input.positions_ = &mesh.verts_.pos_[sub.vertStart_];
+        input.normals_ = &mesh.verts_.nrm_[sub.vertStart_];
+        input.uvs_ = &mesh.verts_.uv_[sub.vertStart_];
+        input.weldIds_ = &weldIds[sub.vertStart_];
+        input.skinKeys_ = skinKeys.empty() ? NULL : &skinKeys[sub.vertStart_];
+        input.moved_ = &moved[sub.vertStart_];
+        input.vertCount_ = sub.vertCount_;
+
+        unsigned int target = static_cast<unsigned int>((cuts[c + 1] - cuts[c]) * level.ratio_) / 3 * 3;
+        std::vector<int> simplified(sourceCount);
+        float error;
+        unsigned int count = SimplifyMesh(input, &local[0], sourceCount, target, &simplified[0], error);
+
+        for(unsigned int i = 0; i < count; ++i)
+          level.indices_.push_back(simplified[i] + sub.vertStart_);
+        counts[c] = count;
+
+        if(error > level.error_)
+          level.error_ = error;
+      }
+      level.subMeshCounts_.push_back(level.indices_.size() - level.subMeshStarts_.back());
+    }
+
+    //The mesh's material ranges, moved onto this level's indices
+    for(unsigned int r = 0; r < mesh.materialRanges_.size(); ++r)
+    {
+      const MaterialRange& full = mesh.materialRanges_[r];
+      MaterialRange range = {full.material_, 0, 0};
+      bool first = true;
+      for(unsigned int c = 0; c < pieceCount; ++c)
+      {
+        if(cuts[c] < full.indexStart_ || cuts[c + 1] > full.indexStart_ + full.indexCount_)
+          continue;
+        if(first)
+          range.indexStart_ = starts[c];
+        range.indexCount_ += counts[c];
+        first = false;
+      }
+      level.materialRanges_.push_back(range);
+    }
+    pieceStarts.swap(starts);
+    pieceCounts.swap(counts);
+
+    printf("LOD %d: %d triangles (ratio %.3f), error %f\n", l + 1, level.indices_.size() / 3, level.ratio_, level.error_);
+    mesh.lods_.push_back(level);
+  }
+}
+void Scene::WriteLods(FbxMesh& mesh)
+{
+  if(mesh.lods_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionLods);
+  unsigned int levelCount = mesh.lods_.size();
+  BufferWrite(&levelCount, sizeof(unsigned int), 1, fp_);
+  for(unsigned int l = 0; l < levelCount; ++l)
+  {
+    LodLevel& level = mesh.lods_[l];
+    unsigned int indexCount = level.indices_.size();
+    unsigned int subCount = level.subMeshStarts_.size();
+
+    BufferWrite(&level.ratio_, sizeof(float), 1, fp_);
+    BufferWrite(&level.error_, sizeof(float), 1, fp_);
+    BufferWrite(&indexCount, sizeof(unsigned int), 1, fp_);
+    BufferWrite(&subCount, sizeof(unsigned int), 1, fp_);
+    for(unsigned int s = 0; s < subCount; ++s)
+    {
+      BufferWrite(&level.subMeshStarts_[s], sizeof(unsigned int), 1, fp_);
+      BufferWrite(&level.subMeshCounts_[s], sizeof(unsigned int), 1, fp_);
+    }
+    unsigned int rangeCount = level.materialRanges_.size();
+    BufferWrite(&rangeCount, sizeof(unsigned int), 1, fp_);
+    if(rangeCount)
+      BufferWrite(&level.materialRanges_[0], sizeof(MaterialRange) * rangeCount, 1, fp_);
+    if(indexCount)
+      BufferWrite(&level.indices_[0], sizeof(int) * indexCount, 1, fp_);
+  }
+  EndSection(fp_, section);
+}
+void Scene::GenerateMeshlets(void)
+{
+  if(meshes_.empty())
+    return;
+
+  printf("Building meshlets.\n");
+  FbxMesh& mesh = meshes_[0];
+  if(mesh.verts_.empty())
+    return;
+
+  //Clusters never span sub meshes or materials
+  std::vector<unsigned int> cuts;
+  IndexCuts(mesh, cuts);
+  unsigned int pieceCount = cuts.empty() ? 0 : cuts.size() - 1;
+  std::vector<unsigned int> firstMeshlets(pieceCount + 1, 0);
+  for(unsigned int c = 0; c < pieceCount; ++c)
+  {
+    firstMeshlets[c] = mesh.meshlets_.meshlets_.size();
+    BuildMeshlets(&mesh.verts_.pos_[0], mesh.verts_.size(), &mesh.indices_[cuts[c]], cuts[c + 1] - cuts[c], mesh.meshlets_);
+  }
+  firstMeshlets[pieceCount] = mesh.meshlets_.meshlets_.size();
+
+  //A range's first cut is where its clusters start, its end cut where the next ones do
+  for(unsigned int s = 0; s < mesh.subMeshes_.size(); ++s)
+  {
+    unsigned int c = std::lower_bound(cuts.begin(), cuts.end(), mesh.subMeshes_[s].indexStart_) - cuts.begin();
+    mesh.subMeshMeshlets_.push_back(firstMeshlets[std::min(c, pieceCount)]);
+  }
+  for(unsigned int r = 0; r < mesh.materialRanges_.size(); ++r)
+  {
+    const MaterialRange& range = mesh.materialRanges_[r];
+    unsigned int begin = std::lower_bound(cuts.begin(), cuts.end(), range.indexStart_) - cuts.begin();
+    unsigned int end = std::lower_bound(cuts.begin(), cuts.end(), range.indexStart_ + range.indexCount_) - cuts.begin();
+    begin = std::min(begin, pieceCount);
+    end = std::min(end, pieceCount);
+    MaterialRange clusters = {range.material_, firstMeshlets[begin], firstMeshlets[end] - firstMeshlets[begin]};
+    mesh.materialMeshlets_.push_back(clusters);
+  }
+
+  printf("Made %d meshlets.\n", mesh.meshlets_.meshlets_.size());
+}
+void Scene::WriteMeshlets(FbxMesh& mesh)
+{
+  MeshletData& data = mesh.meshlets_;
+  if(data.meshlets_.empty())
+    return;
+
+  long section = BeginSection(fp_, GmfSectionMeshlets);
+  unsigned int meshletCount = data.meshlets_.size();
+  unsigned int vertCount = data.verts_.size();
+  unsigned int triCount = data.tris_.size() / 3;
+  unsigned int subCount = mesh.subMeshMeshlets_.size();
+  BufferWrite(&meshletCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&vertCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&triCount, sizeof(unsigned int), 1, fp_);
+  BufferWrite(&subCount, sizeof(unsigned int), 1, fp_);
+  for(unsigned int s = 0; s < subCount; ++s)
+  {
+    unsigned int end = s + 1 < subCount ? mesh.subMeshMeshlets_[s + 1] : meshletCount;
+    unsigned int count = end - mesh.subMeshMeshlets_[s];
+    BufferWrite(&mesh.subMeshMeshlets_[s], sizeof(unsigned int), 1, fp_);
+    BufferWrite(&count, sizeof(unsigned int), 1, fp_);
+  }
+  unsigned int rangeCount = mesh.materialMeshlets_.size();
+  BufferWrite(&rangeCount, sizeof(unsigned int), 1, fp_);
+  if(rangeCount)
+    BufferWrite(&mesh.materialMeshlets_[0], sizeof(MaterialRange) * rangeCount, 1, fp_);
+  BufferWrite(&data.meshlets_[0], sizeof(Meshlet) * meshletCount, 1, fp_);
+  BufferWrite(&data.verts_[0], sizeof(unsigned int) * vertCount, 1, fp_);
+  BufferWrite(&data.tris_[0], sizeof(unsigned char) * 3 * triCount, 1, fp_);
+  EndSection(fp_, section);
+}
+KFbxVector4 Scene::Transform(const KFbxXMatrix& pXMatrix, const KFbxVector4& point)
+{
+  KFbxMatrix * m = (KFbxMatrix*)&pXMatrix;
+  return m->MultNormalize( point );
+}
+void Scene::CollectBones(KFbxNode* pRootNode)
+{
+    printf("Collecting Bones from the scene...\n");
+
+    //Get the queue of bones set up
+    int bIndex = -1;
+    std::queue<FbxParent> boneQ;
+    boneQ.push(FbxParent(bIndex, pRootNode));
+
+    //Extract relevant data from each bone into our structures
+    //Then get its children into the queue
+    while(!boneQ.empty())
+    {
+      //Grab the top bone
+      FbxParent curNode = boneQ.front();
+      boneQ.pop();
+
+      //Get the attributes off the node if it's valid
+      if(GetNodeAttributeType(curNode.node_) == KFbxNodeAttribute::eSKELETON)
+      {
+        //Fill in a bone and add it to our list of bones
+        FbxBone bone;
+        bone.bone_ = curNode.node_->GetSkeleton();
+        bone.name_ = bone.bone_->GetName();
+        printf("Collecting bone: %s\n", bone.name_.c_str());
+        bone.pIndex_ = curNode.parent_;
+        bIndex = bones_.size();
+        bone.index_ = bIndex;
+        bones_.push_back(bone);
+      }
+
+      //Push all the children bones onto the queue
+      int childCount =  curNode.node_->GetChildCount();
+      for(int i = 0; i < childCount; ++i)
+        boneQ.push(FbxParent(bIndex, curNode.node_->GetChild(i)));
+    }
+
+    printf("Done...\n");
 }
   void Scene::GetKeyFrames(FbxBone &bone, const char *takeName, std::set<KTime> &keyTimes, int animlayer)
   {
@@ -992,9 +3591,11 @@ void Scene::CollectAnimations(void)
 
       //Fill in the blank animations
       anims_.back().length_ = static_cast<float>(duration.GetSecondDouble());
+      anims_.back().start_ = start;
       anims_.back().name_ = takes_[i]->Buffer();
 
-      int boneCount = bones_.size();
+      //Static scenes only get their morph curves
+      int boneCount = extractSkeletonData_ ? bones_.size() : 0;
       for(int j = 0; j < boneCount; ++j)
       {
         std::set<KTime> keyTimes;
@@ -1024,9 +3625,11 @@ void Scene::CollectAnimations(void)
 
           //Finally give the new transformation matrix to the animations.
           anims_.back().frames_.back().push_back(lTrans);
-          anims_.back().frames_.back().back().time_ = it->GetSecondDouble();
+          anims_.back().frames_.back().back().time_ = static_cast<float>((*it - start).GetSecondDouble());
         }
       }
+
+      CollectMorphCurves(anims_.back(), takes_[i]->Buffer());
     }
     printf("Done getting the animations.\n");
   }
@@ -1073,9 +3676,25 @@ void Scene::ExtractMesh(KFbxNode *pNode)
       {
         case KFbxNodeAttribute::eMESH:
         {
-          meshes_.push_back(pNode->GetMesh());
+          KFbxMesh *mesh = pNode->GetMesh();
+
+          //Another node already uses this mesh, just place it again
+          if(options_.instanceMeshes_)
+          {
+            int shared = FindMesh(mesh);
+            if(shared != -1)
+            {
+              AddInstance(shared, pNode);
+              break;
+            }
+          }
+
+          meshes_.push_back(FbxMesh(mesh, pNode));
           meshes_.back().name_ = name;
           meshes_.back().meshType = type_;
+
+          if(options_.instanceMeshes_)
+            AddInstance(meshes_.size() - 1, pNode);
           break;
         }
       }
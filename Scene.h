@@ -9,15 +9,22 @@
 #pragma once
 #include <fbxsdk.h>
 #include "DataStructures.h"
+#include "Options.h"
+#include "OutputBuffer.h"
+#include "StageTimer.h"
+#include <list>
 
 class Converter;
 
 class Scene
 {
   public:
-    Scene(const char* filename);
+    Scene(const char* filename, const ConvertOptions& options = ConvertOptions());
+    ~Scene(void);
+    void SetOutputName(const char* name);
     bool LoadScene(void);
     bool ExtractScene(void);
+    bool ExtractSceneData(void);
     void SaveScene(void);
     void PrintScene(KFbxNode* pRootNode);
     void CollectMeshes(KFbxNode* pRootNode);
@@ -30,6 +37,7 @@ class Scene
     void ExtractMesh(KFbxNode *pNode);
     void GenerateTriangleIndices(FbxMesh& mesh);
     void GrabSkinWeights(FbxMesh& mesh);
+    void FillBindPose(void);
     int FindBone(KFbxNode *node);
     void GenerateVertices(FbxMesh& mesh);
 
@@ -38,28 +46,87 @@ class Scene
     void PrintAttribute(KFbxNodeAttribute* pAttribute);
     void PrintTabs(void);
     void CombineMeshes(void);
+    void IndexCuts(FbxMesh& mesh, std::vector<unsigned int>& cuts);
+    void CleanMesh(void);
+    void ComputeBounds(void);
+    void ComputeBoneBounds(FbxMesh& mesh);
+    void CollectAnimatedBounds(void);
+    void WriteBounds(FbxMesh& mesh);
+    void GenerateBvh(void);
+    void WriteBvh(FbxMesh& mesh);
+    void GenerateOcclusion(void);
+    void WriteOcclusion(FbxMesh& mesh);
+    void GenerateOccluders(void);
+    void WriteOccluders(FbxMesh& mesh);
+    void GenerateCollision(void);
+    void WriteCollision(FbxMesh& mesh);
+    unsigned int WeldVertices(FbxMesh& mesh, std::vector<unsigned>& weldIds);
+    void GenerateEdges(void);
+    void WriteEdges(FbxMesh& mesh);
+    void GenerateDepthStream(void);
+    void WriteDepthStream(FbxMesh& mesh);
+    void GenerateLods(void);
+    void WriteLods(FbxMesh& mesh);
+    void GenerateMeshlets(void);
+    void WriteMeshlets(FbxMesh& mesh);
+    KFbxXMatrix GetNodeWorldMatrix(KFbxNode *node);
+    KFbxXMatrix GetGeometricMatrix(KFbxNode *node);
+    int FindMesh(KFbxMesh *mesh);
+    void AddInstance(unsigned int meshIndex, KFbxNode *node);
+    void DeduplicateMeshes(void);
+    void WriteInstances(void);
+    void PartitionScene(void);
+    void SaveCells(void);
+    void GetMorphTargets(FbxMesh& mesh, KFbxXMatrix& transform);
+    int GetMaterial(KFbxSurfaceMaterial *material);
+    std::string FindTexture(KFbxSurfaceMaterial *material, const char *property);
+    void GetMaterials(FbxMesh& inmesh);
+    void SaveTextures(void);
+    void WriteMaterials(FbxMesh& mesh);
+    void CollectMorphCurves(FbxAnimation& anim, const char *takeName);
+    void WriteMorphs(FbxMesh& mesh);
+    unsigned long long HashSkeleton(void);
+    OutputFile* SaveSkeleton(void);
+    void WriteSkeletonRef(void);
+    unsigned int EmbeddedAnimCount(void);
+    void SaveClips(void);
+    void PruneBones(void);
+    void GenerateSkeletonLods(void);
+    void WriteSkeletonLods(FbxMesh& mesh);
+    void SampleBoneTransforms(void);
+    void SaveSnapshot(void);
+    bool LoadSnapshot(void);
+    OutputFile* AddOutput(const std::string& name);
+    void TakeOutputs(std::vector<OutputFile>& outputs);
+    void RunStage(const char *name, void (Scene::*stage)(void));
+    void TakeTimings(std::vector<StageTime>& timings);
     KString GetAttributeTypeName(KFbxNodeAttribute::EAttributeType type);
     KFbxNodeAttribute::EAttributeType GetNodeAttributeType(KFbxNode* pNode);
     void CollectKeyTimes(std::set<KTime> &keyTimes, KFbxTypedProperty<fbxDouble3> &attribute, const char *curveName, const char *takeName, KFbxAnimLayer* layer);
     int FindMatchingVertex(IndexedVert& v, FbxMesh& mesh);
-    bool IsMatchingVertex(FbxVert& vertex, IndexedVert& cur, IndexedVert& v);
+    bool IsMatchingVertex(IndexedVert& cur, IndexedVert& v);
     int AddNewVertex(IndexedVert v, FbxMesh& mesh);
     void ProcessBones(void);
     void GetKeyFrames(FbxBone &bone, const char *takeName, std::set<KTime> &keyTimes, int animlayer);
     void Triangulate(FbxMesh& mesh);
     void ConvertTriWinding(FbxMesh& mesh);
     void CalculateTansAndBitans(FbxMesh& mesh);
-    void CalcTriTanBinNorm(const KFbxVector4& P1, const KFbxVector4& P2, const KFbxVector4& P3, 
-                           const KFbxVector2& UV1, const KFbxVector2& UV2, const KFbxVector2& UV3,
-                           KFbxVector4 &tangent, KFbxVector4 &binormal);
-    void AvgTanBins(std::vector<Tri>& triangles, unsigned int numTris, std::vector<FbxVert>& verts, unsigned int numVerts);
+    void CalcTriTanBinNorm(const Float3& P1, const Float3& P2, const Float3& P3, 
+                           const Float2& UV1, const Float2& UV2, const Float2& UV3,
+                           Float3 &tangent, Float3 &binormal);
+    void AvgTanBins(std::vector<Tri>& triangles, unsigned int numTris, VertexStreams& verts, unsigned int numVerts);
     void TransformTansBitans(FbxMesh& mesh, KFbxXMatrix& transform);
     KFbxSdkManager* sdkManager_;
     KFbxScene* scene_;
     KFbxIOSettings* ios_;
     std::string filename_;
     std::string output_;
-    FILE *fp_;
+    //Output being written by the Write stages
+    OutputFile *fp_;
+    //Everything SaveScene made, nothing touches the disk until the caller saves them
+    std::list<OutputFile> outputs_;
+    //How long each stage ExtractScene ran took, in the order they ran
+    std::vector<StageTime> timings_;
     KFbxPose* pose_;
     KArrayTemplate<KString*> takes_;
     KFbxGeometryConverter* converter_;
@@ -72,9 +139,13 @@ class Scene
     bool bitans_;
 
     std::vector<FbxMesh> meshes_;
+    std::vector<Material> materials_;
+    std::vector<MeshInstance> instances_;
+    std::vector<GridCell> cells_;
     std::vector<FbxBone> bones_;
+    std::vector<SkeletonLod> skeletonLods_;
     std::vector<FbxAnimation> anims_;
-    std::vector<FbxVert> verts_;
+    VertexStreams verts_;
     std::vector<int> indices_;
     std::vector<SkinData> skins_;
 
@@ -85,6 +156,17 @@ class Scene
 
     ModelType type_;
 
+    //Set by SaveSkeleton when the bones live in a shared skeleton file
+    unsigned long long skeletonId_;
+    std::string skeletonFile_;
+
+    ConvertOptions options_;
+
+    //The scene came from a snapshot, there is no FBX scene to read from
+    bool fromSnapshot_;
+    //Where this input's snapshot lives, empty when there is no cache
+    std::string snapshotPath_;
+
     //For converting from FBX space to DX Space thanks to Chris Peters
     Converter* mtxConverter_;
 };
\ No newline at end of file
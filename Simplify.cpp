@@ -0,0 +1,322 @@
+////////////////////////////////////////////////////////
+//* Filename: Simplify.cpp                            //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Simplify.h"
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+//Symmetric 4x4 error matrix stored as its upper triangle
+struct Quadric
+{
+  double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+  double weight;
+};
+
+struct Collapse
+{
+  unsigned src_;
+  unsigned dst_;
+  float cost_;
+
+  bool operator<(const Collapse& rhs) const { return cost_ < rhs.cost_; }
+};
+
+struct SimplifyEdge
+{
+  unsigned long long key_;
+  unsigned count_;
+};
+
+static void ClearQuadric(Quadric& q)
+{
+  q.xx = q.xy = q.xz = q.xw = q.yy = q.yz = q.yw = q.zz = q.zw = q.ww = 0.0;
+  q.weight = 0.0;
+}
+
+static void AddQuadric(Quadric& q, const Quadric& other)
+{
+  q.xx += other.xx; q.xy += other.xy; q.xz += other.xz; q.xw += other.xw;
+  q.yy += other.yy; q.yz += other.yz; q.yw += other.yw;
+  q.zz += other.zz; q.zw += other.zw;
+  q.ww += other.ww;
+  q.weight += other.weight;
+}
+
+//Plane ax + by + cz + d = 0 weighted by the area of the triangle it came from
+static void AddPlane(Quadric& q, double a, double b, double c, double d, double w)
+{
+  q.xx += w * a * a; q.xy += w * a * b; q.xz += w * a * c; q.xw += w * a * d;
+  q.yy += w * b * b; q.yz += w * b * c; q.yw += w * b * d;
+  q.zz += w * c * c; q.zw += w * c * d;
+  q.ww += w * d * d;
+  q.weight += w;
+}
+
+//Area weighted mean squared distance of p to the planes in q
+static double EvaluateQuadric(const Quadric& q, const Float3& p)
+{
+  double x = p.x, y = p.y, z = p.z;
+  double e = q.xx * x * x + 2 * q.xy * x * y + 2 * q.xz * x * z + 2 * q.xw * x
+           + q.yy * y * y + 2 * q.yz * y * z + 2 * q.yw * y
+           + q.zz * z * z + 2 * q.zw * z
+           + q.ww;
+
+  if(q.weight <= 0.0)
+    return 0.0;
+  return std::fabs(e) / q.weight;
+}
+
+static unsigned long long EdgeKey(unsigned a, unsigned b)
+{
+  if(a > b)
+    std::swap(a, b);
+  return (static_cast<unsigned long long>(a) << 32) | b;
+}
+
+static Float3 TriangleNormal(const Float3& p0, const Float3& p1, const Float3& p2)
+{
+  return Cross(p1 - p0, p2 - p0);
+}
+
+unsigned SimplifyMesh(const SimplifyInput& input, const int* indices, unsigned indexCount,
+                      unsigned targetIndexCount, int* destination, float& error)
+{
+  const unsigned vertCount = input.vertCount_;
+  error = 0.0f;
+
+  std::copy(indices, indices + indexCount, destination);
+  if(indexCount <= targetIndexCount || !vertCount)
+  {
+    if(input.moved_)
+      for(unsigned i = 0; i < indexCount; ++i)
+        error = std::max(error, input.moved_[indices[i]]);
+    return indexCount;
+  }
+
+  //Find the first vertex of every weld group, that vertex stands in for the position
+  std::vector<unsigned> order(vertCount);
+  for(unsigned i = 0; i < vertCount; ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) { return input.weldIds_[a] < input.weldIds_[b]; });
+
+  std::vector<unsigned> weld(vertCount);
+  std::vector<unsigned> wedgeCount(vertCount, 0);
+  for(unsigned i = 0; i < vertCount; ++i)
+  {
+    unsigned v = order[i];
+    bool sameGroup = i > 0 && input.weldIds_[order[i - 1]] == input.weldIds_[v];
+    weld[v] = sameGroup ? weld[order[i - 1]] : v;
+    ++wedgeCount[weld[v]];
+  }
+
+  //Distance moved is kept per position, carried over from earlier calls
+  std::vector<float> moved(vertCount, 0.0f);
+  if(input.moved_)
+    for(unsigned i = 0; i < vertCount; ++i)
+      moved[weld[i]] = std::max(moved[weld[i]], input.moved_[i]);
+
+  //Classify edges, open borders and non-manifold edges lock their vertices
+  std::vector<SimplifyEdge> edges;
+  edges.reserve(indexCount);
+  for(unsigned i = 0; i < indexCount; i += 3)
+  {
+    for(unsigned k = 0; k < 3; ++k)
+    {
+      unsigned a = weld[indices[i + k]];
+      unsigned b = weld[indices[i + (k + 1) % 3]];
+      if(a == b)
+        continue;
+      SimplifyEdge edge = {EdgeKey(a, b), 1};
+      edges.push_back(edge);
+    }
+  }
+  std::sort(edges.begin(), edges.end(), [](const SimplifyEdge& a, const SimplifyEdge& b) { return a.key_ < b.key_; });
+
+  std::vector<bool> locked(vertCount, false);
+  for(unsigned i = 0; i < vertCount; ++i)
+    if(wedgeCount[weld[i]] > 1)
+      locked[weld[i]] = true;
+
+  for(unsigned i = 0; i < edges.size(); )
+  {
+    unsigned j = i;
+    while(j < edges.size() && edges[j].key_ == edges[i].key_)
+      ++j;
+
+    if(j - i != 2)
+    {
+      locked[static_cast<unsigned>(edges[i].key_ >> 32)] = true;
+      locked[static_cast<unsigned>(edges[i].key_ & 0xffffffff)] = true;
+    }
+    i = j;
+  }
+
+  //Accumulate the plane of every triangle into its corners
+  std::vector<Quadric> quadrics(vertCount);
+  for(unsigned i = 0; i < vertCount; ++i)
+    ClearQuadric(quadrics[i]);
+
+  for(unsigned i = 0; i < indexCount; i += 3)
+  {
+    const Float3& p0 = input.positions_[indices[i]];
+    const Float3& p1 = input.positions_[indices[i + 1]];
+    const Float3& p2 = input.positions_[indices[i + 2]];
+    Float3 n = TriangleNormal(p0, p1, p2);
+    float area = Length(n);
+    if(area <= 0.0f)
+      continue;
+
+    n /= area;
+    double d = -Dot(n, p0);
+    for(unsigned k = 0; k < 3; ++k)
+      AddPlane(quadrics[weld[indices[i + k]]], n.x, n.y, n.z, d, area * 0.5);
+  }
+
+  unsigned count = indexCount;
+  std::vector<Collapse> collapses;
+  std::vector<unsigned> triStart(vertCount + 1);
+  std::vector<unsigned> triList;
+  std::vector<unsigned> remap(vertCount);
+  std::vector<bool> touched(vertCount);
+
+  while(count > targetIndexCount)
+  {
+    //Triangles around every position
+    std::fill(triStart.begin(), triStart.end(), 0);
+    for(unsigned i = 0; i < count; ++i)
+      ++triStart[weld[destination[i]] + 1];
+    for(unsigned v = 0; v < vertCount; ++v)
+      triStart[v + 1] += triStart[v];
+
+    triList.resize(count);
+    std::vector<unsigned> fill(triStart.begin(), triStart.end() - 1);
+    for(unsigned i = 0; i < count; ++i)
+      triList[fill[weld[destination[i]]]++] = i / 3;
+
+    //Every edge out of an unlocked vertex is a candidate
+    collapses.clear();
+    for(unsigned i = 0; i < count; i += 3)
+    {
+      for(unsigned k = 0; k < 3; ++k)
+      {
+        unsigned a = destination[i + k];
+        unsigned b = destination[i + (k + 1) % 3];
+        for(int dir = 0; dir < 2; ++dir, std::swap(a, b))
+        {
+          if(locked[weld[a]] || weld[a] == weld[b])
+            continue;
+          if(input.skinKeys_ && input.skinKeys_[a] != input.skinKeys_[b])
+            continue;
+
+          Quadric q = quadrics[weld[a]];
+          AddQuadric(q, quadrics[weld[b]]);
+
+          //Moving a onto b also swaps a's attributes for b's, charge for that by the edge length
+          Float3 edge = input.positions_[b] - input.positions_[a];
+          Float2 duv = input.uvs_[b] - input.uvs_[a];
+          double attribute = (1.0 - Dot(input.normals_[a], input.normals_[b])) * 0.5 + duv.x * duv.x + duv.y * duv.y;
+
+          Collapse c = {a, b, static_cast<float>(EvaluateQuadric(q, input.positions_[b]) + attribute * Dot(edge, edge))};
+          collapses.push_back(c);
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end());
+
+    //Each collapse removes about two triangles
+    unsigned limit = (count - targetIndexCount) / 6 + 1;
+    unsigned done = 0;
+
+    for(unsigned v = 0; v < vertCount; ++v)
+      remap[v] = v;
+    std::fill(touched.begin(), touched.end(), false);
+
+    for(unsigned c = 0; c < collapses.size() && done < limit; ++c)
+    {
+      unsigned src = collapses[c].src_;
+      unsigned dst = collapses[c].dst_;
+      unsigned ws = weld[src];
+      unsigned wd = weld[dst];
+      if(touched[ws] || touched[wd])
+        continue;
+
+      const Float3& target = input.positions_[dst];
+      bool valid = true;
+
+      for(unsigned t = triStart[ws]; t < triStart[ws + 1] && valid; ++t)
+      {
+        const int* tri = &destination[triList[t] * 3];
+        bool hasDst = weld[tri[0]] == wd || weld[tri[1]] == wd || weld[tri[2]] == wd;
+
+        //Triangles on the edge go away, they must all agree on which copy of dst they use
+        if(hasDst)
+        {
+          for(unsigned k = 0; k < 3; ++k)
+            if(weld[tri[k]] == wd && static_cast<unsigned>(tri[k]) != dst)
+              valid = false;
+          continue;
+        }
+
+        //The rest move, make sure none of them turn over
+        Float3 before[3], after[3];
+        for(unsigned k = 0; k < 3; ++k)
+        {
+          before[k] = input.positions_[tri[k]];
+          after[k] = weld[tri[k]] == ws ? target : before[k];
+        }
+
+        Float3 n0 = TriangleNormal(before[0], before[1], before[2]);
+        Float3 n1 = TriangleNormal(after[0], after[1], after[2]);
+        if(Dot(n0, n1) <= 0.0f)
+          valid = false;
+      }
+
+      if(!valid)
+        continue;
+
+      remap[src] = dst;
+      AddQuadric(quadrics[wd], quadrics[ws]);
+      //Sliding along the surface costs nothing, only moving off it does
+      float offSurface = std::fabs(Dot(input.normals_[src], target - input.positions_[src]));
+      moved[wd] = std::max(moved[wd], moved[ws] + offSurface);
+      ++done;
+
+      //Anything sharing a triangle with the moved vertex has to wait for the next pass
+      for(unsigned t = triStart[ws]; t < triStart[ws + 1]; ++t)
+        for(unsigned k = 0; k < 3; ++k)
+          touched[weld[destination[triList[t] * 3 + k]]] = true;
+    }
+
+    if(!done)
+      break;
+
+    //Apply the collapses and drop the triangles that became degenerate
+    unsigned write = 0;
+    for(unsigned i = 0; i < count; i += 3)
+    {
+      unsigned a = remap[destination[i]];
+      unsigned b = remap[destination[i + 1]];
+      unsigned c = remap[destination[i + 2]];
+      if(weld[a] == weld[b] || weld[b] == weld[c] || weld[c] == weld[a])
+        continue;
+
+      destination[write++] = a;
+      destination[write++] = b;
+      destination[write++] = c;
+    }
+    count = write;
+  }
+
+  for(unsigned i = 0; i < count; ++i)
+    error = std::max(error, moved[weld[destination[i]]]);
+  if(input.moved_)
+    for(unsigned i = 0; i < vertCount; ++i)
+      input.moved_[i] = moved[weld[i]];
+  return count;
+}
@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////
+//* Filename: Simplify.h                              //
+//  Author: Colt Johnson                              //
+//  Info: Quadric error edge collapse simplification  //
+//        of welded triangle lists.                   //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include "MathTypes.h"
+
+  //Vertex data for one range of vertices. Indices passed to SimplifyMesh are
+  //relative to the start of these arrays.
+  struct SimplifyInput
+  {
+    const Float3* positions_;
+    const Float3* normals_;
+    const Float2* uvs_;
+
+    //Vertices with the same weld id share a position (they were split on a
+    //normal or uv seam). Seam vertices are never moved.
+    const unsigned* weldIds_;
+
+    //Optional, collapses only happen between vertices with the same key. Used
+    //to keep vertices bound to different bones apart.
+    const unsigned* skinKeys_;
+
+    //Optional, how far the original surface merged into each vertex has moved
+    //off itself, along its normals. Read and updated, so simplifying a result
+    //again still measures against the original mesh.
+    float* moved_;
+
+    unsigned vertCount_;
+  };
+
+  //Collapses edges until at most targetIndexCount indices are left or nothing
+  //more can be collapsed without breaking a seam, border or flipping a face.
+  //Collapses always move a vertex onto one of its neighbours so no new vertices
+  //are made. Writes the result to destination (which needs indexCount room),
+  //returns its index count and sets error to the furthest the original surface
+  //around any vertex left has moved off itself, in world units. Collapses are
+  //summed, so it errs high, and what the attributes cost is left out.
+  unsigned SimplifyMesh(const SimplifyInput& input, const int* indices, unsigned indexCount,
+                        unsigned targetIndexCount, int* destination, float& error);
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////
+//* Filename: Snapshot.cpp                            //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Snapshot.h"
+#include "Hash.h"
+
+#ifdef _WIN32
+  #define NOMINMAX
+  #define WIN32_LEAN_AND_MEAN
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(void) : data_(NULL), size_(0), file_(INVALID_HANDLE_VALUE), mapping_(NULL)
+{
+}
+
+bool MappedFile::Open(const char *path)
+{
+  Close();
+
+  file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(file_ == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if(!GetFileSizeEx(file_, &size) || !size.QuadPart)
+  {
+    Close();
+    return false;
+  }
+
+  mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(!mapping_)
+  {
+    Close();
+    return false;
+  }
+
+  data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if(!data_)
+  {
+    Close();
+    return false;
+  }
+
+  size_ = static_cast<size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::Close(void)
+{
+  if(data_)
+    UnmapViewOfFile(data_);
+  if(mapping_)
+    CloseHandle(mapping_);
+  if(file_ != INVALID_HANDLE_VALUE)
+    CloseHandle(file_);
+
+  data_ = NULL;
+  size_ = 0;
+  mapping_ = NULL;
+  file_ = INVALID_HANDLE_VALUE;
+}
+#else
+MappedFile::MappedFile(void) : data_(NULL), size_(0), file_(-1)
+{
+}
+
+bool MappedFile::Open(const char *path)
+{
+  Close();
+
+  file_ = open(path, O_RDONLY);
+  if(file_ < 0)
+    return false;
+
+  struct stat info;
+  if(fstat(file_, &info) || !info.st_size)
+  {
+    Close();
+    return false;
+  }
+
+  void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file_, 0);
+  if(data == MAP_FAILED)
+  {
+    Close();
+    return false;
+  }
+
+  data_ = static_cast<const char*>(data);
+  size_ = info.st_size;
+  return true;
+}
+
+void MappedFile::Close(void)
+{
+  if(data_)
+    munmap(const_cast<char*>(data_), size_);
+  if(file_ >= 0)
+    close(file_);
+
+  data_ = NULL;
+  size_ = 0;
+  file_ = -1;
+}
+#endif
+
+MappedFile::~MappedFile(void)
+{
+  Close();
+}
+
+bool HashFile(const char *path, unsigned long long& hash)
+{
+  FILE *fp = fopen(path, "rb");
+  if(!fp)
+    return false;
+
+  std::vector<char> buffer(1 << 20);
+  hash = HashSeed;
+  size_t read;
+  while((read = fread(&buffer[0], 1, buffer.size(), fp)) > 0)
+    hash = HashBytes(&buffer[0], read, hash);
+
+  fclose(fp);
+  return true;
+}
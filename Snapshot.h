@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////
+//* Filename: Snapshot.h                              //
+//  Author: Colt Johnson                              //
+//  Info: Binary cache of the imported scene so later //
+//        runs can skip the FBX SDK import.           //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+  //Read only view of a whole file, memory mapped so nothing is copied up front
+  class MappedFile
+  {
+    public:
+      MappedFile(void);
+      ~MappedFile(void);
+
+      bool Open(const char *path);
+      void Close(void);
+
+      const char* Data(void) const { return data_; }
+      size_t Size(void) const { return size_; }
+
+    private:
+      MappedFile(const MappedFile&);
+      MappedFile& operator=(const MappedFile&);
+
+      const char *data_;
+      size_t size_;
+#ifdef _WIN32
+      //File and mapping HANDLEs, kept as void* so Windows.h stays out of the header
+      void *file_;
+      void *mapping_;
+#else
+      int file_;
+#endif
+  };
+
+  //FNV-1a over the file's contents, returns false if it can't be read
+  bool HashFile(const char *path, unsigned long long& hash);
+
+  //Arrays are padded to 8 bytes so the reader can use them in place
+  struct SnapshotWriter
+  {
+    FILE *fp_;
+
+    void Pad(void)
+    {
+      static const char zeros[8] = {0};
+      long pos = ftell(fp_);
+      if(pos % 8)
+        fwrite(zeros, 8 - pos % 8, 1, fp_);
+    }
+
+    template<typename type>
+    void Write(const type& value)
+    {
+      fwrite(&value, sizeof(type), 1, fp_);
+    }
+
+    void WriteString(const std::string& text)
+    {
+      unsigned size = text.size();
+      Write(size);
+      fwrite(text.c_str(), size, 1, fp_);
+    }
+
+    //Only for types that can be copied byte for byte
+    template<typename type>
+    void WriteVector(const std::vector<type>& values)
+    {
+      unsigned count = values.size();
+      Write(count);
+      Pad();
+      if(count)
+        fwrite(&values[0], sizeof(type) * count, 1, fp_);
+    }
+  };
+
+  //Walks a mapped snapshot. Any read past the end clears ok_ and reads zeros.
+  struct SnapshotReader
+  {
+    const char *start_;
+    const char *cur_;
+    const char *end_;
+    bool ok_;
+
+    bool Has(size_t size)
+    {
+      if(ok_ && static_cast<size_t>(end_ - cur_) >= size)
+        return true;
+      ok_ = false;
+      return false;
+    }
+
+    void Pad(void)
+    {
+      size_t pos = cur_ - start_;
+      if(pos % 8 && Has(8 - pos % 8))
+        cur_ += 8 - pos % 8;
+    }
+
+    template<typename type>
+    void Read(type& value)
+    {
+      if(Has(sizeof(type)))
+      {
+        memcpy(&value, cur_, sizeof(type));
+        cur_ += sizeof(type);
+      }
+      else
+        memset(&value, 0, sizeof(type));
+    }
+
+    void Skip(size_t size)
+    {
+      if(Has(size))
+        cur_ += size;
+    }
+
+    void ReadString(std::string& text)
+    {
+      unsigned size = 0;
+      Read(size);
+      if(Has(size))
+      {
+        text.assign(cur_, size);
+        cur_ += size;
+      }
+    }
+
+    template<typename type>
+    void ReadVector(std::vector<type>& values)
+    {
+      unsigned count = 0;
+      Read(count);
+      Pad();
+      values.clear();
+      if(count && Has(sizeof(type) * count))
+      {
+        const type *first = reinterpret_cast<const type*>(cur_);
+        values.assign(first, first + count);
+        cur_ += sizeof(type) * count;
+      }
+    }
+  };
@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////
+//* Filename: StageTimer.h                            //
+//  Author: Colt Johnson                              //
+//  Info: Wall clock time of each conversion stage,   //
+//        for the benchmark harness.                  //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+  struct StageTime
+  {
+    std::string name_;
+    double ms_;
+  };
+
+  //Adds the time between construction and destruction to times as name
+  class StageTimer
+  {
+    public:
+      StageTimer(std::vector<StageTime>& times, const char *name)
+        : times_(times), name_(name), start_(std::chrono::high_resolution_clock::now()) {}
+
+      ~StageTimer(void)
+      {
+        std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+        StageTime time;
+        time.name_ = name_;
+        time.ms_ = std::chrono::duration<double, std::milli>(end - start_).count();
+        times_.push_back(time);
+      }
+
+    private:
+      StageTimer(const StageTimer&);
+      StageTimer& operator=(const StageTimer&);
+
+      std::vector<StageTime>& times_;
+      const char *name_;
+      std::chrono::high_resolution_clock::time_point start_;
+  };
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////
+//* Filename: Texture.cpp                             //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Texture.h"
+#include <algorithm>
+#include <cstdio>
+
+#define DDS_FOURCC(a, b, c, d) ((unsigned)(a) | ((unsigned)(b) << 8) | ((unsigned)(c) << 16) | ((unsigned)(d) << 24))
+
+//DDS_HEADER flags and caps for a mipmapped compressed 2D texture
+const unsigned DdsMagic        = DDS_FOURCC('D','D','S',' ');
+const unsigned DdsHeaderSize   = 124;
+const unsigned DdsFormatSize   = 32;
+const unsigned DdsFlags        = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+const unsigned DdsFormatFourCC = 0x4;
+const unsigned DdsCaps         = 0x8 | 0x1000 | 0x400000;
+
+//The pre DX10 codes every loader knows, ATI2 is BC5
+static unsigned FourCC(BlockFormat format)
+{
+  switch(format)
+  {
+    case BlockBC1: return DDS_FOURCC('D','X','T','1');
+    case BlockBC3: return DDS_FOURCC('D','X','T','5');
+    default:       return DDS_FOURCC('A','T','I','2');
+  }
+}
+
+static void WriteDdsHeader(OutputFile& out, unsigned width, unsigned height, unsigned mipCount, BlockFormat format)
+{
+  unsigned header[32] = {0};
+  header[0] = DdsMagic;
+  header[1] = DdsHeaderSize;
+  header[2] = DdsFlags;
+  header[3] = height;
+  header[4] = width;
+  header[5] = CompressedSize(width, height, format);
+  header[7] = mipCount;
+
+  //Pixel format, after 11 reserved words
+  header[19] = DdsFormatSize;
+  header[20] = DdsFormatFourCC;
+  header[21] = FourCC(format);
+
+  header[27] = DdsCaps;
+  BufferWrite(header, sizeof(header), 1, &out);
+}
+
+BlockFormat ChooseBlockFormat(const Image& image, bool normalMap)
+{
+  if(normalMap)
+    return BlockBC5;
+  return HasAlpha(image) ? BlockBC3 : BlockBC1;
+}
+
+bool ConvertTexture(const char *source, bool normalMap, OutputFile& out, unsigned threadCount)
+{
+  Image level;
+  if(!ReadImage(source, level))
+    return false;
+
+  BlockFormat format = ChooseBlockFormat(level, normalMap);
+
+  unsigned mipCount = 1;
+  for(unsigned size = std::max(level.width_, level.height_); size > 1; size /= 2)
+    ++mipCount;
+
+  WriteDdsHeader(out, level.width_, level.height_, mipCount, format);
+
+  //Levels go straight into the output, largest first
+  for(unsigned m = 0; m < mipCount; ++m)
+  {
+    size_t start = out.data_.size();
+    out.data_.resize(start + CompressedSize(level.width_, level.height_, format));
+    CompressImage(level, format, reinterpret_cast<unsigned char*>(&out.data_[start]), threadCount);
+
+    if(m + 1 < mipCount)
+    {
+      Image next;
+      Downsample(level, next, normalMap);
+      level.width_ = next.width_;
+      level.height_ = next.height_;
+      level.rgba_.swap(next.rgba_);
+    }
+  }
+
+  static const char *formatNames[] = {"BC1", "BC3", "BC5"};
+  printf("Compressed %s to %s with %d mips.\n", source, formatNames[format], mipCount);
+  return true;
+}
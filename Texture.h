@@ -0,0 +1,20 @@
+////////////////////////////////////////////////////////
+//* Filename: Texture.h                               //
+//  Author: Colt Johnson                              //
+//  Info: Turns source images into mipmapped, block   //
+//        compressed DDS files.                       //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include "BlockCompress.h"
+#include "OutputBuffer.h"
+
+  //Normal maps go to BC5 (the engine rebuilds z), colors with alpha to BC3 and
+  //everything else to BC1
+  BlockFormat ChooseBlockFormat(const Image& image, bool normalMap);
+
+  //Decodes source, builds every mip level down to 1x1 and writes them block
+  //compressed into out as a DDS. Returns false if the image couldn't be read.
+  bool ConvertTexture(const char *source, bool normalMap, OutputFile& out, unsigned threadCount = 0);
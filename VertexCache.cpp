@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////
+//* Filename: VertexCache.cpp                         //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "VertexCache.h"
+#include <cmath>
+#include <vector>
+
+//Scoring constants from "Linear-Speed Vertex Cache Optimisation"
+const float CacheDecayPower = 1.5f;
+const float LastTriScore = 0.75f;
+const float ValenceBoostScale = 2.0f;
+const float ValenceBoostPower = 0.5f;
+
+//Vertices the last triangle used are scored flat, it isn't known which of them goes first
+static float VertexScore(int cachePosition, unsigned remaining)
+{
+  if(!remaining)
+    return -1.0f;
+
+  float score = 0.0f;
+  if(cachePosition >= 0)
+  {
+    if(cachePosition < 3)
+      score = LastTriScore;
+    else
+    {
+      float scaler = 1.0f / (VertexCacheSize - 3);
+      score = std::pow(1.0f - (cachePosition - 3) * scaler, CacheDecayPower);
+    }
+  }
+
+  //Vertices with few triangles left are worth finishing off
+  return score + ValenceBoostScale * std::pow(static_cast<float>(remaining), -ValenceBoostPower);
+}
+
+void OptimizeVertexCache(const int* indices, unsigned indexCount, unsigned vertCount, int* destination)
+{
+  unsigned triCount = indexCount / 3;
+  if(!triCount)
+    return;
+
+  //Triangles using each vertex, packed one vertex after another
+  std::vector<unsigned> remaining(vertCount, 0);
+  for(unsigned i = 0; i < triCount * 3; ++i)
+    ++remaining[indices[i]];
+
+  std::vector<unsigned> firstTri(vertCount + 1, 0);
+  for(unsigned v = 0; v < vertCount; ++v)
+    firstTri[v + 1] = firstTri[v] + remaining[v];
+
+  std::vector<unsigned> vertTris(triCount * 3);
+  std::vector<unsigned> filled(firstTri.begin(), firstTri.end() - 1);
+  for(unsigned t = 0; t < triCount; ++t)
+    for(int c = 0; c < 3; ++c)
+      vertTris[filled[indices[t * 3 + c]]++] = t;
+
+  std::vector<int> cachePosition(vertCount, -1);
+  std::vector<float> vertScore(vertCount);
+  for(unsigned v = 0; v < vertCount; ++v)
+    vertScore[v] = VertexScore(-1, remaining[v]);
+
+  std::vector<float> triScore(triCount);
+  std::vector<bool> emitted(triCount, false);
+  for(unsigned t = 0; t < triCount; ++t)
+    triScore[t] = vertScore[indices[t * 3]] + vertScore[indices[t * 3 + 1]] + vertScore[indices[t * 3 + 2]];
+
+  //Room for the cache plus the three vertices pushed in front of it
+  std::vector<int> cache, nextCache;
+  cache.reserve(VertexCacheSize + 3);
+  nextCache.reserve(VertexCacheSize + 3);
+
+  int best = -1;
+  unsigned scan = 0;
+  for(unsigned written = 0; written < triCount; ++written)
+  {
+    //Nothing in the cache leads anywhere, start again from the first triangle left
+    if(best < 0)
+    {
+      while(emitted[scan])
+        ++scan;
+      best = scan;
+    }
+
+    unsigned tri = best;
+    emitted[tri] = true;
+    const int *corners = indices + tri * 3;
+    for(int c = 0; c < 3; ++c)
+    {
+      destination[written * 3 + c] = corners[c];
+
+      //Take the triangle off its vertices' lists
+      unsigned v = corners[c];
+      unsigned *list = &vertTris[firstTri[v]];
+      unsigned count = remaining[v];
+      for(unsigned i = 0; i < count; ++i)
+      {
+        if(list[i] == tri)
+        {
+          list[i] = list[count - 1];
+          break;
+        }
+      }
+      --remaining[v];
+    }
+
+    //The triangle's vertices move to the front, the oldest entries fall out
+    nextCache.assign(corners, corners + 3);
+    for(unsigned i = 0; i < cache.size(); ++i)
+      if(cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2])
+        nextCache.push_back(cache[i]);
+    cache.swap(nextCache);
+
+    for(unsigned i = 0; i < cache.size(); ++i)
+    {
+      int v = cache[i];
+      cachePosition[v] = i < VertexCacheSize ? i : -1;
+      float score = VertexScore(cachePosition[v], remaining[v]);
+      float change = score - vertScore[v];
+      vertScore[v] = score;
+      for(unsigned t = 0; t < remaining[v]; ++t)
+        triScore[vertTris[firstTri[v] + t]] += change;
+    }
+    if(cache.size() > VertexCacheSize)
+      cache.resize(VertexCacheSize);
+
+    //Only triangles around the cache changed score, the best one is among them
+    best = -1;
+    float bestScore = -1.0f;
+    for(unsigned i = 0; i < cache.size(); ++i)
+    {
+      int v = cache[i];
+      for(unsigned t = 0; t < remaining[v]; ++t)
+      {
+        unsigned candidate = vertTris[firstTri[v] + t];
+        if(triScore[candidate] > bestScore)
+        {
+          bestScore = triScore[candidate];
+          best = candidate;
+        }
+      }
+    }
+  }
+}
+
+float AverageCacheMissRatio(const int* indices, unsigned indexCount, unsigned vertCount, unsigned cacheSize)
+{
+  unsigned triCount = indexCount / 3;
+  if(!triCount)
+    return 0.0f;
+
+  //A vertex is in the cache while fewer than cacheSize misses happened since it went in
+  std::vector<unsigned> insertedAt(vertCount, 0);
+  std::vector<bool> seen(vertCount, false);
+  unsigned misses = 0;
+  for(unsigned i = 0; i < triCount * 3; ++i)
+  {
+    int v = indices[i];
+    if(!seen[v] || misses - insertedAt[v] >= cacheSize)
+    {
+      seen[v] = true;
+      insertedAt[v] = misses;
+      ++misses;
+    }
+  }
+  return static_cast<float>(misses) / triCount;
+}
@@ -0,0 +1,23 @@
+////////////////////////////////////////////////////////
+//* Filename: VertexCache.h                           //
+//  Author: Colt Johnson                              //
+//  Info: Triangle reordering for the post transform  //
+//        vertex cache (Forsyth).                     //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+
+//Entries of the modelled cache, about what current GPUs hold
+const unsigned VertexCacheSize = 32;
+
+  //Reorders the indexCount / 3 triangles (indices below vertCount) so vertices
+  //are reused while they are still in the cache, using Tom Forsyth's linear
+  //speed scoring. Writes the new order to destination, which may not be indices.
+  void OptimizeVertexCache(const int* indices, unsigned indexCount, unsigned vertCount, int* destination);
+
+  //Average number of vertices transformed per triangle with a FIFO cache of
+  //cacheSize entries, 0.5 is about the best a regular grid can do and 3 the worst
+  float AverageCacheMissRatio(const int* indices, unsigned indexCount, unsigned vertCount,
+                              unsigned cacheSize = VertexCacheSize);
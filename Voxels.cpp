@@ -0,0 +1,233 @@
+////////////////////////////////////////////////////////
+//* Filename: Voxels.cpp                              //
+//  Author: Colt Johnson                              //
+//  Info:                                             //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#include "Voxels.h"
+#include "Bounds.h"
+#include <algorithm>
+#include <cmath>
+
+//Cells are grown by this fraction before the triangle test so anything on a
+//cell's boundary counts as touching it
+const float VoxelCellSlack = 1e-3f;
+
+const int VoxelSteps[6][3] = {{-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1}};
+
+//Projects the triangle onto axis and checks it against the box's projection
+static bool SeparatedOn(const Float3& axis, const Float3& v0, const Float3& v1, const Float3& v2, const Float3& half)
+{
+  float p0 = Dot(axis, v0);
+  float p1 = Dot(axis, v1);
+  float p2 = Dot(axis, v2);
+  float r = half.x * std::fabs(axis.x) + half.y * std::fabs(axis.y) + half.z * std::fabs(axis.z);
+  return std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r;
+}
+
+//Separating axis test of a triangle against a box centered on center (Akenine-Moller)
+static bool TriangleTouchesBox(const Float3& center, const Float3& half, Float3 v0, Float3 v1, Float3 v2)
+{
+  v0 = v0 - center;
+  v1 = v1 - center;
+  v2 = v2 - center;
+
+  Float3 edges[3] = {v1 - v0, v2 - v1, v0 - v2};
+  for(int e = 0; e < 3; ++e)
+  {
+    for(int a = 0; a < 3; ++a)
+    {
+      Float3 axis = MakeFloat3(0.0f, 0.0f, 0.0f);
+      axis[a] = 1.0f;
+      if(SeparatedOn(Cross(edges[e], axis), v0, v1, v2, half))
+        return false;
+    }
+  }
+
+  for(int a = 0; a < 3; ++a)
+  {
+    float lo = std::min(v0[a], std::min(v1[a], v2[a]));
+    float hi = std::max(v0[a], std::max(v1[a], v2[a]));
+    if(lo > half[a] || hi < -half[a])
+      return false;
+  }
+
+  return !SeparatedOn(Cross(edges[0], edges[1]), v0, v1, v2, half);
+}
+
+//Slab test of the segment from a to b against a box centered on center
+static bool SegmentTouchesBox(const Float3& center, const Float3& half, const Float3& a, const Float3& b)
+{
+  Float3 from = a - center;
+  Float3 dir = b - a;
+  float tmin = 0.0f, tmax = 1.0f;
+  for(int k = 0; k < 3; ++k)
+  {
+    if(dir[k] == 0.0f)
+    {
+      if(std::fabs(from[k]) > half[k])
+        return false;
+      continue;
+    }
+
+    float t0 = (-half[k] - from[k]) / dir[k];
+    float t1 = (half[k] - from[k]) / dir[k];
+    if(t0 > t1)
+      std::swap(t0, t1);
+    tmin = std::max(tmin, t0);
+    tmax = std::min(tmax, t1);
+    if(tmin > tmax)
+      return false;
+  }
+  return true;
+}
+
+static void MarkSurface(VoxelGrid& grid, const Float3* positions, const int* indices, unsigned indexCount)
+{
+  float halfSize = 0.5f * grid.cellSize_ * (1.0f + VoxelCellSlack);
+  Float3 half = MakeFloat3(halfSize, halfSize, halfSize);
+
+  for(unsigned i = 0; i + 2 < indexCount; i += 3)
+  {
+    const Float3& v0 = positions[indices[i]];
+    const Float3& v1 = positions[indices[i + 1]];
+    const Float3& v2 = positions[indices[i + 2]];
+
+    //The padding stays empty even where a triangle lies on the bounds, it
+    //only shares a face with the cells the mesh is in
+    int lo[3], hi[3];
+    for(int a = 0; a < 3; ++a)
+    {
+      float tmin = std::min(v0[a], std::min(v1[a], v2[a]));
+      float tmax = std::max(v0[a], std::max(v1[a], v2[a]));
+      lo[a] = std::max(1, static_cast<int>(std::floor((tmin - grid.origin_[a]) / grid.cellSize_)));
+      hi[a] = std::min(grid.dims_[a] - 2, static_cast<int>(std::floor((tmax - grid.origin_[a]) / grid.cellSize_)) + 2);
+    }
+
+    for(int z = lo[2]; z <= hi[2]; ++z)
+      for(int y = lo[1]; y <= hi[1]; ++y)
+        for(int x = lo[0]; x <= hi[0]; ++x)
+        {
+          unsigned char& cell = grid.cells_[grid.Index(x, y, z)];
+          if(cell == VoxelSurface)
+            continue;
+
+          Float3 center = grid.Corner(x, y, z) + MakeFloat3(0.5f, 0.5f, 0.5f) * grid.cellSize_;
+          if(TriangleTouchesBox(center, half, v0, v1, v2))
+            cell = VoxelSurface;
+        }
+  }
+}
+
+//Cells an open edge crosses, with the same slack as the surface
+static void MarkLeaks(const VoxelGrid& grid, const Float3* openEdges, unsigned openEdgeCount, std::vector<bool>& leaky)
+{
+  float halfSize = 0.5f * grid.cellSize_ * (1.0f + VoxelCellSlack);
+  Float3 half = MakeFloat3(halfSize, halfSize, halfSize);
+  leaky.assign(grid.cells_.size(), false);
+
+  for(unsigned e = 0; e < openEdgeCount; ++e)
+  {
+    const Float3& a = openEdges[e * 2];
+    const Float3& b = openEdges[e * 2 + 1];
+
+    int lo[3], hi[3];
+    for(int k = 0; k < 3; ++k)
+    {
+      lo[k] = std::max(1, static_cast<int>(std::floor((std::min(a[k], b[k]) - grid.origin_[k]) / grid.cellSize_)));
+      hi[k] = std::min(grid.dims_[k] - 2, static_cast<int>(std::floor((std::max(a[k], b[k]) - grid.origin_[k]) / grid.cellSize_)) + 2);
+    }
+
+    for(int z = lo[2]; z <= hi[2]; ++z)
+      for(int y = lo[1]; y <= hi[1]; ++y)
+        for(int x = lo[0]; x <= hi[0]; ++x)
+        {
+          unsigned index = grid.Index(x, y, z);
+          if(leaky[index])
+            continue;
+
+          Float3 center = grid.Corner(x, y, z) + MakeFloat3(0.5f, 0.5f, 0.5f) * grid.cellSize_;
+          if(SegmentTouchesBox(center, half, a, b))
+            leaky[index] = true;
+        }
+  }
+}
+
+//Everything reachable from the padding without crossing the surface is outside,
+//the empty cells left over are inside. Leaky surface cells are passed through
+//but stay surface.
+static unsigned FloodOutside(VoxelGrid& grid, std::vector<bool>& leaky)
+{
+  std::vector<unsigned> stack;
+  grid.cells_[0] = VoxelOutside;
+  stack.push_back(0);
+  while(!stack.empty())
+  {
+    int coords[3];
+    grid.Coords(stack.back(), coords);
+    stack.pop_back();
+
+    for(int s = 0; s < 6; ++s)
+    {
+      int n[3] = {coords[0] + VoxelSteps[s][0], coords[1] + VoxelSteps[s][1], coords[2] + VoxelSteps[s][2]};
+      if(!grid.Contains(n))
+        continue;
+
+      unsigned next = grid.Index(n[0], n[1], n[2]);
+      if(grid.cells_[next] == VoxelEmpty)
+      {
+        grid.cells_[next] = VoxelOutside;
+        stack.push_back(next);
+      }
+      else if(!leaky.empty() && leaky[next])
+      {
+        leaky[next] = false;
+        stack.push_back(next);
+      }
+    }
+  }
+
+  unsigned inside = 0;
+  for(unsigned i = 0; i < grid.cells_.size(); ++i)
+  {
+    if(grid.cells_[i] == VoxelEmpty)
+    {
+      grid.cells_[i] = VoxelInside;
+      ++inside;
+    }
+  }
+  return inside;
+}
+
+unsigned VoxelizeSolid(const Float3* positions, const int* indices, unsigned indexCount,
+                       unsigned resolution, VoxelGrid& grid,
+                       const Float3* openEdges, unsigned openEdgeCount)
+{
+  grid.cells_.clear();
+  if(indexCount < 3 || !resolution)
+    return 0;
+
+  //Only the vertices the triangles use count towards the bounds
+  Aabb bounds = EmptyAabb();
+  for(unsigned i = 0; i < indexCount; ++i)
+    Grow(bounds, positions[indices[i]]);
+
+  Float3 extent = bounds.max_ - bounds.min_;
+  float longest = std::max(extent.x, std::max(extent.y, extent.z));
+  if(!(longest > 0.0f))
+    return 0;
+
+  grid.origin_ = bounds.min_;
+  grid.cellSize_ = longest / resolution;
+  for(int a = 0; a < 3; ++a)
+    grid.dims_[a] = std::max(1, static_cast<int>(std::ceil(extent[a] / grid.cellSize_))) + 2;
+  grid.cells_.assign(grid.dims_[0] * grid.dims_[1] * grid.dims_[2], VoxelEmpty);
+
+  MarkSurface(grid, positions, indices, indexCount);
+  std::vector<bool> leaky;
+  if(openEdgeCount)
+    MarkLeaks(grid, openEdges, openEdgeCount, leaky);
+  return FloodOutside(grid, leaky);
+}
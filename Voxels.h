@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////
+//* Filename: Voxels.h                                //
+//  Author: Colt Johnson                              //
+//  Info: Solid voxelization of triangle lists, used  //
+//        by the occluder and collision stages.       //
+// Copyright 2012, Digipen Institute of Technology    //
+//                                                    //
+//////////////////////////////////////////////////////*/
+
+#pragma once
+#include <vector>
+#include "MathTypes.h"
+
+  //What VoxelizeSolid found in each cell. Users are free to store their own
+  //states past VoxelInside.
+  enum VoxelCell
+  {
+    VoxelEmpty,
+    VoxelSurface,
+    VoxelOutside,
+    VoxelInside,
+    VoxelCellStates
+  };
+
+  //The six face neighbours of a cell
+  extern const int VoxelSteps[6][3];
+
+  //The grid has a layer of padding cells all around so the outside is connected
+  struct VoxelGrid
+  {
+    Float3 origin_;
+    float cellSize_;
+    int dims_[3];
+    std::vector<unsigned char> cells_;
+
+    unsigned Index(int x, int y, int z) const { return (z * dims_[1] + y) * dims_[0] + x; }
+
+    void Coords(unsigned index, int coords[3]) const
+    {
+      coords[0] = index % dims_[0];
+      coords[1] = (index / dims_[0]) % dims_[1];
+      coords[2] = index / (dims_[0] * dims_[1]);
+    }
+
+    bool Contains(const int coords[3]) const
+    {
+      return coords[0] >= 0 && coords[1] >= 0 && coords[2] >= 0 &&
+             coords[0] < dims_[0] && coords[1] < dims_[1] && coords[2] < dims_[2];
+    }
+
+    //Cell x covers [origin_ + (x - 1) * cellSize_, origin_ + x * cellSize_)
+    Float3 Corner(int x, int y, int z) const
+    {
+      return MakeFloat3(origin_.x + (x - 1) * cellSize_, origin_.y + (y - 1) * cellSize_, origin_.z + (z - 1) * cellSize_);
+    }
+  };
+
+  //Covers the triangles with cells, resolution of them along the longest side,
+  //marks every cell a triangle touches as surface and flood fills the outside
+  //from the padding. The empty cells left are inside. Gaps in the mesh smaller
+  //than a cell are sealed, bigger ones let the outside in. The fill also goes
+  //through the surface cells crossed by openEdges (openEdgeCount pairs of end
+  //points), so a crack along them lets the outside in whatever its width.
+  //Returns the number of inside cells, grid.cells_ is left empty when the
+  //triangles are flat.
+  unsigned VoxelizeSolid(const Float3* positions, const int* indices, unsigned indexCount,
+                         unsigned resolution, VoxelGrid& grid,
+                         const Float3* openEdges = NULL, unsigned openEdgeCount = 0);